@@ -0,0 +1,188 @@
+#include "baudprober.h"
+#include <QTimer>
+#include "serialport.h"
+
+namespace {
+
+// Ctrl-U erases the shell's input line; the newline then prompts
+const char PROBE[] = "\x15\n";
+
+const double MIN_PRINTABLE = 0.95;
+
+bool isText(unsigned char c)
+{
+    return (c >= 0x20 && c < 0x7F) || c == '\r' || c == '\n' || c == '\t'
+        || c == '\b' || c == 0x1B; // ESC starts the ANSI colour codes
+}
+
+} // namespace
+
+bool BaudScore::isMatch() const
+{
+    if (!error.isEmpty()) {
+        return false;
+    }
+    return prompts > 0 || (bytes >= BaudProber::MIN_SAMPLE_BYTES && printable >= MIN_PRINTABLE);
+}
+
+BaudProber::BaudProber(QObject *parent)
+    : QObject(parent)
+    , m_port(new SerialPort(this))
+    , m_timer(new QTimer(this))
+    , m_textBytes(0)
+    , m_promptBase(0)
+    , m_next(0)
+    , m_detected(0)
+    , m_elapsedMs(0)
+    , m_running(false)
+{
+    DeviceProfile profile;
+    profile.chunkSize = 0;
+    profile.interChunkDelayMs = 0;
+    profile.postWriteDelayMs = 0;
+    m_port->setDeviceProfile(profile);
+
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &BaudProber::endSample);
+    connect(m_port, &SerialDevice::dataReceived, this, &BaudProber::readSample);
+}
+
+BaudProber::~BaudProber()
+{
+    m_port->close();
+}
+
+void BaudProber::probe(const QString &readPort, const QString &writePort, const QList<int> &baudRates)
+{
+    abort();
+    m_readPort = readPort;
+    m_writePort = writePort;
+    m_baudRates = baudRates;
+    m_scores.clear();
+    m_next = 0;
+    m_detected = 0;
+    m_running = true;
+    m_clock.start();
+    tryNext();
+}
+
+void BaudProber::abort()
+{
+    m_timer->stop();
+    m_port->close();
+    m_running = false;
+}
+
+bool BaudProber::isRunning() const
+{
+    return m_running;
+}
+
+int BaudProber::detectedBaudRate() const
+{
+    return m_detected;
+}
+
+QList<BaudScore> BaudProber::scores() const
+{
+    return m_scores;
+}
+
+qint64 BaudProber::elapsedMs() const
+{
+    return m_running ? m_clock.elapsed() : m_elapsedMs;
+}
+
+QList<int> BaudProber::candidateRates(int preferred)
+{
+    QList<int> rates = { 115200, 1000000, 921600, 460800, 230400, 57600, 38400, 19200, 9600 };
+    if (preferred > 0) {
+        rates.removeAll(preferred);
+        rates.prepend(preferred);
+    }
+    return rates;
+}
+
+void BaudProber::tryNext()
+{
+    if (m_next >= m_baudRates.size()) {
+        finish();
+        return;
+    }
+
+    m_current = BaudScore();
+    m_current.baudRate = m_baudRates[m_next++];
+    m_textBytes = 0;
+    m_pipeline.reset();
+    // The parser's prompt count runs on across reset()
+    m_promptBase = m_pipeline.parser().promptCount();
+
+    const bool opened = m_writePort.isEmpty()
+        ? m_port->open(m_readPort, m_current.baudRate)
+        : m_port->openDual(m_readPort, m_writePort, m_current.baudRate);
+    if (!opened) {
+        m_current.error = m_port->errorString();
+        m_scores.append(m_current);
+        m_timer->start(0); // On to the next rate
+        return;
+    }
+
+    m_port->enqueue(QByteArray(PROBE));
+    m_timer->start(SAMPLE_MS);
+}
+
+void BaudProber::readSample()
+{
+    if (!m_running || !m_port->isOpen()) {
+        return;
+    }
+
+    const QByteArray data = m_port->read(SerialPort::RX_RING_SIZE);
+    for (const char c : data) {
+        if (isText(static_cast<unsigned char>(c))) {
+            ++m_textBytes;
+        }
+    }
+    m_current.bytes += data.size();
+
+    QStringList logLines;
+    QStringList commandLines;
+    m_pipeline.feed(data, logLines, commandLines);
+    m_current.logLines += logLines.size();
+
+    // A prompt is proof enough; don't wait out the sample
+    const quint64 prompts = m_pipeline.parser().promptCount() - m_promptBase;
+    if (m_current.prompts == 0 && prompts > 0) {
+        m_current.prompts = prompts;
+        m_timer->start(0);
+    }
+}
+
+void BaudProber::endSample()
+{
+    if (!m_current.error.isEmpty()) {
+        tryNext(); // Scored when the open failed
+        return;
+    }
+
+    m_port->close();
+    m_current.prompts = m_pipeline.parser().promptCount() - m_promptBase;
+    m_current.printable = m_current.bytes > 0 ? double(m_textBytes) / double(m_current.bytes) : 0.0;
+    m_scores.append(m_current);
+
+    if (m_current.isMatch()) {
+        m_detected = m_current.baudRate;
+        finish();
+        return;
+    }
+    tryNext();
+}
+
+void BaudProber::finish()
+{
+    m_timer->stop();
+    m_port->close();
+    m_running = false;
+    m_elapsedMs = m_clock.elapsed();
+    emit finished();
+}
@@ -0,0 +1,88 @@
+#ifndef BAUDPROBER_H
+#define BAUDPROBER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include "rxpipeline.h"
+
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
+class SerialPort;
+
+// What one candidate rate produced
+struct BaudScore
+{
+    int baudRate = 0;
+    qint64 bytes = 0;
+    double printable = 0.0;  // Share of bytes that are text, 0..1
+    quint64 prompts = 0;
+    int logLines = 0;
+    QString error;           // The port refused the rate
+
+    // A prompt settles it; otherwise enough clean text to rule out
+    // the garbage a wrong rate decodes to
+    bool isMatch() const;
+};
+
+// Finds the rate a device's UART runs at. Each candidate rate gets the
+// port reopened, a Ctrl-U and newline (clearing whatever junk earlier
+// rates typed into the shell, then asking for a prompt) and SAMPLE_MS of
+// listening; received bytes are scored for printable text, shell prompts
+// and Zephyr log lines. The first matching rate wins, and a prompt ends
+// its sample early, so the usual rate listed first costs one round trip.
+class BaudProber : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BaudProber(QObject *parent = nullptr);
+    ~BaudProber();
+
+    // writePort as for SerialPort::openDual(), or empty for one port
+    void probe(const QString &readPort, const QString &writePort, const QList<int> &baudRates);
+    void abort();
+    bool isRunning() const;
+
+    // 0 if no rate matched
+    int detectedBaudRate() const;
+    QList<BaudScore> scores() const;
+    qint64 elapsedMs() const;
+
+    // Common rates, the stock 115200 first, then the high-speed ones;
+    // preferred (e.g. the last rate found) goes to the front
+    static QList<int> candidateRates(int preferred = 0);
+
+    static const int SAMPLE_MS = 250;
+    static const int MIN_SAMPLE_BYTES = 16;
+
+signals:
+    void finished();
+
+private:
+    void tryNext();
+    void readSample();
+    void endSample();
+    void finish();
+
+    SerialPort *m_port;
+    QTimer *m_timer;
+    RxPipeline m_pipeline;
+    QString m_readPort;
+    QString m_writePort;
+    QList<int> m_baudRates;
+    QList<BaudScore> m_scores;
+    BaudScore m_current;
+    qint64 m_textBytes;      // Printable bytes in the current sample
+    quint64 m_promptBase;    // Parser prompt count when the sample began
+    int m_next;              // Index into m_baudRates
+    int m_detected;
+    QElapsedTimer m_clock;
+    qint64 m_elapsedMs;
+    bool m_running;
+};
+
+#endif // BAUDPROBER_H
@@ -0,0 +1,129 @@
+// Replays captured device output through the scanner and the regex
+// formulation of LogClassifier, checks that both make the same decision
+// for every line and reports lines/second for each.
+//
+// Usage: bench_classifier [capture files...]
+// Without arguments a small built-in corpus is used.
+
+#include "logclassifier.h"
+#include "streamlineparser.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStringList>
+#include <cstdio>
+
+namespace {
+
+const char *const builtinCorpus =
+    "\x1b[1;32muart:~$ \x1b[m\r\n"
+    "[00:00:01.234,567] <inf> app: Booting nRF9160\r\n"
+    "[00:00:01.250,000] <inf> lte: Connecting to LTE network\r\n"
+    "[00:00:05.812,731] <wrn> mqtt: Broker not reachable, retrying\r\n"
+    "[00:00:06.001,002] <err> gnss: No fix since 120 s\r\n"
+    "[12:34:56] Thread started\r\n"
+    "config get mqtt_broker\r\n"
+    "mqtt_broker = broker.example.com\r\n"
+    "Available commands:\r\n"
+    "  help   :Prints the help message.\r\n"
+    "  config :Configuration commands\r\n"
+    "[01.04\r\n"
+    "nf> Connected\r\n"
+    "w \r\n"
+    "x\r\n"
+    "login>\r\n"
+    "dev> \r\n"
+    "Publishing 128 bytes took 35 ms\r\n"
+    "Key slot 3 written successfully\r\n";
+
+QStringList loadLines(const QStringList &files)
+{
+    StreamLineParser parser;
+    QStringList lines;
+
+    if (files.isEmpty()) {
+        parser.feed(QByteArray(builtinCorpus), lines);
+    }
+    for (const QString &fileName : files) {
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly)) {
+            fprintf(stderr, "Cannot open %s\n", qPrintable(fileName));
+            continue;
+        }
+        parser.feed(file.readAll(), lines);
+    }
+    parser.flush(lines);
+    return lines;
+}
+
+template <typename Classify>
+double linesPerSecond(const QStringList &lines, int rounds, Classify classify)
+{
+    int sink = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for (int round = 0; round < rounds; ++round) {
+        for (const QString &line : lines) {
+            sink += classify(line);
+        }
+    }
+    const qint64 elapsedNs = qMax<qint64>(timer.nsecsElapsed(), 1);
+    if (sink == -1) {
+        fprintf(stderr, "\n"); // Keeps the loop from being optimized away
+    }
+    return double(lines.size()) * rounds * 1e9 / elapsedNs;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QStringList files;
+    for (int i = 1; i < argc; ++i) {
+        files.append(QString::fromLocal8Bit(argv[i]));
+    }
+
+    const QStringList lines = loadLines(files);
+    if (lines.isEmpty()) {
+        fprintf(stderr, "No lines to classify\n");
+        return 1;
+    }
+
+    LogClassifier classifier;
+
+    int mismatches = 0;
+    for (const QString &line : lines) {
+        const LogClassifier::Rule logRule = classifier.logRule(line);
+        const LogClassifier::Rule corruptedRule = classifier.corruptedRule(line);
+        const LogClassifier::Rule regexLogRule = classifier.regexLogRule(line);
+        const LogClassifier::Rule regexCorruptedRule = classifier.regexCorruptedRule(line);
+        if (logRule != regexLogRule || corruptedRule != regexCorruptedRule) {
+            fprintf(stderr, "Mismatch on \"%s\": scanner %s/%s, regex %s/%s\n",
+                    qPrintable(line),
+                    qPrintable(LogClassifier::ruleName(logRule)),
+                    qPrintable(LogClassifier::ruleName(corruptedRule)),
+                    qPrintable(LogClassifier::ruleName(regexLogRule)),
+                    qPrintable(LogClassifier::ruleName(regexCorruptedRule)));
+            ++mismatches;
+        }
+    }
+
+    // Aim for a few million classifications per engine
+    const int rounds = qMax(1, int(2000000 / lines.size()));
+
+    const double regexRate = linesPerSecond(lines, rounds, [&](const QString &line) {
+        return classifier.regexLogRule(line) + classifier.regexCorruptedRule(line);
+    });
+    const double scannerRate = linesPerSecond(lines, rounds, [&](const QString &line) {
+        return classifier.logRule(line) + classifier.corruptedRule(line);
+    });
+
+    printf("%lld lines x %d rounds\n", static_cast<long long>(lines.size()), rounds);
+    printf("regex:   %12.0f lines/s\n", regexRate);
+    printf("scanner: %12.0f lines/s (%.1fx)\n", scannerRate, scannerRate / regexRate);
+
+    if (mismatches > 0) {
+        fprintf(stderr, "%d lines classified differently\n", mismatches);
+        return 1;
+    }
+    return 0;
+}
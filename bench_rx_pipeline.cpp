@@ -0,0 +1,321 @@
+// Drives byte streams through the receive path the way MainWindow does:
+// RxPipeline (StreamLineParser decoding, ANSI removal and prompt filtering,
+// long line splitting, LogClassifier) and the LogStore history. Reports bytes/s,
+// lines/s, heap allocations per line, p50/p99 latency per chunk and how long
+// a level and a module filter over the stored history take.
+//
+// Usage: bench_rx_pipeline [--chunk bytes] [--lines n] [files...]
+// Files ending in .cap replay their RX records as recorded; other files
+// are read as raw terminal output and cut into --chunk sized reads.
+// Without files a synthetic stream of --lines lines is generated.
+
+#include "capturefile.h"
+#include "logstore.h"
+#include "rxpipeline.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <new>
+#include <vector>
+
+namespace {
+
+std::atomic<quint64> allocationCount(0);
+
+} // namespace
+
+// Count every heap allocation. Qt containers allocate with malloc, so on
+// glibc malloc itself is wrapped; elsewhere only operator new is seen.
+#if defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+
+void *malloc(size_t size) noexcept
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) noexcept
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) noexcept
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+}
+const bool countsMalloc = true;
+#else
+void *operator new(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+const bool countsMalloc = false;
+#endif
+
+namespace {
+
+// Same limits as MainWindow
+const qsizetype MAX_ACCUMULATED_SIZE = 65536;
+const int MAX_LINE_LENGTH = 8192;
+const qsizetype MAX_LOG_LINES = 1000000;
+const qsizetype MAX_COMMAND_LINES = 100000;
+
+// RxPipeline plus the joins and stores MainWindow::dispatchLines() feeds
+class Pipeline
+{
+public:
+    Pipeline()
+        : m_rx(MAX_ACCUMULATED_SIZE, MAX_LINE_LENGTH)
+        , m_logStore(MAX_LOG_LINES)
+        , m_commandStore(MAX_COMMAND_LINES)
+        , m_lines(0)
+        , m_logLines(0)
+    {
+    }
+
+    void process(const char *data, qsizetype size, qint64 hostTimeMs)
+    {
+        QStringList logLines, commandLines;
+        m_rx.feed(data, size, logLines, commandLines);
+        store(logLines, commandLines, hostTimeMs);
+    }
+
+    void finish(qint64 hostTimeMs)
+    {
+        QStringList logLines, commandLines;
+        m_rx.flush(logLines, commandLines);
+        store(logLines, commandLines, hostTimeMs);
+    }
+
+    quint64 lines() const { return m_lines; }
+    quint64 logLines() const { return m_logLines; }
+    const LogStore &logStore() const { return m_logStore; }
+
+private:
+    void store(const QStringList &logLines, const QStringList &commandLines, qint64 hostTimeMs)
+    {
+        m_lines += quint64(logLines.size() + commandLines.size());
+        m_logLines += quint64(logLines.size());
+
+        // Joined and re-split like logMessage() -> LogListModel::append()
+        if (!logLines.isEmpty()) {
+            const QString text = logLines.join('\n');
+            for (QStringView line : QStringView(text).tokenize(u'\n')) {
+                m_logStore.append(line, hostTimeMs);
+            }
+        }
+        if (!commandLines.isEmpty()) {
+            const QString text = commandLines.join('\n');
+            for (QStringView line : QStringView(text).tokenize(u'\n')) {
+                m_commandStore.append(line, hostTimeMs);
+            }
+        }
+    }
+
+    RxPipeline m_rx;
+    LogStore m_logStore;
+    LogStore m_commandStore;
+    quint64 m_lines;
+    quint64 m_logLines;
+};
+
+// Device-like output: coloured Zephyr logs, prompts, command replies,
+// the occasional line interleaved mid-way and a rare oversized line
+QByteArray syntheticStream(int lineCount)
+{
+    static const char *const levels[] = { "inf", "inf", "inf", "dbg", "wrn", "err" };
+    static const char *const modules[] = { "app", "lte_lc", "mqtt_helper", "gnss", "modem" };
+
+    QRandomGenerator random(42);
+    QByteArray stream;
+    stream.reserve(qsizetype(lineCount) * 80);
+
+    for (int i = 0; i < lineCount; ++i) {
+        const int kind = int(random.bounded(100));
+        if (kind < 70) {
+            const int level = int(random.bounded(int(std::size(levels))));
+            const char *color = level == 5 ? "\x1b[1;31m" : level == 4 ? "\x1b[1;33m" : "";
+            stream += color;
+            stream += QByteArray("[00:") + QByteArray::number(10 + i / 60000 % 50) + ':'
+                + QByteArray::number(10 + i / 1000 % 50) + '.' + QByteArray::number(100 + i % 900)
+                + ",123] <" + levels[level] + "> " + modules[random.bounded(int(std::size(modules)))]
+                + ": Sample message " + QByteArray::number(i) + " value=" + QByteArray::number(random.bounded(100000));
+            stream += *color ? "\x1b[0m\r\n" : "\r\n";
+        } else if (kind < 80) {
+            stream += "\x1b[1;32muart:~$ \x1b[m";
+        } else if (kind < 95) {
+            stream += "mqtt_broker = broker.example.com port " + QByteArray::number(i) + "\r\n";
+        } else if (kind < 99) {
+            // A log line cut into by a reply, as seen when the shell interleaves
+            stream += "[00:00:01.2" + QByteArray::number(i % 10) + "Key slot written\r\n";
+        } else {
+            stream += QByteArray(MAX_LINE_LENGTH + 100, 'x') + "\r\n";
+        }
+    }
+    return stream;
+}
+
+void appendChunks(const QByteArray &data, qsizetype chunkSize, QList<QByteArray> &chunks)
+{
+    for (qsizetype offset = 0; offset < data.size(); offset += chunkSize) {
+        chunks.append(data.mid(offset, chunkSize));
+    }
+}
+
+bool loadFile(const QString &fileName, qsizetype chunkSize, QList<QByteArray> &chunks)
+{
+    if (fileName.endsWith(".cap", Qt::CaseInsensitive)) {
+        CaptureReader reader;
+        QString error;
+        if (!reader.open(fileName, &error)) {
+            fprintf(stderr, "%s\n", qPrintable(error));
+            return false;
+        }
+        for (CaptureReader::Record record = reader.first(); record.offset >= 0; record = reader.next(record)) {
+            if (record.direction == Capture::Rx) {
+                chunks.append(QByteArray(record.data, record.size));
+            }
+        }
+        return true;
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "Cannot open %s\n", qPrintable(fileName));
+        return false;
+    }
+    appendChunks(file.readAll(), chunkSize, chunks);
+    return true;
+}
+
+double percentile(const std::vector<qint64> &sorted, double fraction)
+{
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const size_t index = qMin(sorted.size() - 1, size_t(fraction * double(sorted.size())));
+    return double(sorted[index]);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    qsizetype chunkSize = 256;
+    int lineCount = 200000;
+    QStringList files;
+    for (int i = 1; i < argc; ++i) {
+        const QByteArray arg = argv[i];
+        if (arg == "--chunk" && i + 1 < argc) {
+            chunkSize = qMax(1, atoi(argv[++i]));
+        } else if (arg == "--lines" && i + 1 < argc) {
+            lineCount = qMax(1, atoi(argv[++i]));
+        } else if (arg.startsWith("--")) {
+            fprintf(stderr, "Usage: bench_rx_pipeline [--chunk bytes] [--lines n] [files...]\n");
+            return 2;
+        } else {
+            files.append(QString::fromLocal8Bit(arg));
+        }
+    }
+
+    QList<QByteArray> chunks;
+    if (files.isEmpty()) {
+        appendChunks(syntheticStream(lineCount), chunkSize, chunks);
+    }
+    for (const QString &fileName : files) {
+        if (!loadFile(fileName, chunkSize, chunks)) {
+            return 1;
+        }
+    }
+    if (chunks.isEmpty()) {
+        fprintf(stderr, "No input\n");
+        return 1;
+    }
+
+    qint64 totalBytes = 0;
+    for (const QByteArray &chunk : chunks) {
+        totalBytes += chunk.size();
+    }
+
+    // Reserved up front so the measurement itself allocates nothing
+    std::vector<qint64> latencies;
+    latencies.reserve(size_t(chunks.size()));
+
+    Pipeline pipeline;
+    QElapsedTimer total;
+    QElapsedTimer chunkTimer;
+
+    const quint64 allocationsBefore = allocationCount.load();
+    total.start();
+    for (const QByteArray &chunk : chunks) {
+        chunkTimer.start();
+        pipeline.process(chunk.constData(), chunk.size(), 0);
+        latencies.push_back(chunkTimer.nsecsElapsed());
+    }
+    pipeline.finish(0);
+    const qint64 elapsedNs = qMax<qint64>(total.nsecsElapsed(), 1);
+    const quint64 allocations = allocationCount.load() - allocationsBefore;
+
+    std::sort(latencies.begin(), latencies.end());
+    const double seconds = double(elapsedNs) / 1e9;
+    const quint64 lines = qMax<quint64>(pipeline.lines(), 1);
+
+    printf("%lld chunks, %lld bytes, %llu lines (%llu log)\n",
+           static_cast<long long>(chunks.size()), static_cast<long long>(totalBytes),
+           static_cast<unsigned long long>(pipeline.lines()),
+           static_cast<unsigned long long>(pipeline.logLines()));
+    printf("throughput:  %10.1f MB/s  %12.0f lines/s\n",
+           double(totalBytes) / 1e6 / seconds, double(pipeline.lines()) / seconds);
+    printf("allocations: %10.2f per line (%s)\n",
+           double(allocations) / double(lines), countsMalloc ? "malloc" : "operator new only");
+    printf("chunk latency: p50 %.1f us  p99 %.1f us  max %.1f us\n",
+           percentile(latencies, 0.50) / 1e3, percentile(latencies, 0.99) / 1e3,
+           double(latencies.back()) / 1e3);
+    printf("log store:   %lld records, %.1f MB\n",
+           static_cast<long long>(pipeline.logStore().size()),
+           double(pipeline.logStore().memoryUsage()) / 1e6);
+
+    // What the terminal's level/module filter costs over the whole history
+    const LogStore &store = pipeline.logStore();
+    const quint32 warnings = LogStore::levelBit(LogStore::Warning) | LogStore::levelBit(LogStore::Error);
+    QElapsedTimer filterTimer;
+    filterTimer.start();
+    const qsizetype levelMatches = store.filter(warnings).size();
+    const qint64 levelNs = filterTimer.nsecsElapsed();
+    const int moduleId = qMax(store.findModule("mqtt_helper"), 0);
+    filterTimer.start();
+    const qsizetype moduleMatches = store.filter(LogStore::AllLevels, moduleId).size();
+    const qint64 moduleNs = filterTimer.nsecsElapsed();
+    printf("filter:      warnings+errors %lld in %.1f us, module %s %lld in %.1f us\n",
+           static_cast<long long>(levelMatches), double(levelNs) / 1e3,
+           qPrintable(store.moduleName(moduleId)), static_cast<long long>(moduleMatches),
+           double(moduleNs) / 1e3);
+    return 0;
+}
@@ -0,0 +1,363 @@
+#include "capturefile.h"
+#include <QDateTime>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+const char MAGIC[8] = { 'C', 'F', 'G', 'C', 'A', 'P', '0', '1' };
+const qsizetype FLUSH_SIZE = 1024 * 1024;
+const qint64 FLUSH_INTERVAL_NS = qint64(CaptureWriter::FLUSH_INTERVAL_MS) * 1000000;
+
+Capture::IndexEntry makeIndexEntry(quint64 timeNs, quint64 offset)
+{
+    Capture::IndexEntry entry;
+    entry.timeNs = qToLittleEndian(timeNs);
+    entry.offset = qToLittleEndian(offset);
+    return entry;
+}
+
+} // namespace
+
+CaptureWriter::CaptureWriter()
+    : m_offset(0)
+    , m_nextIndexOffset(0)
+    , m_lastFlushNs(0)
+    , m_bytesCaptured(0)
+{
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    close();
+}
+
+bool CaptureWriter::open(const QString &fileName, QString *error)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        *error = QString("Failed to create %1: %2").arg(fileName, m_file.errorString());
+        return false;
+    }
+    m_indexFile.setFileName(Capture::indexFileName(fileName));
+    if (!m_indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        *error = QString("Failed to create %1: %2").arg(m_indexFile.fileName(), m_indexFile.errorString());
+        m_file.close();
+        return false;
+    }
+
+    Capture::FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = qToLittleEndian(Capture::VERSION);
+    header.headerSize = qToLittleEndian(quint32(sizeof(header)));
+    header.startEpochUs = qToLittleEndian(QDateTime::currentMSecsSinceEpoch() * 1000);
+
+    m_buffer.clear();
+    m_buffer.reserve(FLUSH_SIZE + 4096);
+    m_buffer.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    m_indexBuffer.clear();
+    m_offset = sizeof(header);
+    m_nextIndexOffset = m_offset;
+    m_bytesCaptured = 0;
+    m_clock.start();
+    m_lastFlushNs = 0;
+    return true;
+}
+
+void CaptureWriter::close()
+{
+    if (m_file.isOpen()) {
+        flush();
+        m_file.close();
+        m_indexFile.close();
+    }
+}
+
+bool CaptureWriter::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+void CaptureWriter::append(Capture::Direction direction, const char *data, qint64 size)
+{
+    if (!m_file.isOpen() || size <= 0) {
+        return;
+    }
+
+    const quint64 timeNs = quint64(m_clock.nsecsElapsed());
+    if (m_offset >= m_nextIndexOffset) {
+        const Capture::IndexEntry entry = makeIndexEntry(timeNs, quint64(m_offset));
+        m_indexBuffer.append(reinterpret_cast<const char *>(&entry), sizeof(entry));
+        m_nextIndexOffset = m_offset + Capture::INDEX_INTERVAL;
+    }
+
+    Capture::RecordHeader header;
+    memset(&header, 0, sizeof(header));
+    header.timeNs = qToLittleEndian(timeNs);
+    header.size = qToLittleEndian(quint32(size));
+    header.direction = direction;
+
+    const qint64 padding = Capture::paddedSize(size) - size;
+    m_buffer.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    m_buffer.append(data, size);
+    m_buffer.append(padding, '\0');
+    m_offset += qint64(sizeof(header)) + size + padding;
+    m_bytesCaptured += quint64(size);
+
+    if (m_buffer.size() >= FLUSH_SIZE) {
+        flush();
+    } else {
+        flushIfDue();
+    }
+}
+
+void CaptureWriter::flushIfDue()
+{
+    if (m_file.isOpen() && (!m_buffer.isEmpty() || !m_indexBuffer.isEmpty())
+        && m_clock.nsecsElapsed() - m_lastFlushNs >= FLUSH_INTERVAL_NS) {
+        flush();
+    }
+}
+
+void CaptureWriter::flush()
+{
+    m_lastFlushNs = m_clock.nsecsElapsed();
+    // Data first, so the index never points past what is on disk
+    if (!m_buffer.isEmpty()) {
+        m_file.write(m_buffer);
+        m_file.flush();
+        m_buffer.truncate(0);
+    }
+    if (!m_indexBuffer.isEmpty()) {
+        m_indexFile.write(m_indexBuffer);
+        m_indexFile.flush();
+        m_indexBuffer.truncate(0);
+    }
+}
+
+QString CaptureWriter::fileName() const
+{
+    return m_file.fileName();
+}
+
+quint64 CaptureWriter::bytesCaptured() const
+{
+    return m_bytesCaptured;
+}
+
+CaptureReader::CaptureReader()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_startEpochUs(0)
+    , m_index(nullptr)
+    , m_indexCount(0)
+    , m_lastTimeNs(0)
+{
+}
+
+CaptureReader::~CaptureReader()
+{
+    close();
+}
+
+bool CaptureReader::open(const QString &fileName, QString *error)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        *error = QString("Failed to open %1: %2").arg(fileName, m_file.errorString());
+        return false;
+    }
+
+    m_size = m_file.size();
+    Capture::FileHeader header;
+    if (m_size < qint64(sizeof(header))) {
+        *error = QString("%1 is not a capture file").arg(fileName);
+        close();
+        return false;
+    }
+
+    // The whole file is mapped; the OS pages in only what is touched
+    m_data = m_file.map(0, m_size);
+    if (!m_data) {
+        *error = QString("Failed to map %1: %2").arg(fileName, m_file.errorString());
+        close();
+        return false;
+    }
+
+    memcpy(&header, m_data, sizeof(header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+        || qFromLittleEndian(header.version) != Capture::VERSION
+        || qFromLittleEndian(header.headerSize) != sizeof(header)) {
+        *error = QString("%1 is not a supported capture file").arg(fileName);
+        close();
+        return false;
+    }
+    m_startEpochUs = qFromLittleEndian(header.startEpochUs);
+
+    m_indexFile.setFileName(Capture::indexFileName(fileName));
+    if (m_indexFile.open(QIODevice::ReadOnly) && m_indexFile.size() >= qint64(sizeof(Capture::IndexEntry))) {
+        m_indexCount = m_indexFile.size() / qint64(sizeof(Capture::IndexEntry));
+        m_index = reinterpret_cast<const Capture::IndexEntry *>(
+            m_indexFile.map(0, m_indexCount * qint64(sizeof(Capture::IndexEntry))));
+    }
+    // Drop entries past a truncated capture
+    while (m_index && m_indexCount > 0
+           && qint64(qFromLittleEndian(m_index[m_indexCount - 1].offset)) >= m_size) {
+        --m_indexCount;
+    }
+    // The writer flushes data before the index, so after a crash the index
+    // usually stops short of the data; index the rest
+    if (!m_index || m_indexCount == 0
+        || m_size - qint64(qFromLittleEndian(m_index[m_indexCount - 1].offset)) > Capture::INDEX_INTERVAL) {
+        buildIndex();
+    }
+
+    // Duration: walk from the last indexed record to the end
+    m_lastTimeNs = 0;
+    Record record = recordAt(qint64(qFromLittleEndian(m_index[m_indexCount - 1].offset)));
+    for (; record.offset >= 0; record = next(record)) {
+        m_lastTimeNs = record.timeNs;
+    }
+    return true;
+}
+
+void CaptureReader::close()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+        m_data = nullptr;
+    }
+    if (m_index && m_builtIndex.isEmpty()) {
+        m_indexFile.unmap(reinterpret_cast<uchar *>(const_cast<Capture::IndexEntry *>(m_index)));
+    }
+    m_index = nullptr;
+    m_indexCount = 0;
+    m_builtIndex.clear();
+    m_indexFile.close();
+    m_file.close();
+    m_size = 0;
+}
+
+bool CaptureReader::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+qint64 CaptureReader::startEpochUs() const
+{
+    return m_startEpochUs;
+}
+
+quint64 CaptureReader::durationNs() const
+{
+    return m_lastTimeNs;
+}
+
+qint64 CaptureReader::fileSize() const
+{
+    return m_size;
+}
+
+CaptureReader::Record CaptureReader::first() const
+{
+    return recordAt(sizeof(Capture::FileHeader));
+}
+
+CaptureReader::Record CaptureReader::next(const Record &record) const
+{
+    if (record.offset < 0) {
+        return Record();
+    }
+    return recordAt(record.offset + qint64(sizeof(Capture::RecordHeader))
+                    + Capture::paddedSize(record.size));
+}
+
+CaptureReader::Record CaptureReader::seek(quint64 timeNs) const
+{
+    if (!m_data) {
+        return Record();
+    }
+
+    // Last index entry at or before timeNs
+    qint64 low = 0;
+    qint64 high = m_indexCount;
+    while (low < high) {
+        const qint64 mid = low + (high - low) / 2;
+        if (qFromLittleEndian(m_index[mid].timeNs) <= timeNs) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    // At most INDEX_INTERVAL bytes to scan from there
+    Record record = low == 0 ? first()
+                             : recordAt(qint64(qFromLittleEndian(m_index[low - 1].offset)));
+    while (record.offset >= 0 && record.timeNs < timeNs) {
+        record = next(record);
+    }
+    return record;
+}
+
+CaptureReader::Record CaptureReader::recordAt(qint64 offset) const
+{
+    Record record;
+    if (!m_data || offset < 0 || offset + qint64(sizeof(Capture::RecordHeader)) > m_size) {
+        return record;
+    }
+
+    Capture::RecordHeader header;
+    memcpy(&header, m_data + offset, sizeof(header));
+    const qint64 size = qFromLittleEndian(header.size);
+    if (offset + qint64(sizeof(header)) + size > m_size) {
+        return record; // Truncated tail, e.g. the app died mid-capture
+    }
+
+    record.offset = offset;
+    record.timeNs = qFromLittleEndian(header.timeNs);
+    record.direction = header.direction == Capture::Tx ? Capture::Tx : Capture::Rx;
+    record.data = reinterpret_cast<const char *>(m_data) + offset + sizeof(header);
+    record.size = size;
+    return record;
+}
+
+void CaptureReader::buildIndex()
+{
+    // Same spacing the writer uses, carrying on from the entries the
+    // sidecar has
+    m_builtIndex.clear();
+    qint64 nextIndexOffset = 0;
+    Record record = first();
+    if (m_index) {
+        m_builtIndex.append(reinterpret_cast<const char *>(m_index),
+                            m_indexCount * qint64(sizeof(Capture::IndexEntry)));
+        m_indexFile.unmap(reinterpret_cast<uchar *>(const_cast<Capture::IndexEntry *>(m_index)));
+        m_index = nullptr;
+        if (m_indexCount > 0) {
+            Capture::IndexEntry last;
+            memcpy(&last, m_builtIndex.constData() + m_builtIndex.size() - sizeof(last), sizeof(last));
+            const qint64 lastOffset = qint64(qFromLittleEndian(last.offset));
+            record = next(recordAt(lastOffset));
+            nextIndexOffset = lastOffset + Capture::INDEX_INTERVAL;
+        }
+    }
+    for (; record.offset >= 0; record = next(record)) {
+        if (record.offset >= nextIndexOffset) {
+            const Capture::IndexEntry entry = makeIndexEntry(record.timeNs, quint64(record.offset));
+            m_builtIndex.append(reinterpret_cast<const char *>(&entry), sizeof(entry));
+            nextIndexOffset = record.offset + Capture::INDEX_INTERVAL;
+        }
+    }
+    if (m_builtIndex.isEmpty()) {
+        // Header only; one entry pointing at the (absent) first record
+        const Capture::IndexEntry entry = makeIndexEntry(0, sizeof(Capture::FileHeader));
+        m_builtIndex.append(reinterpret_cast<const char *>(&entry), sizeof(entry));
+    }
+    m_index = reinterpret_cast<const Capture::IndexEntry *>(m_builtIndex.constData());
+    m_indexCount = m_builtIndex.size() / qint64(sizeof(Capture::IndexEntry));
+}
@@ -0,0 +1,152 @@
+#ifndef CAPTUREFILE_H
+#define CAPTUREFILE_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+#include <QtGlobal>
+
+// Raw serial capture format (.cap), all integers little-endian:
+//
+//   FileHeader                       32 bytes
+//   { RecordHeader, payload, pad } * every record 8-byte aligned
+//
+// Records carry a nanosecond timestamp relative to the start of the
+// capture, so a file can be mapped and walked in place. Every
+// INDEX_INTERVAL bytes the writer appends an IndexEntry (time, offset) to
+// the sidecar <file>.idx; a reader binary-searches it to seek by time and
+// rebuilds it by scanning when it is missing, or extends it when it stops
+// short of the data.
+namespace Capture {
+
+enum Direction : quint8 {
+    Rx = 0,
+    Tx = 1
+};
+
+struct FileHeader
+{
+    char magic[8];         // "CFGCAP01"
+    quint32 version;
+    quint32 headerSize;
+    qint64 startEpochUs;   // Wall-clock time of timestamp 0
+    quint64 reserved;
+};
+
+struct RecordHeader
+{
+    quint64 timeNs;        // Since the start of the capture
+    quint32 size;          // Payload bytes, excluding padding
+    quint8 direction;
+    quint8 reserved[3];
+};
+
+struct IndexEntry
+{
+    quint64 timeNs;
+    quint64 offset;        // File offset of a RecordHeader
+};
+
+static_assert(sizeof(FileHeader) == 32, "FileHeader layout");
+static_assert(sizeof(RecordHeader) == 16, "RecordHeader layout");
+static_assert(sizeof(IndexEntry) == 16, "IndexEntry layout");
+
+const quint32 VERSION = 1;
+const qint64 INDEX_INTERVAL = 64 * 1024;
+
+inline qint64 paddedSize(qint64 size)
+{
+    return (size + 7) & ~qint64(7);
+}
+
+inline QString indexFileName(const QString &captureFileName)
+{
+    return captureFileName + ".idx";
+}
+
+} // namespace Capture
+
+// Appends records to a capture file. Not thread-safe: SerialPort only
+// touches it from its I/O thread. Records are gathered in memory and
+// written in large blocks, or after a second at the latest as long as the
+// owner calls flushIfDue() every FLUSH_INTERVAL_MS on an idle link.
+class CaptureWriter
+{
+public:
+    CaptureWriter();
+    ~CaptureWriter();
+
+    bool open(const QString &fileName, QString *error);
+    void close();
+    bool isOpen() const;
+
+    void append(Capture::Direction direction, const char *data, qint64 size);
+    void flush();
+    // Flushes if anything has been buffered for FLUSH_INTERVAL_MS
+    void flushIfDue();
+
+    static const int FLUSH_INTERVAL_MS = 1000;
+
+    QString fileName() const;
+    quint64 bytesCaptured() const;
+
+private:
+    QFile m_file;
+    QFile m_indexFile;
+    QByteArray m_buffer;
+    QByteArray m_indexBuffer;
+    QElapsedTimer m_clock;
+    qint64 m_offset;          // File offset of the next record
+    qint64 m_nextIndexOffset;
+    qint64 m_lastFlushNs;
+    quint64 m_bytesCaptured;
+};
+
+// Memory-maps a capture and its index for random access. Record pointers
+// stay valid while the reader is open.
+class CaptureReader
+{
+public:
+    struct Record
+    {
+        qint64 offset = -1;   // File offset, -1 at the end
+        quint64 timeNs = 0;
+        Capture::Direction direction = Capture::Rx;
+        const char *data = nullptr;
+        qint64 size = 0;
+    };
+
+    CaptureReader();
+    ~CaptureReader();
+
+    bool open(const QString &fileName, QString *error);
+    void close();
+    bool isOpen() const;
+
+    qint64 startEpochUs() const;
+    quint64 durationNs() const;
+    qint64 fileSize() const;
+
+    // First record, the record after `record`, and the first record at or
+    // after timeNs (binary search in the index, then a short scan)
+    Record first() const;
+    Record next(const Record &record) const;
+    Record seek(quint64 timeNs) const;
+
+private:
+    Record recordAt(qint64 offset) const;
+    void buildIndex();
+
+    QFile m_file;
+    const uchar *m_data;
+    qint64 m_size;
+    qint64 m_startEpochUs;
+    QFile m_indexFile;
+    const Capture::IndexEntry *m_index;
+    qint64 m_indexCount;
+    QByteArray m_builtIndex;  // Used when the sidecar is missing or short
+    quint64 m_lastTimeNs;
+};
+
+#endif // CAPTUREFILE_H
@@ -0,0 +1,174 @@
+// Headless provisioning: runs the login / certificate upload / backup steps
+// of the GUI against every device listed in a manifest, several ports at a
+// time, and prints a per-device summary.
+//
+// Usage: configgui-cli [--parallel n] [--io-threads n] [--window n] [--ack-timeout ms] manifest.json
+// See provisioner.h for the manifest format. Exits 0 only if every device
+// succeeded.
+
+#include "credentialvalidator.h"
+#include "iothreadpool.h"
+#include "provisioner.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QQueue>
+#include <cstdio>
+
+namespace {
+
+QString formatSeconds(qint64 ms)
+{
+    return QString::number(ms / 1000.0, 'f', 1) + " s";
+}
+
+// Keeps up to maxParallel provisioners running until the queue is empty
+class ProvisionRunner : public QObject
+{
+public:
+    ProvisionRunner(const QList<ProvisionJob> &jobs, int maxParallel, int ioThreads, bool quiet)
+        : m_ioPool(ioThreads)
+        , m_maxParallel(maxParallel > 0 ? maxParallel : int(jobs.size()))
+        , m_running(0)
+        , m_quiet(quiet)
+    {
+        m_queue.append(jobs);
+    }
+
+    ~ProvisionRunner()
+    {
+        // Provisioners still around give their I/O threads back first
+        qDeleteAll(findChildren<DeviceProvisioner *>(QString(), Qt::FindDirectChildrenOnly));
+    }
+
+    void start()
+    {
+        m_clock.start();
+        startMore();
+    }
+
+    bool allSucceeded() const
+    {
+        for (const ProvisionResult &result : m_results) {
+            if (!result.success) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void printSummary() const
+    {
+        qint64 deviceTimeMs = 0;
+        int failures = 0;
+
+        printf("\n%-24s %-6s %9s  %s\n", "Port", "Result", "Time", "Steps / error");
+        for (const ProvisionResult &result : m_results) {
+            QStringList steps;
+            for (const auto &step : result.stepTimesMs) {
+                steps.append(QString("%1 %2").arg(step.first, formatSeconds(step.second)));
+            }
+            printf("%-24s %-6s %9s  %s\n", qPrintable(result.port), result.success ? "OK" : "FAIL",
+                   qPrintable(formatSeconds(result.elapsedMs)),
+                   qPrintable(result.success ? steps.join(", ") : result.error));
+            deviceTimeMs += result.elapsedMs;
+            failures += result.success ? 0 : 1;
+        }
+
+        const qint64 wallMs = qMax<qint64>(m_clock.elapsed(), 1);
+        printf("\n%lld devices, %d failed, wall time %s (%.1fx vs one at a time)\n",
+               static_cast<long long>(m_results.size()), failures, qPrintable(formatSeconds(wallMs)),
+               double(deviceTimeMs) / double(wallMs));
+        printf("%d credential files parsed, %d reused from the parse cache\n", CredentialValidator::cacheSize(),
+               CredentialValidator::cacheHits());
+        printf("%d serial I/O threads shared by all ports\n", m_ioPool.threadCount());
+    }
+
+private:
+    void startMore()
+    {
+        while (m_running < m_maxParallel && !m_queue.isEmpty()) {
+            DeviceProvisioner *provisioner = new DeviceProvisioner(m_queue.dequeue(), &m_ioPool, this);
+            connect(provisioner, &DeviceProvisioner::progress, this, [this](const QString &port, const QString &message) {
+                if (!m_quiet) {
+                    printf("[%8.1f] %s: %s\n", m_clock.elapsed() / 1000.0, qPrintable(port), qPrintable(message));
+                    fflush(stdout);
+                }
+            });
+            connect(provisioner, &DeviceProvisioner::finished, this, [this, provisioner](const ProvisionResult &result) {
+                printf("[%8.1f] %s: %s\n", m_clock.elapsed() / 1000.0, qPrintable(result.port),
+                       result.success ? "done" : qPrintable("FAILED - " + result.error));
+                fflush(stdout);
+                m_results.append(result);
+                provisioner->deleteLater();
+                --m_running;
+                // May finish inside start(); continue from the event loop
+                QMetaObject::invokeMethod(this, [this]() { startMore(); }, Qt::QueuedConnection);
+            });
+            ++m_running;
+            provisioner->start();
+        }
+
+        if (m_running == 0 && m_queue.isEmpty()) {
+            QCoreApplication::exit(allSucceeded() ? 0 : 1);
+        }
+    }
+
+    IoThreadPool m_ioPool; // Serves every provisioner's port
+    QQueue<ProvisionJob> m_queue;
+    QList<ProvisionResult> m_results;
+    int m_maxParallel;
+    int m_running;
+    bool m_quiet;
+    QElapsedTimer m_clock;
+};
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("configgui-cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Provision Nordic devices from a JSON manifest");
+    parser.addHelpOption();
+    const QCommandLineOption parallelOption("parallel", "Devices provisioned at once (0 = all).", "n", "0");
+    const QCommandLineOption windowOption("window", "Override the keymgmt lines sent ahead of acknowledgements.", "n");
+    const QCommandLineOption ackTimeoutOption("ack-timeout", "Override the wait for a line's acknowledgement.", "ms");
+    const QCommandLineOption bulkOption("bulk", "Upload certificates in bulk mode (base64 + CRC32).");
+    const QCommandLineOption ioThreadsOption("io-threads", "Threads serving all serial ports (0 = half the cores).", "n", "0");
+    const QCommandLineOption quietOption("quiet", "Only print results.");
+    parser.addOptions({ parallelOption, ioThreadsOption, windowOption, ackTimeoutOption, bulkOption, quietOption });
+    parser.addPositionalArgument("manifest", "Provisioning manifest (JSON).");
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1) {
+        parser.showHelp(2);
+    }
+
+    QList<ProvisionJob> jobs;
+    QString error;
+    if (!loadProvisionManifest(parser.positionalArguments().first(), &jobs, &error)) {
+        fprintf(stderr, "%s\n", qPrintable(error));
+        return 2;
+    }
+    for (ProvisionJob &job : jobs) {
+        if (parser.isSet(windowOption)) {
+            job.window = parser.value(windowOption).toInt();
+        }
+        if (parser.isSet(ackTimeoutOption)) {
+            job.ackTimeoutMs = parser.value(ackTimeoutOption).toInt();
+        }
+        if (parser.isSet(bulkOption)) {
+            job.bulk = true;
+        }
+    }
+
+    ProvisionRunner runner(jobs, parser.value(parallelOption).toInt(), parser.value(ioThreadsOption).toInt(),
+                           parser.isSet(quietOption));
+    QMetaObject::invokeMethod(&runner, [&runner]() { runner.start(); }, Qt::QueuedConnection);
+    const int exitCode = app.exec();
+    runner.printSummary();
+    return exitCode;
+}
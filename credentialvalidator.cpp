@@ -0,0 +1,610 @@
+#include "credentialvalidator.h"
+#include <QCryptographicHash>
+#include <QHash>
+#include <QMutex>
+#include <QTimeZone>
+
+namespace {
+
+const quint8 DER_BOOLEAN = 0x01;
+const quint8 DER_INTEGER = 0x02;
+const quint8 DER_BIT_STRING = 0x03;
+const quint8 DER_OCTET_STRING = 0x04;
+const quint8 DER_OID = 0x06;
+const quint8 DER_UTC_TIME = 0x17;
+const quint8 DER_GENERALIZED_TIME = 0x18;
+const quint8 DER_SEQUENCE = 0x30;
+const quint8 DER_SET = 0x31;
+const quint8 DER_CONTEXT_0 = 0xA0;
+const quint8 DER_CONTEXT_1 = 0xA1;
+const quint8 DER_CONTEXT_3 = 0xA3;
+const quint8 DER_IMPLICIT_1 = 0x81;
+const quint8 DER_IMPLICIT_2 = 0x82;
+
+const QByteArray OID_RSA_ENCRYPTION("\x2A\x86\x48\x86\xF7\x0D\x01\x01\x01", 9);
+const QByteArray OID_EC_PUBLIC_KEY("\x2A\x86\x48\xCE\x3D\x02\x01", 7);
+const QByteArray OID_BASIC_CONSTRAINTS("\x55\x1D\x13", 3);
+
+struct DerElement
+{
+    quint8 tag = 0;
+    const char *data = nullptr; // Contents
+    qsizetype size = 0;
+    const char *begin = nullptr; // Including tag and length
+    qsizetype totalSize = 0;
+
+    QByteArray contents() const { return QByteArray(data, size); }
+    QByteArray encoded() const { return QByteArray(begin, totalSize); }
+};
+
+// Walks the elements of one DER level; DerReader(element) descends into a
+// constructed element. Only definite lengths, as DER requires.
+class DerReader
+{
+public:
+    DerReader(const char *data, qsizetype size)
+        : m_pos(data)
+        , m_end(data + size)
+    {
+    }
+
+    explicit DerReader(const DerElement &element)
+        : DerReader(element.data, element.size)
+    {
+    }
+
+    bool atEnd() const
+    {
+        return m_pos >= m_end;
+    }
+
+    bool read(DerElement *element)
+    {
+        const qsizetype available = m_end - m_pos;
+        if (available < 2) {
+            return false;
+        }
+        const uchar *p = reinterpret_cast<const uchar *>(m_pos);
+        if ((p[0] & 0x1F) == 0x1F) {
+            return false; // Multi-byte tags don't occur in these formats
+        }
+
+        quint64 length = p[1];
+        qsizetype headerSize = 2;
+        if (length & 0x80) {
+            const int lengthBytes = int(length & 0x7F);
+            if (lengthBytes == 0 || lengthBytes > 4 || available < 2 + lengthBytes) {
+                return false;
+            }
+            length = 0;
+            for (int i = 0; i < lengthBytes; ++i) {
+                length = (length << 8) | p[2 + i];
+            }
+            headerSize += lengthBytes;
+        }
+        if (length > quint64(available - headerSize)) {
+            return false;
+        }
+
+        element->tag = p[0];
+        element->begin = m_pos;
+        element->data = m_pos + headerSize;
+        element->size = qsizetype(length);
+        element->totalSize = headerSize + qsizetype(length);
+        m_pos += element->totalSize;
+        return true;
+    }
+
+    bool read(quint8 tag, DerElement *element)
+    {
+        return read(element) && element->tag == tag;
+    }
+
+    // Reads the next element only if it has this tag (OPTIONAL fields)
+    bool readOptional(quint8 tag, DerElement *element)
+    {
+        return !atEnd() && quint8(*m_pos) == tag && read(element);
+    }
+
+private:
+    const char *m_pos;
+    const char *m_end;
+};
+
+// INTEGERs compare by value, without the sign padding byte
+QByteArray unsignedInteger(const DerElement &element)
+{
+    qsizetype start = 0;
+    while (start + 1 < element.size && element.data[start] == 0) {
+        ++start;
+    }
+    return QByteArray(element.data + start, element.size - start);
+}
+
+// BIT STRING contents without the unused-bits byte
+QByteArray bitStringBytes(const DerElement &element)
+{
+    return element.size > 0 ? QByteArray(element.data + 1, element.size - 1) : QByteArray();
+}
+
+QDateTime parseTime(const DerElement &element)
+{
+    QString text = QString::fromLatin1(element.data, element.size);
+    if (!text.endsWith('Z')) {
+        return QDateTime();
+    }
+    text.chop(1);
+    if (element.tag == DER_UTC_TIME && text.size() == 12) {
+        text.prepend(text.left(2).toInt() >= 50 ? "19" : "20");
+    } else if (element.tag != DER_GENERALIZED_TIME || text.size() != 14) {
+        return QDateTime();
+    }
+    return QDateTime(QDate::fromString(text.left(8), "yyyyMMdd"), QTime::fromString(text.mid(8), "HHmmss"),
+                     QTimeZone::utc());
+}
+
+QString nameString(const DerElement &name)
+{
+    static const QHash<QByteArray, QString> attributeNames = {
+        { QByteArray("\x55\x04\x03", 3), "CN" },
+        { QByteArray("\x55\x04\x06", 3), "C" },
+        { QByteArray("\x55\x04\x07", 3), "L" },
+        { QByteArray("\x55\x04\x08", 3), "ST" },
+        { QByteArray("\x55\x04\x0A", 3), "O" },
+        { QByteArray("\x55\x04\x0B", 3), "OU" },
+    };
+
+    QStringList parts;
+    DerReader rdns(name);
+    DerElement rdn;
+    while (rdns.read(DER_SET, &rdn)) {
+        DerReader attributes(rdn);
+        DerElement attribute;
+        while (attributes.read(DER_SEQUENCE, &attribute)) {
+            DerReader fields(attribute);
+            DerElement type, value;
+            if (fields.read(DER_OID, &type) && fields.read(&value) && attributeNames.contains(type.contents())) {
+                parts.append(attributeNames.value(type.contents()) + "=" + QString::fromUtf8(value.data, value.size));
+            }
+        }
+    }
+    return parts.join(", ");
+}
+
+bool parsePublicKeyInfo(const DerElement &publicKeyInfo, CredentialInfo *info)
+{
+    DerReader fields(publicKeyInfo);
+    DerElement algorithm, keyBits, oid;
+    if (!fields.read(DER_SEQUENCE, &algorithm) || !fields.read(DER_BIT_STRING, &keyBits)
+        || !DerReader(algorithm).read(DER_OID, &oid)) {
+        return false;
+    }
+
+    const QByteArray key = bitStringBytes(keyBits);
+    if (oid.contents() == OID_RSA_ENCRYPTION) {
+        // RSAPublicKey ::= SEQUENCE { modulus, publicExponent }
+        DerReader outer(key.constData(), key.size());
+        DerElement sequence, modulus;
+        if (!outer.read(DER_SEQUENCE, &sequence) || !DerReader(sequence).read(DER_INTEGER, &modulus)) {
+            return false;
+        }
+        info->keyAlgorithm = "RSA";
+        info->publicKey = unsignedInteger(modulus);
+    } else if (oid.contents() == OID_EC_PUBLIC_KEY) {
+        info->keyAlgorithm = "EC";
+        info->publicKey = key;
+    } else {
+        info->keyAlgorithm = "other";
+        info->publicKey = key;
+    }
+    return true;
+}
+
+bool parseCertificate(const QByteArray &der, CredentialInfo *info)
+{
+    DerReader top(der.constData(), der.size());
+    DerElement certificate, tbs, signatureAlgorithm, signature;
+    if (!top.read(DER_SEQUENCE, &certificate) || !top.atEnd()) {
+        return false;
+    }
+    DerReader certificateFields(certificate);
+    if (!certificateFields.read(DER_SEQUENCE, &tbs) || !certificateFields.read(DER_SEQUENCE, &signatureAlgorithm)
+        || !certificateFields.read(DER_BIT_STRING, &signature)) {
+        return false;
+    }
+
+    DerReader fields(tbs);
+    DerElement version, serial, algorithm, issuer, validity, subject, publicKeyInfo;
+    fields.readOptional(DER_CONTEXT_0, &version);
+    if (!fields.read(DER_INTEGER, &serial) || !fields.read(DER_SEQUENCE, &algorithm)
+        || !fields.read(DER_SEQUENCE, &issuer) || !fields.read(DER_SEQUENCE, &validity)
+        || !fields.read(DER_SEQUENCE, &subject) || !fields.read(DER_SEQUENCE, &publicKeyInfo)) {
+        return false;
+    }
+
+    DerReader times(validity);
+    DerElement notBefore, notAfter;
+    if (!times.read(&notBefore) || !times.read(&notAfter)) {
+        return false;
+    }
+    info->notBefore = parseTime(notBefore);
+    info->notAfter = parseTime(notAfter);
+    if (!info->notBefore.isValid() || !info->notAfter.isValid() || !parsePublicKeyInfo(publicKeyInfo, info)) {
+        return false;
+    }
+
+    info->kind = CredentialInfo::Certificate;
+    info->subject = nameString(subject);
+    info->issuer = nameString(issuer);
+    info->selfSigned = issuer.encoded() == subject.encoded();
+
+    // Unique IDs, then extensions
+    DerElement skipped, extensionsField, extensions, extension;
+    fields.readOptional(DER_IMPLICIT_1, &skipped);
+    fields.readOptional(DER_IMPLICIT_2, &skipped);
+    if (fields.readOptional(DER_CONTEXT_3, &extensionsField)
+        && DerReader(extensionsField).read(DER_SEQUENCE, &extensions)) {
+        DerReader extensionList(extensions);
+        while (extensionList.read(DER_SEQUENCE, &extension)) {
+            DerReader extensionFields(extension);
+            DerElement oid, critical, value, constraints, isCa;
+            if (!extensionFields.read(DER_OID, &oid) || oid.contents() != OID_BASIC_CONSTRAINTS) {
+                continue;
+            }
+            extensionFields.readOptional(DER_BOOLEAN, &critical);
+            // BasicConstraints ::= SEQUENCE { cA BOOLEAN DEFAULT FALSE, ... }
+            if (extensionFields.read(DER_OCTET_STRING, &value) && DerReader(value).read(DER_SEQUENCE, &constraints)
+                && DerReader(constraints).readOptional(DER_BOOLEAN, &isCa)) {
+                info->isCa = isCa.size == 1 && isCa.data[0] != 0;
+            }
+        }
+    }
+    return true;
+}
+
+// RSAPrivateKey ::= SEQUENCE { version, modulus, publicExponent, ... }
+bool parseRsaPrivateKey(const QByteArray &der, CredentialInfo *info)
+{
+    DerReader top(der.constData(), der.size());
+    DerElement key, version, modulus;
+    if (!top.read(DER_SEQUENCE, &key) || !top.atEnd()) {
+        return false;
+    }
+    DerReader fields(key);
+    if (!fields.read(DER_INTEGER, &version) || !fields.read(DER_INTEGER, &modulus)) {
+        return false;
+    }
+    info->kind = CredentialInfo::PrivateKey;
+    info->keyAlgorithm = "RSA";
+    info->publicKey = unsignedInteger(modulus);
+    return true;
+}
+
+// ECPrivateKey ::= SEQUENCE { version, privateKey OCTET STRING,
+//                             [0] parameters OPTIONAL, [1] publicKey OPTIONAL }
+bool parseEcPrivateKey(const QByteArray &der, CredentialInfo *info)
+{
+    DerReader top(der.constData(), der.size());
+    DerElement key, version, privateKey, parameters, publicKeyField, publicKey;
+    if (!top.read(DER_SEQUENCE, &key) || !top.atEnd()) {
+        return false;
+    }
+    DerReader fields(key);
+    if (!fields.read(DER_INTEGER, &version) || !fields.read(DER_OCTET_STRING, &privateKey)) {
+        return false;
+    }
+    fields.readOptional(DER_CONTEXT_0, &parameters);
+    info->kind = CredentialInfo::PrivateKey;
+    info->keyAlgorithm = "EC";
+    if (fields.readOptional(DER_CONTEXT_1, &publicKeyField)
+        && DerReader(publicKeyField).read(DER_BIT_STRING, &publicKey)) {
+        info->publicKey = bitStringBytes(publicKey);
+    }
+    return true;
+}
+
+// PrivateKeyInfo ::= SEQUENCE { version, algorithm, privateKey OCTET STRING,
+//                               [0] attributes OPTIONAL, [1] publicKey OPTIONAL }
+bool parsePkcs8PrivateKey(const QByteArray &der, CredentialInfo *info)
+{
+    DerReader top(der.constData(), der.size());
+    DerElement key, version, algorithm, oid, privateKey, attributes, publicKey;
+    if (!top.read(DER_SEQUENCE, &key) || !top.atEnd()) {
+        return false;
+    }
+    DerReader fields(key);
+    if (!fields.read(DER_INTEGER, &version) || !fields.read(DER_SEQUENCE, &algorithm)
+        || !fields.read(DER_OCTET_STRING, &privateKey) || !DerReader(algorithm).read(DER_OID, &oid)) {
+        return false;
+    }
+
+    bool parsed = false;
+    if (oid.contents() == OID_RSA_ENCRYPTION) {
+        parsed = parseRsaPrivateKey(privateKey.contents(), info);
+    } else if (oid.contents() == OID_EC_PUBLIC_KEY) {
+        parsed = parseEcPrivateKey(privateKey.contents(), info);
+    } else {
+        info->kind = CredentialInfo::PrivateKey;
+        info->keyAlgorithm = "other";
+        parsed = true;
+    }
+
+    fields.readOptional(DER_CONTEXT_0, &attributes);
+    if (parsed && info->publicKey.isEmpty() && fields.readOptional(DER_IMPLICIT_1, &publicKey)) {
+        info->publicKey = bitStringBytes(publicKey);
+    }
+    return parsed;
+}
+
+// EncryptedPrivateKeyInfo ::= SEQUENCE { algorithm, encryptedData OCTET STRING }
+bool parseEncryptedPrivateKey(const QByteArray &der, CredentialInfo *info)
+{
+    DerReader top(der.constData(), der.size());
+    DerElement key, algorithm, data;
+    if (!top.read(DER_SEQUENCE, &key) || !top.atEnd()) {
+        return false;
+    }
+    DerReader fields(key);
+    if (!fields.read(DER_SEQUENCE, &algorithm) || !fields.read(DER_OCTET_STRING, &data)) {
+        return false;
+    }
+    info->kind = CredentialInfo::EncryptedPrivateKey;
+    return true;
+}
+
+bool parseBlock(const QByteArray &label, const QByteArray &der, CredentialInfo *info)
+{
+    if (label == "CERTIFICATE" || label == "X509 CERTIFICATE") {
+        return parseCertificate(der, info);
+    } else if (label == "PRIVATE KEY") {
+        return parsePkcs8PrivateKey(der, info);
+    } else if (label == "EC PRIVATE KEY") {
+        return parseEcPrivateKey(der, info);
+    } else if (label == "RSA PRIVATE KEY") {
+        return parseRsaPrivateKey(der, info);
+    } else if (label == "ENCRYPTED PRIVATE KEY") {
+        return parseEncryptedPrivateKey(der, info);
+    }
+    return false;
+}
+
+QByteArray toPem(const QByteArray &label, const QByteArray &der)
+{
+    const QByteArray base64 = der.toBase64();
+    QByteArray pem = "-----BEGIN " + label + "-----\n";
+    for (qsizetype i = 0; i < base64.size(); i += 64) {
+        pem += base64.mid(i, 64) + '\n';
+    }
+    return pem + "-----END " + label + "-----\n";
+}
+
+// Folds one more block into the file's summary
+bool mergeBlock(const CredentialInfo &block, CredentialInfo *info)
+{
+    if (info->blockCount == 0) {
+        const QByteArray pem = info->pem;
+        *info = block;
+        info->pem = pem;
+    } else if (block.kind != info->kind) {
+        info->error = "The file mixes certificates and keys";
+        return false;
+    } else if (block.kind != CredentialInfo::Certificate) {
+        info->error = "The file holds more than one key";
+        return false;
+    } else {
+        info->notBefore = qMax(info->notBefore, block.notBefore);
+        info->notAfter = qMin(info->notAfter, block.notAfter);
+    }
+    ++info->blockCount;
+    return true;
+}
+
+CredentialInfo parsePem(const QByteArray &text)
+{
+    static const QByteArray beginMarker("-----BEGIN ");
+
+    CredentialInfo info;
+    qsizetype position = 0;
+    while ((position = text.indexOf(beginMarker, position)) >= 0) {
+        const qsizetype labelStart = position + beginMarker.size();
+        const qsizetype labelEnd = text.indexOf("-----", labelStart);
+        if (labelEnd < 0) {
+            info.error = "Truncated PEM BEGIN line";
+            return info;
+        }
+        const QByteArray label = text.mid(labelStart, labelEnd - labelStart);
+        const QByteArray endLine = "-----END " + label + "-----";
+        const qsizetype bodyStart = labelEnd + 5;
+        const qsizetype end = text.indexOf(endLine, bodyStart);
+        if (end < 0) {
+            info.error = QString("No END line for %1").arg(QString::fromLatin1(label));
+            return info;
+        }
+        position = end + endLine.size();
+
+        // openssl ecparam -genkey writes the curve ahead of the key; the
+        // key names its curve itself
+        if (label == "EC PARAMETERS") {
+            continue;
+        }
+
+        QByteArray body = text.mid(bodyStart, end - bodyStart);
+        CredentialInfo block;
+        if (body.contains("Proc-Type:") && body.contains("ENCRYPTED")) {
+            block.kind = CredentialInfo::EncryptedPrivateKey; // Legacy OpenSSL encryption headers
+        } else {
+            body = body.simplified().replace(' ', "");
+            const QByteArray::FromBase64Result der =
+                QByteArray::fromBase64Encoding(body, QByteArray::AbortOnBase64DecodingErrors);
+            if (!der) {
+                info.error = QString("Bad base64 in %1 block").arg(QString::fromLatin1(label));
+                return info;
+            }
+            if (!parseBlock(label, *der, &block)) {
+                info.error = label.contains("CERTIFICATE") || label.contains("KEY")
+                    ? QString("Malformed %1").arg(QString::fromLatin1(label).toLower())
+                    : QString("Unsupported PEM block \"%1\"").arg(QString::fromLatin1(label));
+                return info;
+            }
+        }
+
+        // Upload only the blocks themselves, without bag attributes or
+        // other text around them
+        const qsizetype blockStart = labelStart - beginMarker.size();
+        info.pem += text.mid(blockStart, position - blockStart) + '\n';
+        if (!mergeBlock(block, &info)) {
+            return info;
+        }
+    }
+
+    if (info.blockCount == 0) {
+        info.error = "No certificate or key found";
+        return info;
+    }
+    info.valid = true;
+    return info;
+}
+
+CredentialInfo parseDer(const QByteArray &der)
+{
+    static const QByteArray labels[] = { "CERTIFICATE", "PRIVATE KEY", "ENCRYPTED PRIVATE KEY", "EC PRIVATE KEY",
+                                         "RSA PRIVATE KEY" };
+
+    for (const QByteArray &label : labels) {
+        CredentialInfo info;
+        if (parseBlock(label, der, &info)) {
+            info.pem = toPem(label, der);
+            info.blockCount = 1;
+            info.valid = true;
+            return info;
+        }
+    }
+
+    CredentialInfo info;
+    info.error = "Not a certificate or key in DER format";
+    return info;
+}
+
+struct ParseCache
+{
+    QMutex mutex;
+    QHash<QByteArray, CredentialInfo> entries;
+    int hits = 0;
+};
+
+ParseCache &parseCache()
+{
+    static ParseCache cache;
+    return cache;
+}
+
+} // namespace
+
+CredentialInfo CredentialValidator::inspect(const QByteArray &data)
+{
+    const QByteArray hash = QCryptographicHash::hash(data, QCryptographicHash::Sha256);
+    ParseCache &cache = parseCache();
+    {
+        QMutexLocker locker(&cache.mutex);
+        const auto it = cache.entries.constFind(hash);
+        if (it != cache.entries.constEnd()) {
+            ++cache.hits;
+            return it.value();
+        }
+    }
+
+    CredentialInfo info;
+    if (data.contains("-----BEGIN ")) {
+        QByteArray text = data;
+        info = parsePem(text.replace('\r', ""));
+    } else if (!data.isEmpty() && quint8(data.at(0)) == DER_SEQUENCE) {
+        info = parseDer(data);
+    } else {
+        info.error = data.isEmpty() ? "Empty file" : "Neither PEM nor DER";
+    }
+
+    QMutexLocker locker(&cache.mutex);
+    cache.entries.insert(hash, info);
+    return info;
+}
+
+QStringList CredentialValidator::check(const CredentialInfo &info, const QString &type, const QDateTime &now,
+                                       QStringList *warnings)
+{
+    if (!info.valid) {
+        return { info.error };
+    }
+
+    QStringList errors;
+    const QString uploadType = type.toLower();
+    if (uploadType == "key") {
+        if (info.kind == CredentialInfo::Certificate) {
+            errors.append("The file holds a certificate, not a private key");
+        } else if (info.kind == CredentialInfo::EncryptedPrivateKey) {
+            errors.append("The private key is encrypted; the device needs it unencrypted");
+        }
+        return errors;
+    }
+
+    if (info.kind != CredentialInfo::Certificate) {
+        errors.append(QString("The file holds a private key, not a%1 certificate").arg(uploadType == "ca" ? " CA" : ""));
+        return errors;
+    }
+
+    const QString dateFormat = "yyyy-MM-dd";
+    if (now > info.notAfter) {
+        errors.append(QString("Certificate expired on %1").arg(info.notAfter.toString(dateFormat)));
+    } else if (now.addDays(EXPIRY_WARNING_DAYS) > info.notAfter) {
+        warnings->append(QString("Certificate expires on %1").arg(info.notAfter.toString(dateFormat)));
+    }
+    if (now < info.notBefore) {
+        warnings->append(QString("Certificate is not valid before %1; check the device clock")
+                             .arg(info.notBefore.toString(dateFormat)));
+    }
+
+    if (uploadType == "ca" && !info.isCa && !info.selfSigned) {
+        warnings->append(QString("%1 is not marked as a CA certificate").arg(info.subject));
+    } else if (uploadType != "ca" && info.isCa) {
+        warnings->append(QString("%1 is a CA certificate, uploaded as a client certificate").arg(info.subject));
+    }
+    return errors;
+}
+
+QString CredentialValidator::checkPair(const CredentialInfo &certificate, const CredentialInfo &key,
+                                       QStringList *warnings)
+{
+    if (!certificate.valid || !key.valid || certificate.kind != CredentialInfo::Certificate
+        || key.kind != CredentialInfo::PrivateKey) {
+        return QString(); // check() reports these
+    }
+    if (certificate.keyAlgorithm != key.keyAlgorithm) {
+        return QString("The key is %1 but the certificate's key is %2").arg(key.keyAlgorithm, certificate.keyAlgorithm);
+    }
+    if (key.publicKey.isEmpty() || certificate.publicKey.isEmpty()) {
+        warnings->append("The key file has no public key, so it can't be matched against the certificate");
+        return QString();
+    }
+    if (key.publicKey != certificate.publicKey) {
+        return "The private key does not belong to the certificate";
+    }
+    return QString();
+}
+
+int CredentialValidator::cacheSize()
+{
+    QMutexLocker locker(&parseCache().mutex);
+    return parseCache().entries.size();
+}
+
+int CredentialValidator::cacheHits()
+{
+    QMutexLocker locker(&parseCache().mutex);
+    return parseCache().hits;
+}
+
+void CredentialValidator::clearCache()
+{
+    QMutexLocker locker(&parseCache().mutex);
+    parseCache().entries.clear();
+    parseCache().hits = 0;
+}
@@ -0,0 +1,65 @@
+#ifndef CREDENTIALVALIDATOR_H
+#define CREDENTIALVALIDATOR_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QString>
+#include <QStringList>
+
+// What a PEM or DER credential file holds, as far as provisioning cares
+struct CredentialInfo
+{
+    enum Kind {
+        Unknown,
+        Certificate,
+        PrivateKey,
+        EncryptedPrivateKey
+    };
+
+    Kind kind = Unknown;
+    bool valid = false;     // Every block parsed
+    QString error;          // Why not
+    QByteArray pem;         // What to upload; DER input is converted
+    int blockCount = 0;     // e.g. several certificates in a CA chain
+
+    // Certificates: the first block's names, the tightest validity of all
+    QString subject;
+    QString issuer;
+    QDateTime notBefore;
+    QDateTime notAfter;
+    bool isCa = false;      // basicConstraints cA
+    bool selfSigned = false;
+
+    // "RSA" or "EC"; publicKey is the RSA modulus or the EC point, empty
+    // if an EC key file doesn't carry its public half
+    QString keyAlgorithm;
+    QByteArray publicKey;
+};
+
+// Parses credentials with a small bundled DER reader (X.509 certificates,
+// PKCS#8, PKCS#1 and SEC1 keys) so bad files are caught before a long
+// upload. Results are cached by the SHA-256 of the file contents, so
+// provisioning many devices from one bundle parses each file once; the
+// cache is shared by all threads.
+class CredentialValidator
+{
+public:
+    // PEM (any number of blocks) or a single DER object
+    static CredentialInfo inspect(const QByteArray &data);
+
+    // Problems that should stop an upload as the given type ("ca", "cert"
+    // or "key"); things worth a look go to warnings
+    static QStringList check(const CredentialInfo &info, const QString &type, const QDateTime &now,
+                             QStringList *warnings);
+    // A certificate and key bound for one sec tag must share a public key;
+    // returns the problem, or an empty string
+    static QString checkPair(const CredentialInfo &certificate, const CredentialInfo &key, QStringList *warnings);
+
+    static int cacheSize();
+    static int cacheHits();
+    static void clearCache();
+
+    static const int EXPIRY_WARNING_DAYS = 30;
+};
+
+#endif // CREDENTIALVALIDATOR_H
@@ -0,0 +1,192 @@
+#include "devicesession.h"
+#include <QTimer>
+#include "loginsession.h"
+#include "provisioningqueue.h"
+
+DeviceSession::DeviceSession(const QString &portName, IoThreadPool *ioPool, QObject *parent)
+    : QObject(parent)
+    , m_portName(portName)
+    , m_port(new SerialPort(ioPool, this))
+    , m_login(new LoginSession(this))
+    , m_queue(new ProvisioningQueue(this))
+    , m_flushTimer(new QTimer(this))
+    , m_baudRate(0)
+    , m_receivedBytes(0)
+    , m_receivedLines(0)
+    , m_reportedDroppedBytes(0)
+    , m_drainScheduled(false)
+{
+    m_login->setDevice(m_port);
+    m_queue->setDevice(m_port);
+    connect(m_login, &LoginSession::message, this, &DeviceSession::message);
+    connect(m_queue, &ProvisioningQueue::itemProgress, m_login, &LoginSession::keepAlive);
+
+    connect(m_port, &SerialDevice::dataReceived, this, &DeviceSession::readData);
+    connect(m_port, &SerialDevice::errorOccurred, this, &DeviceSession::handleError);
+
+    m_flushTimer->setSingleShot(true);
+    connect(m_flushTimer, &QTimer::timeout, this, &DeviceSession::flushPartialLine);
+}
+
+DeviceSession::~DeviceSession()
+{
+    m_queue->abort();
+    m_port->close();
+}
+
+QString DeviceSession::portName() const
+{
+    return m_portName;
+}
+
+int DeviceSession::baudRate() const
+{
+    return m_baudRate;
+}
+
+bool DeviceSession::open(int baudRate, const DeviceProfile &profile, const QString &writePort)
+{
+    close();
+
+    m_port->setDeviceProfile(profile);
+    const bool success = writePort.isEmpty()
+        ? m_port->open(m_portName, baudRate)
+        : m_port->openDual(m_portName, writePort, baudRate);
+    if (!success) {
+        return false;
+    }
+
+    m_baudRate = baudRate;
+    m_rxPipeline.reset();
+    m_reportedDroppedBytes = 0;
+    m_login->reset();
+    emit message(QString("Connected to %1 at %2 baud").arg(m_portName).arg(baudRate), "[INFO] ");
+    emit opened();
+    return true;
+}
+
+void DeviceSession::close()
+{
+    if (!m_port->isOpen()) {
+        return;
+    }
+
+    m_queue->abort();
+    m_flushTimer->stop();
+    flushPartialLine();
+    m_port->close();
+    m_login->reset();
+    m_baudRate = 0;
+    emit message(QString("Disconnected from %1").arg(m_portName), "[INFO] ");
+    emit closed();
+}
+
+bool DeviceSession::isOpen() const
+{
+    return m_port->isOpen();
+}
+
+QString DeviceSession::errorString() const
+{
+    return m_port->errorString();
+}
+
+bool DeviceSession::sendCommand(const QString &command)
+{
+    if (!m_port->enqueue((command + "\n").toUtf8())) {
+        return false;
+    }
+    if (m_login->isLoggedIn()) {
+        m_login->refresh();
+    }
+    return true;
+}
+
+SerialPort *DeviceSession::port() const
+{
+    return m_port;
+}
+
+LoginSession *DeviceSession::login() const
+{
+    return m_login;
+}
+
+ProvisioningQueue *DeviceSession::queue() const
+{
+    return m_queue;
+}
+
+quint64 DeviceSession::receivedBytes() const
+{
+    return m_receivedBytes;
+}
+
+quint64 DeviceSession::receivedLines() const
+{
+    return m_receivedLines;
+}
+
+void DeviceSession::readData()
+{
+    // Bounded batches, as in the main window: parsing runs on the GUI
+    // thread, so one chatty board mustn't hold up the other tabs. One pass
+    // is queued at a time, however often dataReceived() fires
+    const QByteArray data = m_port->read(RX_BATCH_SIZE);
+    if (m_port->hasData() && !m_drainScheduled) {
+        m_drainScheduled = true;
+        QTimer::singleShot(0, this, [this]() {
+            m_drainScheduled = false;
+            readData();
+        });
+    }
+
+    const quint64 dropped = m_port->droppedBytes();
+    if (dropped > m_reportedDroppedBytes) {
+        emit message(QString("%1: RX buffer overflow - %2 bytes dropped")
+                         .arg(m_portName).arg(dropped - m_reportedDroppedBytes), "[WARNING] ");
+        m_reportedDroppedBytes = dropped;
+    }
+
+    if (data.isEmpty()) {
+        return;
+    }
+    m_receivedBytes += data.size();
+
+    QStringList logLines, commandLines;
+    m_rxPipeline.feed(data, logLines, commandLines);
+    dispatch(logLines, commandLines);
+
+    if (m_rxPipeline.hasPartialLine()) {
+        m_flushTimer->start(LINE_RECONSTRUCTION_TIMEOUT);
+    } else {
+        m_flushTimer->stop();
+    }
+}
+
+void DeviceSession::flushPartialLine()
+{
+    QStringList logLines, commandLines;
+    m_rxPipeline.flush(logLines, commandLines);
+    dispatch(logLines, commandLines);
+}
+
+void DeviceSession::dispatch(const QStringList &logLines, const QStringList &commandLines)
+{
+    m_queue->handleReceived(commandLines, m_rxPipeline.parser().promptCount());
+    if (!commandLines.isEmpty()) {
+        m_login->handleResponse(commandLines.join('\n'));
+    }
+
+    if (logLines.isEmpty() && commandLines.isEmpty()) {
+        return;
+    }
+    m_receivedLines += logLines.size() + commandLines.size();
+    emit linesReceived(logLines, commandLines);
+}
+
+void DeviceSession::handleError(const QString &error)
+{
+    emit message(QString("%1: serial error: %2").arg(m_portName, error), "[ERROR] ");
+    close();
+}
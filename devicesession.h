@@ -0,0 +1,79 @@
+#ifndef DEVICESESSION_H
+#define DEVICESESSION_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include "rxpipeline.h"
+#include "serialport.h"
+
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
+class IoThreadPool;
+class LoginSession;
+class ProvisioningQueue;
+
+// Everything that belongs to one connected board: its port (on a shared
+// I/O thread), the RX pipeline, the login state and a provisioning queue.
+// Received bytes are parsed here and handed out as classified lines, so a
+// view only has to show them. SessionManager keeps one per port.
+class DeviceSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    DeviceSession(const QString &portName, IoThreadPool *ioPool, QObject *parent = nullptr);
+    ~DeviceSession();
+
+    QString portName() const;
+    int baudRate() const; // 0 while closed
+
+    // writePort as for SerialPort::openDual(), or empty for one port
+    bool open(int baudRate, const DeviceProfile &profile = DeviceProfile(),
+              const QString &writePort = QString());
+    void close();
+    bool isOpen() const;
+    QString errorString() const;
+
+    // Sends "command\n"; activity extends a login like in the main window
+    bool sendCommand(const QString &command);
+
+    SerialPort *port() const;
+    LoginSession *login() const;
+    ProvisioningQueue *queue() const;
+
+    quint64 receivedBytes() const;
+    quint64 receivedLines() const;
+
+    static const int RX_BATCH_SIZE = 16384;             // Max bytes parsed per pass
+    static const int LINE_RECONSTRUCTION_TIMEOUT = 100; // ms before a partial line is shown
+
+signals:
+    void linesReceived(const QStringList &logLines, const QStringList &commandLines);
+    // Connection and login events worth logging, prefix as in the log
+    void message(const QString &text, const QString &prefix);
+    void opened();
+    void closed();
+
+private:
+    void readData();
+    void flushPartialLine();
+    void dispatch(const QStringList &logLines, const QStringList &commandLines);
+    void handleError(const QString &error);
+
+    QString m_portName;
+    SerialPort *m_port;
+    LoginSession *m_login;
+    ProvisioningQueue *m_queue;
+    RxPipeline m_rxPipeline;
+    QTimer *m_flushTimer;
+    int m_baudRate;
+    quint64 m_receivedBytes;
+    quint64 m_receivedLines;
+    quint64 m_reportedDroppedBytes;
+    bool m_drainScheduled; // A readData() pass is queued
+};
+
+#endif // DEVICESESSION_H
@@ -0,0 +1,549 @@
+// Stand-in for the Nordic device shell on a Linux/macOS pseudo-terminal.
+// Prints the pty path to connect ConfigGUI (or anything else) to, then
+// emulates the shell commands the GUI drives: login / login test,
+// keymgmt put / bulk / abort and backup copyinto, with prompts, "messages
+// dropped" notices, response latency, baud-rate throttling, fragmented
+// writes and background Zephyr log output.
+//
+// Example: devicesim --link /tmp/ttyNRF --baud 115200 --log-rate 200
+//
+// With --window n the simulator also checks the uploader's pacing: it exits
+// with status 2 as soon as more than n keymgmt put/bulk commands have been
+// typed without their prompt having been sent back.
+//
+// On exit (Ctrl-C, SIGTERM or a window failure) it prints how much it sent
+// and how often its output backlog overflowed.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iterator>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+struct SimulatorOptions
+{
+    QString password = "nordic";
+    QString prompt = "uart:~$ ";  // Shell prompt once logged in
+    QString linkPath;            // Optional symlink to the pty slave
+    int latencyMs = 20;          // Delay before a command's response
+    int baudRate = 115200;       // Output throttling, 0 = unthrottled
+    int maxFragment = 0;         // Max bytes per write, 0 = no splitting
+    int logRate = 0;             // Background log lines per second
+    bool echo = true;            // Echo typed characters like the real shell
+    bool color = true;           // ANSI-coloured prompt
+    int window = 0;              // Max unanswered keymgmt commands, 0 = unchecked
+};
+
+const qsizetype MAX_OUTPUT_BACKLOG = 1024 * 1024; // Like a UART FIFO overflowing
+
+// SIGINT/SIGTERM are turned into a byte on this pipe so the event loop can
+// quit and the summary gets printed
+int quitPipe[2] = { -1, -1 };
+
+void handleQuitSignal(int)
+{
+    const char c = 0;
+    (void)!::write(quitPipe[1], &c, 1);
+}
+
+// Bit-at-a-time CRC-32 (IEEE), kept independent of the GUI's table version
+quint32 crc32(const QByteArray &data, quint32 crc)
+{
+    crc = ~crc;
+    for (const char c : data) {
+        crc ^= quint8(c);
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+    }
+    return ~crc;
+}
+
+class DeviceSimulator : public QObject
+{
+public:
+    explicit DeviceSimulator(const SimulatorOptions &options)
+        : m_options(options)
+        , m_master(-1)
+        , m_slave(-1)
+        , m_readNotifier(nullptr)
+        , m_writeNotifier(nullptr)
+        , m_outputTimer(new QTimer(this))
+        , m_logTimer(new QTimer(this))
+        , m_loggedIn(false)
+        , m_keymgmtLines(0)
+        , m_bulkCrc(0)
+        , m_bytesSent(0)
+        , m_logSequence(0)
+        , m_droppedMessages(0)
+        , m_pendingKeymgmt(0)
+    {
+    }
+
+    ~DeviceSimulator()
+    {
+        if (!m_options.linkPath.isEmpty()) {
+            QFile::remove(m_options.linkPath);
+        }
+        if (m_slave >= 0) {
+            ::close(m_slave);
+        }
+        if (m_master >= 0) {
+            ::close(m_master);
+        }
+    }
+
+    bool start()
+    {
+        m_master = posix_openpt(O_RDWR | O_NOCTTY);
+        if (m_master < 0 || grantpt(m_master) != 0 || unlockpt(m_master) != 0) {
+            fprintf(stderr, "Failed to create pty: %s\n", strerror(errno));
+            return false;
+        }
+        fcntl(m_master, F_SETFL, fcntl(m_master, F_GETFL) | O_NONBLOCK);
+
+        const QByteArray slavePath = ptsname(m_master);
+
+        // Holding the slave open keeps the master from reporting EIO while
+        // no client is attached. Start raw so nothing is cooked before the
+        // client configures the port itself.
+        m_slave = ::open(slavePath.constData(), O_RDWR | O_NOCTTY);
+        if (m_slave >= 0) {
+            termios tio;
+            if (tcgetattr(m_slave, &tio) == 0) {
+                cfmakeraw(&tio);
+                tcsetattr(m_slave, TCSANOW, &tio);
+            }
+        }
+
+        if (!m_options.linkPath.isEmpty()) {
+            QFile::remove(m_options.linkPath);
+            if (!QFile::link(QString::fromLocal8Bit(slavePath), m_options.linkPath)) {
+                fprintf(stderr, "Failed to create link %s\n", qPrintable(m_options.linkPath));
+            }
+        }
+
+        printf("Device simulator on %s%s%s\n", slavePath.constData(),
+               m_options.linkPath.isEmpty() ? "" : " -> ",
+               qPrintable(m_options.linkPath));
+        fflush(stdout);
+
+        m_readNotifier = new QSocketNotifier(m_master, QSocketNotifier::Read, this);
+        connect(m_readNotifier, &QSocketNotifier::activated, this, [this]() { readInput(); });
+
+        m_writeNotifier = new QSocketNotifier(m_master, QSocketNotifier::Write, this);
+        m_writeNotifier->setEnabled(false);
+        connect(m_writeNotifier, &QSocketNotifier::activated, this, [this]() {
+            m_writeNotifier->setEnabled(false);
+            pumpOutput();
+        });
+
+        // Throttled output is released in 1ms steps
+        m_outputTimer->setInterval(1);
+        connect(m_outputTimer, &QTimer::timeout, this, [this]() { pumpOutput(); });
+
+        if (m_options.logRate > 0) {
+            m_logTimer->setInterval(qMax(1, 1000 / m_options.logRate));
+            connect(m_logTimer, &QTimer::timeout, this, [this]() { emitLogLine(); });
+            m_logTimer->start();
+        }
+
+        m_clock.start();
+        send("\r\n*** Booting nRF Connect SDK (simulated) ***\r\n");
+        sendDropped(7);
+        sendPrompt();
+        return true;
+    }
+
+    void printSummary() const
+    {
+        printf("Sent %lld bytes, %llu log lines; output backlog overflowed %llu times\n",
+               qlonglong(m_bytesSent), qulonglong(m_logSequence), qulonglong(m_droppedMessages));
+        fflush(stdout);
+    }
+
+private:
+    void readInput()
+    {
+        char buffer[1024];
+        while (true) {
+            const ssize_t n = ::read(m_master, buffer, sizeof(buffer));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return;
+            }
+            for (ssize_t i = 0; i < n; ++i) {
+                handleInputChar(buffer[i]);
+            }
+        }
+    }
+
+    void handleInputChar(char c)
+    {
+        if (c == '\r' || c == '\n') {
+            if (m_options.echo) {
+                send("\r\n");
+            }
+            const QString line = QString::fromUtf8(m_inputLine).trimmed();
+            m_inputLine.clear();
+            if (line.isEmpty()) {
+                sendPrompt();
+                return;
+            }
+            const bool keymgmt = line.startsWith("keymgmt put") || line.startsWith("keymgmt bulk");
+            if (keymgmt) {
+                ++m_pendingKeymgmt;
+                checkWindow();
+            }
+            QTimer::singleShot(m_options.latencyMs, this, [this, line, keymgmt]() {
+                execute(line); // Always ends with the prompt
+                if (keymgmt) {
+                    --m_pendingKeymgmt;
+                }
+            });
+            return;
+        }
+        if (c == 0x7F || c == '\b') {
+            if (!m_inputLine.isEmpty()) {
+                m_inputLine.chop(1);
+                if (m_options.echo) {
+                    send("\b \b");
+                }
+            }
+            return;
+        }
+        m_inputLine.append(c);
+        if (m_options.echo) {
+            send(QByteArray(1, c));
+        }
+    }
+
+    void checkWindow()
+    {
+        if (m_options.window > 0 && m_pendingKeymgmt > m_options.window) {
+            fprintf(stderr, "Window exceeded: %d keymgmt commands outstanding, window %d\n",
+                    m_pendingKeymgmt, m_options.window);
+            QCoreApplication::exit(2);
+        }
+    }
+
+    void execute(const QString &line)
+    {
+        const QStringList args = splitArguments(line);
+        const QString command = args.value(0);
+        const QString sub = args.value(1);
+
+        if (command == "login") {
+            if (sub == "test") {
+                reply(m_loggedIn ? "Already authenticated" : "Not Logged In");
+            } else if (m_loggedIn) {
+                reply("Already Logged in");
+            } else if (sub == m_options.password) {
+                m_loggedIn = true;
+                reply("OK");
+                // The log backend restarts after login and reports its losses
+                sendDropped(int(QRandomGenerator::global()->bounded(1, 20)));
+            } else {
+                reply("Invalid password");
+            }
+        } else if (command == "logout") {
+            m_loggedIn = false;
+            reply("Logged out");
+        } else if (command == "keymgmt") {
+            keymgmt(args);
+        } else if (command == "backup") {
+            if (sub == "copyinto" && args.size() == 4) {
+                reply(QString("Backup: copied slot %1 into slot %2").arg(args[2], args[3]));
+            } else {
+                reply("backup: usage: backup copyinto <from> <to>");
+            }
+        } else if (command == "help") {
+            reply("Available commands:\r\n"
+                  "  backup   :Configuration backup slots\r\n"
+                  "  help     :Prints the help message.\r\n"
+                  "  keymgmt  :Key management\r\n"
+                  "  login    :Authenticate (login <password> | login test)\r\n"
+                  "  logout   :End the session");
+        } else if (!m_loggedIn) {
+            reply("Not Logged In");
+        } else {
+            reply(QString("%1: command not found").arg(command));
+        }
+    }
+
+    void keymgmt(const QStringList &args)
+    {
+        if (!m_loggedIn) {
+            reply("Not Logged In");
+            return;
+        }
+        const QString sub = args.value(1);
+        if (sub == "abort") {
+            m_keymgmtLines = 0;
+            m_bulkData.clear();
+            m_bulkCrc = 0;
+            reply("Keymgmt buffer cleared");
+        } else if (sub == "bulk" && args.size() == 6) {
+            // keymgmt bulk <tag> <type> <running crc32> <base64>
+            const QByteArray chunk = QByteArray::fromBase64(args[5].toLatin1());
+            m_bulkCrc = crc32(chunk, m_bulkCrc);
+            m_bulkData += chunk;
+            if (m_bulkCrc != args[4].toUInt(nullptr, 16)) {
+                reply(QString("ERROR: CRC mismatch at offset %1").arg(m_bulkData.size() - chunk.size()));
+                m_bulkData.clear();
+                m_bulkCrc = 0;
+            } else {
+                sendPrompt();
+            }
+        } else if (sub == "bulkend" && args.size() == 6) {
+            // keymgmt bulkend <tag> <type> <length> <crc32>
+            send(QString("CRC32 %1\r\n").arg(m_bulkCrc, 8, 16, QChar('0')).toUtf8());
+            reply(QString("Stored %1 bytes in sec tag %2").arg(m_bulkData.size()).arg(args[2]));
+            m_bulkData.clear();
+            m_bulkCrc = 0;
+        } else if (sub == "put" && args.size() >= 5) {
+            // Lines are buffered silently; an "OK" here would read as a login reply
+            ++m_keymgmtLines;
+            if (args[4].startsWith("-----END")) {
+                reply(QString("Key stored in sec tag %1 (%2 lines)").arg(args[2]).arg(m_keymgmtLines));
+                m_keymgmtLines = 0;
+            } else {
+                sendPrompt();
+            }
+        } else {
+            reply("keymgmt: usage: keymgmt put <sec_tag> <type> \"<line>\" | keymgmt abort\r\n"
+                  "        keymgmt bulk <sec_tag> <type> <crc32> <base64> | keymgmt bulkend <sec_tag> <type> <length> <crc32>");
+        }
+    }
+
+    // Split on spaces, honouring "double quotes" with \" escapes
+    static QStringList splitArguments(const QString &line)
+    {
+        QStringList args;
+        QString current;
+        bool quoted = false;
+        bool hasToken = false;
+        for (int i = 0; i < line.size(); ++i) {
+            const QChar c = line[i];
+            if (c == '\\' && quoted && i + 1 < line.size() && line[i + 1] == '"') {
+                current += '"';
+                ++i;
+            } else if (c == '"') {
+                quoted = !quoted;
+                hasToken = true;
+            } else if (c == ' ' && !quoted) {
+                if (hasToken) {
+                    args.append(current);
+                    current.clear();
+                    hasToken = false;
+                }
+            } else {
+                current += c;
+                hasToken = true;
+            }
+        }
+        if (hasToken) {
+            args.append(current);
+        }
+        return args;
+    }
+
+    void reply(const QString &text)
+    {
+        send(text.toUtf8() + "\r\n");
+        sendPrompt();
+    }
+
+    void sendPrompt()
+    {
+        const QByteArray prompt = m_loggedIn ? m_options.prompt.toUtf8() : QByteArray("login> ");
+        if (m_options.color) {
+            send("\x1b[1;32m" + prompt + "\x1b[m");
+        } else {
+            send(prompt);
+        }
+    }
+
+    void sendDropped(int count)
+    {
+        send(QString("--- %1 messages dropped ---\r\n").arg(count).toUtf8());
+    }
+
+    void emitLogLine()
+    {
+        static const char *const modules[] = { "app", "lte_lc", "mqtt_helper", "gnss", "modem" };
+        static const char *const messages[] = {
+            "Connected to LTE network",
+            "MQTT publish took %1 ms",
+            "GNSS fix acquired, %1 satellites",
+            "Thread stack usage %1%",
+            "Battery voltage %1 mV",
+        };
+        static const char *const levels[] = { "inf", "inf", "inf", "dbg", "wrn", "err" };
+
+        QRandomGenerator *random = QRandomGenerator::global();
+        const qint64 uptimeUs = m_clock.nsecsElapsed() / 1000;
+        const QString stamp = QString("[%1:%2:%3.%4,%5]")
+                                  .arg(uptimeUs / 3600000000LL, 2, 10, QChar('0'))
+                                  .arg(uptimeUs / 60000000LL % 60, 2, 10, QChar('0'))
+                                  .arg(uptimeUs / 1000000LL % 60, 2, 10, QChar('0'))
+                                  .arg(uptimeUs / 1000 % 1000, 3, 10, QChar('0'))
+                                  .arg(uptimeUs % 1000, 3, 10, QChar('0'));
+        const int level = int(random->bounded(int(std::size(levels))));
+        const QString message = QString(messages[random->bounded(int(std::size(messages)))])
+                                    .arg(random->bounded(1, 100));
+        const QString line = QString("%1 <%2> %3: %4 (#%5)")
+                                 .arg(stamp, levels[level],
+                                      modules[random->bounded(int(std::size(modules)))], message)
+                                 .arg(++m_logSequence);
+
+        // Colour like Zephyr's log backend; the shell redraws the prompt
+        const char *color = level == 5 ? "\x1b[1;31m" : level == 4 ? "\x1b[1;33m" : "";
+        QByteArray out = "\r\x1b[K";
+        out += color;
+        out += line.toUtf8();
+        out += *color ? "\x1b[0m\r\n" : "\r\n";
+        send(out);
+        sendPrompt();
+        send(m_inputLine);
+    }
+
+    void send(const QByteArray &data)
+    {
+        m_output.append(data);
+        if (m_output.size() > MAX_OUTPUT_BACKLOG) {
+            // Nobody is reading; drop the oldest output like the device would
+            const qsizetype excess = m_output.size() - MAX_OUTPUT_BACKLOG;
+            m_output.remove(0, excess);
+            ++m_droppedMessages;
+        }
+        pumpOutput();
+    }
+
+    void pumpOutput()
+    {
+        while (!m_output.isEmpty()) {
+            qint64 allowed = m_output.size();
+            if (m_options.baudRate > 0) {
+                // 8N1: ten bits per byte
+                const qint64 budget = m_clock.elapsed() * m_options.baudRate / 10000 - m_bytesSent;
+                if (budget <= 0) {
+                    m_outputTimer->start();
+                    return;
+                }
+                allowed = qMin(allowed, budget);
+            }
+            if (m_options.maxFragment > 0) {
+                allowed = qMin<qint64>(allowed, QRandomGenerator::global()->bounded(1, m_options.maxFragment + 1));
+            }
+
+            const ssize_t n = ::write(m_master, m_output.constData(), size_t(allowed));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                // Client not draining; wait until the pty has room
+                m_outputTimer->stop();
+                m_writeNotifier->setEnabled(true);
+                return;
+            }
+            m_output.remove(0, n);
+            m_bytesSent += n;
+
+            if (m_options.maxFragment > 0 && !m_output.isEmpty()) {
+                // Let the reader see the fragment on its own
+                m_outputTimer->start();
+                return;
+            }
+        }
+        m_outputTimer->stop();
+    }
+
+    const SimulatorOptions m_options;
+    int m_master;
+    int m_slave;
+    QSocketNotifier *m_readNotifier;
+    QSocketNotifier *m_writeNotifier;
+    QTimer *m_outputTimer;
+    QTimer *m_logTimer;
+    QElapsedTimer m_clock;
+    QByteArray m_inputLine;
+    QByteArray m_output;
+    bool m_loggedIn;
+    int m_keymgmtLines;
+    QByteArray m_bulkData;
+    quint32 m_bulkCrc;
+    qint64 m_bytesSent;
+    quint64 m_logSequence;
+    quint64 m_droppedMessages;   // Times the output backlog overflowed
+    int m_pendingKeymgmt;        // Typed, prompt not sent yet
+};
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("devicesim");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Nordic device shell simulator on a pseudo-terminal");
+    parser.addHelpOption();
+    const QCommandLineOption passwordOption("password", "Login password.", "password", "nordic");
+    const QCommandLineOption linkOption("link", "Create a symlink to the pty at <path>.", "path");
+    const QCommandLineOption latencyOption("latency", "Command response delay in ms.", "ms", "20");
+    const QCommandLineOption baudOption("baud", "Throttle output to this baud rate (0 = off).", "rate", "115200");
+    const QCommandLineOption fragmentOption("fragment", "Split output into writes of at most n bytes.", "n", "0");
+    const QCommandLineOption logRateOption("log-rate", "Background log lines per second.", "n", "0");
+    const QCommandLineOption promptOption("prompt", "Shell prompt once logged in, e.g. \"dev> \".", "text", "uart:~$ ");
+    const QCommandLineOption noEchoOption("no-echo", "Do not echo typed characters.");
+    const QCommandLineOption noColorOption("no-color", "Plain prompts without ANSI colour.");
+    const QCommandLineOption windowOption("window", "Exit with status 2 if more than n keymgmt commands are "
+                                          "ever unanswered (0 = off).", "n", "0");
+    parser.addOptions({ passwordOption, promptOption, linkOption, latencyOption, baudOption, fragmentOption,
+                        logRateOption, noEchoOption, noColorOption, windowOption });
+    parser.process(app);
+
+    SimulatorOptions options;
+    options.password = parser.value(passwordOption);
+    options.prompt = parser.value(promptOption);
+    options.linkPath = parser.value(linkOption);
+    options.latencyMs = parser.value(latencyOption).toInt();
+    options.baudRate = parser.value(baudOption).toInt();
+    options.maxFragment = parser.value(fragmentOption).toInt();
+    options.logRate = parser.value(logRateOption).toInt();
+    options.echo = !parser.isSet(noEchoOption);
+    options.color = !parser.isSet(noColorOption);
+    options.window = parser.value(windowOption).toInt();
+
+    DeviceSimulator simulator(options);
+    if (!simulator.start()) {
+        return 1;
+    }
+
+    if (::pipe(quitPipe) == 0) {
+        QSocketNotifier *quitNotifier = new QSocketNotifier(quitPipe[0], QSocketNotifier::Read, &app);
+        QObject::connect(quitNotifier, &QSocketNotifier::activated, &app, &QCoreApplication::quit);
+        signal(SIGINT, handleQuitSignal);
+        signal(SIGTERM, handleQuitSignal);
+    }
+
+    const int status = app.exec();
+    simulator.printSummary();
+    return status;
+}
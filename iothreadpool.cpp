@@ -0,0 +1,76 @@
+#include "iothreadpool.h"
+#include <QThread>
+
+IoThreadPool::IoThreadPool(int maxThreads, QObject *parent)
+    : QObject(parent)
+    , m_maxThreads(maxThreads > 0 ? maxThreads : defaultMaxThreads())
+{
+}
+
+IoThreadPool::~IoThreadPool()
+{
+    for (const Worker &worker : m_workers) {
+        worker.thread->quit();
+    }
+    for (const Worker &worker : m_workers) {
+        worker.thread->wait();
+        delete worker.thread;
+    }
+}
+
+QThread *IoThreadPool::acquire()
+{
+    int best = -1;
+    for (int i = 0; i < m_workers.size(); ++i) {
+        if (best < 0 || m_workers[i].ports < m_workers[best].ports) {
+            best = i;
+        }
+    }
+
+    // Spread ports over new threads first; share once all are running
+    if (best < 0 || (m_workers[best].ports > 0 && m_workers.size() < m_maxThreads)) {
+        QThread *thread = new QThread;
+        thread->setObjectName(QString("SerialPortIO-%1").arg(m_workers.size()));
+        thread->start();
+        m_workers.append({ thread, 0 });
+        best = int(m_workers.size()) - 1;
+    }
+
+    ++m_workers[best].ports;
+    return m_workers[best].thread;
+}
+
+void IoThreadPool::release(QThread *thread)
+{
+    // Threads stay up for the next port; they cost nothing while idle
+    for (Worker &worker : m_workers) {
+        if (worker.thread == thread) {
+            --worker.ports;
+            return;
+        }
+    }
+}
+
+int IoThreadPool::maxThreads() const
+{
+    return m_maxThreads;
+}
+
+int IoThreadPool::threadCount() const
+{
+    return int(m_workers.size());
+}
+
+int IoThreadPool::portCount() const
+{
+    int ports = 0;
+    for (const Worker &worker : m_workers) {
+        ports += worker.ports;
+    }
+    return ports;
+}
+
+int IoThreadPool::defaultMaxThreads()
+{
+    return qMax(1, QThread::idealThreadCount() / 2);
+}
@@ -0,0 +1,46 @@
+#ifndef IOTHREADPOOL_H
+#define IOTHREADPOOL_H
+
+#include <QList>
+#include <QObject>
+
+QT_BEGIN_NAMESPACE
+class QThread;
+QT_END_NAMESPACE
+
+// A few event-loop threads shared by many SerialPorts. Port I/O is
+// notifier driven and mostly idle, so one thread can serve several ports;
+// each acquire() hands out the thread with the fewest ports, starting a
+// new one until maxThreads are running. Used from one thread (the ports'
+// owner) and must outlive every port using it.
+class IoThreadPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    // maxThreads 0 = defaultMaxThreads()
+    explicit IoThreadPool(int maxThreads = 0, QObject *parent = nullptr);
+    ~IoThreadPool();
+
+    QThread *acquire();
+    void release(QThread *thread);
+
+    int maxThreads() const;
+    int threadCount() const;
+    int portCount() const;
+
+    // Up to half the cores: the GUI/main thread still parses everything
+    static int defaultMaxThreads();
+
+private:
+    struct Worker
+    {
+        QThread *thread;
+        int ports;
+    };
+
+    QList<Worker> m_workers;
+    int m_maxThreads;
+};
+
+#endif // IOTHREADPOOL_H
@@ -0,0 +1,414 @@
+#include "keymgmtuploader.h"
+#include "serialdevice.h"
+#include <QBuffer>
+#include <QFile>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QTimer>
+
+namespace {
+
+// Table for the reflected 0xEDB88320 polynomial
+struct Crc32Table
+{
+    quint32 entries[256];
+
+    Crc32Table()
+    {
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+            }
+            entries[i] = crc;
+        }
+    }
+};
+
+QString shellCertType(const QString &certType)
+{
+    // The shell calls it "cert", not "certificate"
+    const QString type = certType.toLower();
+    return type == "certificate" ? QString("cert") : type;
+}
+
+QByteArray crcHex(quint32 crc)
+{
+    return QByteArray::number(crc, 16).rightJustified(8, '0');
+}
+
+} // namespace
+
+KeymgmtUploader::KeymgmtUploader(QObject *parent)
+    : QObject(parent)
+    , m_device(nullptr)
+    , m_ackTimer(new QTimer(this))
+    , m_verifyTimer(new QTimer(this))
+    , m_mode(LineByLine)
+    , m_maxCommandLength(DEFAULT_MAX_COMMAND_LENGTH)
+    , m_secTag(MQTT_SEC_TAG)
+    , m_uploading(false)
+    , m_verifying(false)
+    , m_deviceCrcSeen(false)
+    , m_deviceCrc(0)
+    , m_expectedCrc(0)
+    , m_bytesSent(0)
+    , m_window(DEFAULT_WINDOW)
+    , m_sent(0)
+    , m_acked(0)
+    , m_timedOut(0)
+    , m_echoes(0)
+    , m_prompts(0)
+    , m_lastPromptCount(0)
+    , m_elapsedMs(0)
+{
+    m_ackTimer->setSingleShot(true);
+    m_ackTimer->setInterval(DEFAULT_ACK_TIMEOUT_MS);
+    connect(m_ackTimer, &QTimer::timeout, this, &KeymgmtUploader::handleTimeout);
+
+    m_verifyTimer->setSingleShot(true);
+    m_verifyTimer->setInterval(VERIFY_TIMEOUT_MS);
+    connect(m_verifyTimer, &QTimer::timeout, this, [this]() {
+        fail("The device did not report a CRC");
+    });
+}
+
+void KeymgmtUploader::setDevice(SerialDevice *device)
+{
+    m_device = device;
+}
+
+bool KeymgmtUploader::loadPemFile(const QString &filePath, QString *error)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = "Could not open file";
+        return false;
+    }
+    return setPemData(file.readAll(), error);
+}
+
+bool KeymgmtUploader::setPemData(const QByteArray &data, QString *error)
+{
+    m_data = data;
+
+    m_lines.clear();
+    QBuffer buffer(&m_data);
+    buffer.open(QIODevice::ReadOnly);
+    QTextStream in(&buffer);
+    while (!in.atEnd()) {
+        // Keep ALL lines including empty ones to preserve PEM structure
+        m_lines.append(in.readLine());
+    }
+
+    if (m_lines.isEmpty()) {
+        *error = "No valid lines found in PEM file";
+        return false;
+    }
+    return true;
+}
+
+QStringList KeymgmtUploader::lines() const
+{
+    return m_lines;
+}
+
+void KeymgmtUploader::start(int secTag, const QString &certType)
+{
+    if (!m_device || m_lines.isEmpty()) {
+        return;
+    }
+
+    m_secTag = secTag;
+    m_certType = certType;
+    m_commands.clear();
+    m_labels.clear();
+    if (m_mode == Bulk) {
+        m_commands = bulkCommands(secTag, certType, m_data, m_maxCommandLength);
+        m_expectedCrc = crc32(m_data.constData(), m_data.size());
+        for (int i = 0; i + 1 < m_commands.size(); ++i) {
+            m_labels.append(QString("chunk %1/%2 (%3 bytes)").arg(i + 1).arg(m_commands.size() - 1)
+                                .arg(m_commands[i].size()));
+        }
+        m_labels.append(QString("end, CRC32 %1").arg(QString::fromLatin1(crcHex(m_expectedCrc))));
+    } else {
+        for (const QString &line : m_lines) {
+            m_commands.append(putCommand(secTag, certType, line));
+        }
+        m_labels = m_lines;
+    }
+
+    m_sent = 0;
+    m_acked = 0;
+    m_timedOut = 0;
+    m_echoes = 0;
+    m_prompts = 0;
+    m_elapsedMs = 0;
+    m_bytesSent = 0;
+    m_verifying = false;
+    m_deviceCrcSeen = false;
+    m_uploading = true;
+    m_clock.start();
+
+    // Clear whatever a previous, interrupted upload left behind
+    m_device->enqueue("keymgmt abort\n");
+    sendWindow();
+}
+
+bool KeymgmtUploader::abort()
+{
+    const bool wasUploading = m_uploading;
+    m_ackTimer->stop();
+    m_verifyTimer->stop();
+    m_verifying = false;
+    if (m_uploading) {
+        m_uploading = false;
+        m_elapsedMs = m_clock.elapsed();
+    }
+
+    if (m_device) {
+        m_device->enqueue("keymgmt abort\n");
+    }
+    return wasUploading;
+}
+
+bool KeymgmtUploader::isUploading() const
+{
+    return m_uploading;
+}
+
+void KeymgmtUploader::handleReceived(const QStringList &commandLines, quint64 promptCount)
+{
+    static const QRegularExpression crcPattern("CRC32[:= ]+(?:0x)?([0-9A-Fa-f]{1,8})\\b");
+
+    const quint64 newPrompts = promptCount - m_lastPromptCount;
+    m_lastPromptCount = promptCount;
+    if (!m_uploading) {
+        return;
+    }
+
+    m_prompts += newPrompts;
+    const QLatin1String echo(m_mode == Bulk ? "keymgmt bulk" : "keymgmt put");
+    for (const QString &line : commandLines) {
+        if (line.contains(echo) || (m_echoes == 0 && line.contains(QLatin1String("keymgmt abort")))) {
+            ++m_echoes; // "keymgmt bulkend" counts as well
+        } else if (m_mode == Bulk) {
+            const QRegularExpressionMatch match = crcPattern.match(line);
+            if (match.hasMatch()) {
+                m_deviceCrc = match.captured(1).toUInt(nullptr, 16);
+                m_deviceCrcSeen = true;
+            } else if (line.contains("ERROR", Qt::CaseInsensitive)
+                       || line.contains("CRC mismatch", Qt::CaseInsensitive)) {
+                fail(line.trimmed());
+                return;
+            }
+        }
+    }
+
+    // Each finished command shows its echo and then a prompt; log output
+    // may redraw extra prompts, so the echoes cap the count. The abort
+    // start() sends heads both counts: the prompt that ends it comes before
+    // the first line's echo, so a line is only done on the prompt after it
+    acknowledge(int(qMin(quint64(m_echoes), m_prompts)) - 1);
+
+    if (m_verifying && m_deviceCrcSeen) {
+        verify(m_deviceCrc);
+    }
+}
+
+void KeymgmtUploader::setMode(Mode mode)
+{
+    m_mode = mode;
+}
+
+KeymgmtUploader::Mode KeymgmtUploader::mode() const
+{
+    return m_mode;
+}
+
+void KeymgmtUploader::setMaxCommandLength(int length)
+{
+    m_maxCommandLength = length;
+}
+
+int KeymgmtUploader::maxCommandLength() const
+{
+    return m_maxCommandLength;
+}
+
+void KeymgmtUploader::setWindow(int lines)
+{
+    m_window = qMax(1, lines);
+}
+
+int KeymgmtUploader::window() const
+{
+    return m_window;
+}
+
+void KeymgmtUploader::setAckTimeout(int timeoutMs)
+{
+    m_ackTimer->setInterval(timeoutMs);
+}
+
+int KeymgmtUploader::ackTimeout() const
+{
+    return m_ackTimer->interval();
+}
+
+int KeymgmtUploader::commandCount() const
+{
+    return m_commands.size();
+}
+
+int KeymgmtUploader::acknowledgedLines() const
+{
+    return m_acked;
+}
+
+int KeymgmtUploader::timedOutLines() const
+{
+    return m_timedOut;
+}
+
+qint64 KeymgmtUploader::elapsedMs() const
+{
+    return m_uploading ? m_clock.elapsed() : m_elapsedMs;
+}
+
+double KeymgmtUploader::linesPerSecond() const
+{
+    return m_acked * 1000.0 / double(qMax<qint64>(elapsedMs(), 1));
+}
+
+qint64 KeymgmtUploader::bytesSent() const
+{
+    return m_bytesSent;
+}
+
+QByteArray KeymgmtUploader::putCommand(int secTag, const QString &certType, const QString &line)
+{
+    // Quote the line to handle special characters like dashes
+    QString quotedLine = line;
+    if (!quotedLine.isEmpty()) {
+        // Escape quotes and wrap in quotes to handle shell interpretation
+        quotedLine.replace("\"", "\\\"");
+        quotedLine = "\"" + quotedLine + "\"";
+    }
+    return QString("keymgmt put %1 %2 %3\n").arg(secTag).arg(shellCertType(certType), quotedLine).toUtf8();
+}
+
+QList<QByteArray> KeymgmtUploader::bulkCommands(int secTag, const QString &certType, const QByteArray &data,
+                                                int maxCommandLength)
+{
+    const QByteArray prefix = QString("keymgmt bulk %1 %2 ").arg(secTag).arg(shellCertType(certType)).toUtf8();
+
+    // Prefix, 8 hex digits of CRC, a space, the base64 text and '\n';
+    // base64 comes in 4-character groups of 3 bytes each
+    const int base64Room = maxCommandLength - int(prefix.size()) - 8 - 1 - 1;
+    const qsizetype chunkBytes = qMax(1, base64Room / 4) * 3;
+
+    QList<QByteArray> commands;
+    quint32 crc = 0;
+    for (qsizetype offset = 0; offset < data.size(); offset += chunkBytes) {
+        const qsizetype size = qMin(chunkBytes, data.size() - offset);
+        crc = crc32(data.constData() + offset, size, crc);
+        commands.append(prefix + crcHex(crc) + ' ' + data.mid(offset, size).toBase64() + '\n');
+    }
+    commands.append(QString("keymgmt bulkend %1 %2 %3 ").arg(secTag).arg(shellCertType(certType)).arg(data.size()).toUtf8()
+                    + crcHex(crc) + '\n');
+    return commands;
+}
+
+quint32 KeymgmtUploader::crc32(const char *data, qsizetype size, quint32 crc)
+{
+    static const Crc32Table table;
+
+    crc = ~crc;
+    for (qsizetype i = 0; i < size; ++i) {
+        crc = table.entries[(crc ^ quint8(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void KeymgmtUploader::sendWindow()
+{
+    while (m_sent < m_commands.size() && m_sent - m_acked < m_window) {
+        m_device->enqueue(m_commands[m_sent]);
+        m_bytesSent += m_commands[m_sent].size();
+        ++m_sent;
+        emit lineSent(m_sent, m_commands.size(), m_labels.value(m_sent - 1));
+    }
+    if (m_sent > m_acked) {
+        m_ackTimer->start(); // For the oldest outstanding line
+    }
+}
+
+void KeymgmtUploader::acknowledge(int acked)
+{
+    acked = qMin(acked, m_sent);
+    if (acked <= m_acked || m_verifying) {
+        return;
+    }
+    m_acked = acked;
+
+    if (m_acked < m_commands.size()) {
+        sendWindow();
+        return;
+    }
+
+    m_ackTimer->stop();
+    if (m_mode == Bulk) {
+        // The CRC reply may already be in, or still on its way
+        m_verifying = true;
+        if (!m_deviceCrcSeen) {
+            m_verifyTimer->start();
+        }
+        return;
+    }
+
+    m_uploading = false;
+    m_elapsedMs = m_clock.elapsed();
+    emit finished();
+}
+
+void KeymgmtUploader::handleTimeout()
+{
+    if (!m_uploading) {
+        return;
+    }
+
+    // Assume the oldest line went through; late echoes of it must not
+    // acknowledge the next one as well
+    ++m_timedOut;
+    m_echoes = qMax(m_echoes, m_acked + 2); // The abort and the lines so far
+    m_prompts = qMax(m_prompts, quint64(m_acked + 2));
+    acknowledge(m_acked + 1);
+    if (m_verifying && m_deviceCrcSeen) {
+        verify(m_deviceCrc);
+    }
+}
+
+void KeymgmtUploader::verify(quint32 deviceCrc)
+{
+    m_verifyTimer->stop();
+    m_verifying = false;
+    if (deviceCrc != m_expectedCrc) {
+        fail(QString("CRC mismatch: device reported %1, expected %2")
+                 .arg(QString::fromLatin1(crcHex(deviceCrc)), QString::fromLatin1(crcHex(m_expectedCrc))));
+        return;
+    }
+
+    m_uploading = false;
+    m_elapsedMs = m_clock.elapsed();
+    emit finished();
+}
+
+void KeymgmtUploader::fail(const QString &reason)
+{
+    if (!m_uploading) {
+        return;
+    }
+    abort(); // Drops what the device buffered so far
+    emit failed(reason);
+}
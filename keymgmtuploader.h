@@ -0,0 +1,141 @@
+#ifndef KEYMGMTUPLOADER_H
+#define KEYMGMTUPLOADER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
+class SerialDevice;
+
+// Uploads a PEM file to a security tag with the device's keymgmt shell
+// command, one "keymgmt put" per line. The device's buffer is cleared with
+// "keymgmt abort" before the first line and when an upload is aborted.
+//
+// Lines are acknowledged from the RX stream: a line counts as done once
+// its echo and a following shell prompt have been seen (see
+// handleReceived()). Up to window() lines are outstanding at a time; if
+// no acknowledgement arrives within ackTimeout() the oldest line is taken
+// as done anyway, so a device that doesn't echo is paced like before.
+//
+// Bulk mode instead sends the file base64-encoded in chunks as long as the
+// shell's command buffer allows, each carrying the running CRC32 of the
+// data so far:
+//   keymgmt bulk <sec_tag> <type> <crc32> <base64>
+//   keymgmt bulkend <sec_tag> <type> <length> <crc32>
+// The device answers bulkend with "CRC32 <hex>" of what it stored, and the
+// upload only succeeds if that matches. Needs firmware with these commands.
+class KeymgmtUploader : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Mode {
+        LineByLine,
+        Bulk
+    };
+
+    explicit KeymgmtUploader(QObject *parent = nullptr);
+
+    void setDevice(SerialDevice *device);
+
+    // Reads every line of the file, empty ones included
+    bool loadPemFile(const QString &filePath, QString *error);
+    // Same for contents already read, e.g. by ProvisioningQueue::prepare()
+    bool setPemData(const QByteArray &data, QString *error);
+    QStringList lines() const;
+
+    void start(int secTag, const QString &certType);
+    // Returns whether an upload was in progress
+    bool abort();
+    bool isUploading() const;
+
+    // Feed with each batch of command output and the parser's prompt
+    // count (StreamLineParser::promptCount()), uploading or not
+    void handleReceived(const QStringList &commandLines, quint64 promptCount);
+
+    void setMode(Mode mode);
+    Mode mode() const;
+    // Longest command the device shell accepts, newline included
+    void setMaxCommandLength(int length);
+    int maxCommandLength() const;
+
+    void setWindow(int lines);
+    int window() const;
+    void setAckTimeout(int timeoutMs);
+    int ackTimeout() const;
+
+    // Commands the current or last upload consists of
+    int commandCount() const;
+
+    // Statistics of the current or last upload
+    int acknowledgedLines() const;
+    int timedOutLines() const;   // Lines advanced by the timeout fallback
+    qint64 elapsedMs() const;
+    double linesPerSecond() const;
+    qint64 bytesSent() const;
+
+    // The shell command for one PEM line
+    static QByteArray putCommand(int secTag, const QString &certType, const QString &line);
+    // The bulk mode commands for a whole file, bulkend included
+    static QList<QByteArray> bulkCommands(int secTag, const QString &certType, const QByteArray &data,
+                                          int maxCommandLength);
+    // CRC-32 (IEEE 802.3, as zlib's crc32()); pass the previous result to continue
+    static quint32 crc32(const char *data, qsizetype size, quint32 crc = 0);
+
+    static const int DEFAULT_WINDOW = 2;
+    static const int DEFAULT_ACK_TIMEOUT_MS = 500; // The old fixed line interval
+    static const int DEFAULT_MAX_COMMAND_LENGTH = 256; // Zephyr's default shell buffer
+    static const int VERIFY_TIMEOUT_MS = 5000;
+    static const int MQTT_SEC_TAG = 42;
+    static const int FOTA_SEC_TAG = 44;
+
+signals:
+    // current is 1-based; line is the PEM line or a chunk description
+    void lineSent(int current, int total, const QString &line);
+    // Every line was acknowledged (or timed out) and, in bulk mode, the
+    // device's CRC matched
+    void finished();
+    void failed(const QString &reason);
+
+private:
+    void sendWindow();
+    void acknowledge(int acked);
+    void handleTimeout();
+    void verify(quint32 deviceCrc);
+    void fail(const QString &reason);
+
+    SerialDevice *m_device;
+    QTimer *m_ackTimer;
+    QTimer *m_verifyTimer;
+    QStringList m_lines;
+    QByteArray m_data;       // File contents for bulk mode
+    QList<QByteArray> m_commands;
+    QStringList m_labels;    // What lineSent() reports per command
+    Mode m_mode;
+    int m_maxCommandLength;
+    int m_secTag;
+    QString m_certType;
+    bool m_uploading;
+    bool m_verifying;
+    bool m_deviceCrcSeen;
+    quint32 m_deviceCrc;
+    quint32 m_expectedCrc;
+    qint64 m_bytesSent;
+    int m_window;
+    int m_sent;
+    int m_acked;
+    int m_timedOut;
+    int m_echoes;            // "keymgmt abort" and "keymgmt put" echoes seen this upload
+    quint64 m_prompts;       // Prompts seen this upload
+    quint64 m_lastPromptCount;
+    QElapsedTimer m_clock;
+    qint64 m_elapsedMs;
+};
+
+#endif // KEYMGMTUPLOADER_H
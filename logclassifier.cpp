@@ -0,0 +1,445 @@
+#include "logclassifier.h"
+
+namespace {
+
+bool isDigit(char16_t c)
+{
+    return c >= '0' && c <= '9';
+}
+
+bool isStampChar(char16_t c)
+{
+    return isDigit(c) || c == '.' || c == ',' || c == ':';
+}
+
+char16_t toLowerAscii(char16_t c)
+{
+    return (c >= 'A' && c <= 'Z') ? char16_t(c + ('a' - 'A')) : c;
+}
+
+// word must be ASCII; with caseInsensitive it must also be lower case
+bool matchesAt(QStringView text, qsizetype pos, const char *word, qsizetype length,
+               bool caseInsensitive = false)
+{
+    if (text.size() - pos < length) {
+        return false;
+    }
+    for (qsizetype i = 0; i < length; ++i) {
+        char16_t c = text[pos + i].unicode();
+        if (caseInsensitive) {
+            c = toLowerAscii(c);
+        }
+        if (c != char16_t(word[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool startsWith(QStringView text, const char *prefix, qsizetype length)
+{
+    return matchesAt(text, 0, prefix, length);
+}
+
+// [d:dd:dd] / [dd:dd:dd] between the brackets
+bool isClock(QStringView stamp)
+{
+    const qsizetype hourDigits = stamp.size() - 6;
+    if (hourDigits != 1 && hourDigits != 2) {
+        return false;
+    }
+    for (qsizetype i = 0; i < stamp.size(); ++i) {
+        const qsizetype fromEnd = stamp.size() - i;
+        const bool colon = fromEnd == 3 || fromEnd == 6;
+        if (colon ? stamp[i] != u':' : !isDigit(stamp[i].unicode())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Everything both rule sets look at, gathered in one pass over the line.
+// Keyword checks peek a few characters ahead of the current position and
+// never copy; lines reach here as ASCII, so case folding is ASCII only.
+struct LineFeatures
+{
+    bool levelTag = false;
+    LogClassifier::Rule timestamp = LogClassifier::CommandResponse; // Leftmost stamp
+    bool clock = false;         // [hh:mm:ss] anywhere
+    bool shortChars = false;    // w d n f x : > or space
+    bool prompt = false;
+    bool keyword = false;       // mqtt lte gnss thread ms
+    bool content = false;       // publish fix since new
+    bool help = false;
+
+    explicit LineFeatures(QStringView text)
+    {
+        const qsizetype n = text.size();
+        for (qsizetype i = 0; i < n; ++i) {
+            const char16_t c = text[i].unicode();
+
+            switch (c) {
+            case '<':
+                levelTag = levelTag
+                    || matchesAt(text, i, "<inf>", 5) || matchesAt(text, i, "<wrn>", 5)
+                    || matchesAt(text, i, "<dbg>", 5) || matchesAt(text, i, "<err>", 5)
+                    || matchesAt(text, i, "<nfo>", 5) || matchesAt(text, i, "<warn>", 6)
+                    || matchesAt(text, i, "<debug>", 7) || matchesAt(text, i, "<error>", 7);
+                break;
+            case '[':
+                scanBracket(text, i);
+                break;
+            case 'w': case 'd': case 'n': case 'f': case 'x': case ':': case '>': case ' ':
+                shortChars = true;
+                break;
+            case '$':
+                prompt = prompt || (i + 1 < n && text[i + 1] == u' ');
+                break;
+            }
+
+            switch (c) {
+            case 'l':
+                prompt = prompt || matchesAt(text, i, "login>", 6);
+                break;
+            case 'd':
+                prompt = prompt || matchesAt(text, i, "dev>", 4);
+                break;
+            case 'u':
+                prompt = prompt || matchesAt(text, i, "uart:~$", 7);
+                break;
+            }
+
+            switch (toLowerAscii(c)) {
+            case 'm':
+                keyword = keyword || matchesAt(text, i, "mqtt", 4, true)
+                    || matchesAt(text, i, "ms", 2, true);
+                break;
+            case 'l':
+                keyword = keyword || matchesAt(text, i, "lte", 3, true);
+                break;
+            case 'g':
+                keyword = keyword || matchesAt(text, i, "gnss", 4, true);
+                break;
+            case 't':
+                keyword = keyword || matchesAt(text, i, "thread", 6, true);
+                break;
+            case 'p':
+                content = content || matchesAt(text, i, "publish", 7, true);
+                break;
+            case 'f':
+                content = content || matchesAt(text, i, "fix", 3, true);
+                break;
+            case 's':
+                content = content || matchesAt(text, i, "since", 5, true);
+                break;
+            case 'n':
+                content = content || matchesAt(text, i, "new", 3, true);
+                break;
+            case 'h':
+                help = help || matchesAt(text, i, "help", 4, true);
+                break;
+            }
+        }
+    }
+
+    void scanBracket(QStringView text, qsizetype pos)
+    {
+        qsizetype end = pos + 1;
+        while (end < text.size() && isStampChar(text[end].unicode())) {
+            ++end;
+        }
+
+        const QStringView inner = text.sliced(pos + 1, end - pos - 1);
+        const bool closed = end < text.size() && text[end] == u']' && !inner.isEmpty();
+        const bool clockStamp = closed && isClock(inner);
+        clock = clock || clockStamp;
+
+        if (timestamp != LogClassifier::CommandResponse) {
+            return;
+        }
+        if (closed) {
+            timestamp = clockStamp ? LogClassifier::ClockTimestamp
+                                   : LogClassifier::UptimeTimestamp;
+        } else if (pos == 0 && end == text.size()) {
+            timestamp = LogClassifier::TimestampFragment;
+        }
+    }
+};
+
+} // namespace
+
+LogClassifier::LogClassifier()
+    // The many overlapping timestamp checks collapse into one pass; the
+    // named group that captured tells which kind of stamp it was
+    : m_timestampRegex(R"((?<clock>\[[0-9]{1,2}:[0-9]{2}:[0-9]{2}\])|(?<stamp>\[[0-9.,:]+\])|(?<fragment>^\[[0-9.,:]*$))")
+    , m_clockRegex(R"(\[[0-9]{1,2}:[0-9]{2}:[0-9]{2}\])")
+    , m_splitRegex(R"(\s{2,}|\|\s*|\]\s*\[|x\s*)")
+{
+    // JIT-compile up front instead of on first use
+    m_timestampRegex.optimize();
+    m_clockRegex.optimize();
+    m_splitRegex.optimize();
+    resetCounters();
+}
+
+bool LogClassifier::isLogMessage(QStringView line)
+{
+    const Rule rule = logRule(line);
+    ++m_hits[rule];
+    return rule != ShellPrompt && rule != CommandResponse;
+}
+
+bool LogClassifier::isLikelyCorruptedLogLine(QStringView line)
+{
+    const Rule rule = corruptedRule(line);
+    if (rule == CommandResponse) {
+        return false; // Already counted by isLogMessage()
+    }
+    ++m_hits[rule];
+    return true;
+}
+
+LogClassifier::Rule LogClassifier::logRule(QStringView line) const
+{
+    const QStringView trimmed = line.trimmed();
+    if (trimmed.isEmpty()) {
+        return CommandResponse;
+    }
+
+    // Same order of checks as regexLogRule()
+    const LineFeatures features(trimmed);
+    if (features.levelTag) {
+        return LevelTag;
+    }
+    if (features.timestamp != CommandResponse) {
+        return features.timestamp;
+    }
+    if (trimmed.size() <= 5 && features.shortChars) {
+        return ShortFragment;
+    }
+    if (trimmed.size() == 1) {
+        return SingleChar;
+    }
+    if (startsWith(trimmed, "w ", 2) || startsWith(trimmed, "d ", 2)
+        || startsWith(trimmed, ": ", 2) || startsWith(trimmed, "nf> ", 4)
+        || startsWith(trimmed, "n ", 2) || startsWith(trimmed, "f> ", 3)) {
+        return FragmentPrefix;
+    }
+    if (features.prompt) {
+        return ShellPrompt;
+    }
+    if (trimmed.size() <= 2) {
+        return VeryShort;
+    }
+    return CommandResponse;
+}
+
+LogClassifier::Rule LogClassifier::corruptedRule(QStringView line) const
+{
+    const QStringView trimmed = line.trimmed();
+    if (trimmed.isEmpty()) {
+        return CommandResponse;
+    }
+
+    // Same order of checks as regexCorruptedRule()
+    const LineFeatures features(trimmed);
+    if (features.keyword) {
+        return CorruptedKeyword;
+    }
+    if (features.clock) {
+        return CorruptedTimestamp;
+    }
+    if (features.content) {
+        return CorruptedContent;
+    }
+    if (trimmed.size() < 10 && !features.help) {
+        return CorruptedShort;
+    }
+    return CommandResponse;
+}
+
+LogClassifier::Rule LogClassifier::regexLogRule(const QString &line) const
+{
+    const QString trimmed = line.trimmed();
+    
+    // Skip empty lines
+    if (trimmed.isEmpty()) {
+        return CommandResponse;
+    }
+    
+    // Check for log level tags - these indicate log messages
+    // Pattern like: <inf>, <wrn>, <dbg>, <err>, etc.
+    if (trimmed.contains("<inf>") || trimmed.contains("<wrn>") || 
+        trimmed.contains("<dbg>") || trimmed.contains("<err>") ||
+        trimmed.contains("<nfo>") || trimmed.contains("<warn>") ||
+        trimmed.contains("<debug>") || trimmed.contains("<error>")) {
+        return LevelTag;
+    }
+    
+    // Timestamps anywhere ([hh:mm:ss], [00:00:01.234,567], [1.2]) and
+    // incomplete timestamp fragments (like [01.04, [01.431,67)
+    const QRegularExpressionMatch match = m_timestampRegex.match(trimmed);
+    if (match.hasMatch()) {
+        if (match.capturedStart(QStringLiteral("clock")) >= 0) {
+            return ClockTimestamp;
+        }
+        if (match.capturedStart(QStringLiteral("stamp")) >= 0) {
+            return UptimeTimestamp;
+        }
+        return TimestampFragment;
+    }
+    
+    // Check for fragmented log content (single characters or very short fragments)
+    // These are often corrupted log messages where timestamp gets separated
+    if (trimmed.length() <= 5 && (trimmed.contains("w") || trimmed.contains("d") || 
+        trimmed.contains(":") || trimmed.contains("n") || trimmed.contains("f") ||
+        trimmed.contains(">") || trimmed.contains(" ") || trimmed.contains("x"))) {
+        return ShortFragment;
+    }
+    
+    // Check for single character lines (definitely noise)
+    if (trimmed.length() == 1) {
+        return SingleChar;
+    }
+    
+    // Check for lines that start with common log fragments
+    if (trimmed.startsWith("w ") || trimmed.startsWith("d ") || 
+        trimmed.startsWith(": ") || trimmed.startsWith("nf> ") ||
+        trimmed.startsWith("n ") || trimmed.startsWith("f> ")) {
+        return FragmentPrefix;
+    }
+    
+    // Check for shell prompt patterns (not log messages)
+    if (trimmed.contains("login>") || trimmed.contains("dev>") || 
+        trimmed.contains("uart:~$") || trimmed.contains("$ ")) {
+        return ShellPrompt;
+    }
+    
+    // Check for single character lines or very short lines (likely control characters)
+    if (trimmed.length() <= 2) {
+        return VeryShort;
+    }
+    
+    // Everything else is considered a command response (not a log message)
+    return CommandResponse;
+}
+
+LogClassifier::Rule LogClassifier::regexCorruptedRule(const QString &line) const
+{
+    const QString trimmed = line.trimmed();
+    
+    // Skip empty lines
+    if (trimmed.isEmpty()) {
+        return CommandResponse;
+    }
+    
+    // Check for common log message patterns that might have lost their tags
+    // These are typical log message content without the log level tags
+    if (trimmed.contains("MQTT", Qt::CaseInsensitive) || 
+        trimmed.contains("LTE", Qt::CaseInsensitive) ||
+        trimmed.contains("GNSS", Qt::CaseInsensitive) ||
+        trimmed.contains("Thread", Qt::CaseInsensitive) ||
+        trimmed.contains("ms", Qt::CaseInsensitive)) {
+        return CorruptedKeyword;
+    }
+    
+    // Check for timestamp patterns (from terminal program)
+    if (m_clockRegex.match(trimmed).hasMatch()) {
+        return CorruptedTimestamp;
+    }
+    
+    // Check for lines that look like log content but lack tags
+    if (trimmed.contains("publish", Qt::CaseInsensitive) ||
+        trimmed.contains("fix", Qt::CaseInsensitive) ||
+        trimmed.contains("since", Qt::CaseInsensitive) ||
+        trimmed.contains("new", Qt::CaseInsensitive)) {
+        return CorruptedContent;
+    }
+    
+    // Check for lines that are too short to be meaningful commands
+    if (trimmed.length() < 10 && !trimmed.contains("help", Qt::CaseInsensitive)) {
+        return CorruptedShort;
+    }
+    
+    // Everything else is considered a legitimate command response
+    return CommandResponse;
+}
+
+QStringList LogClassifier::splitLongLine(const QString &line, int maxLineLength) const
+{
+    QStringList fragments;
+    QString currentFragment;
+    
+    // Split on common delimiters that indicate separate messages
+    QStringList parts = line.split(m_splitRegex, Qt::SkipEmptyParts);
+    
+    for (const QString &part : parts) {
+        QString trimmedPart = part.trimmed();
+        if (trimmedPart.isEmpty()) continue;
+        
+        // Filter out single characters and very short fragments
+        if (trimmedPart.length() <= 2) {
+            continue; // Skip single characters and very short fragments
+        }
+        
+        // If this part looks like a complete message, add it as a fragment
+        if (trimmedPart.length() <= maxLineLength && 
+            (trimmedPart.contains('[') || trimmedPart.contains('<') || 
+             trimmedPart.length() > 10)) {
+            fragments.append(trimmedPart);
+        } else {
+            // Accumulate smaller parts
+            if (!currentFragment.isEmpty()) {
+                currentFragment += " ";
+            }
+            currentFragment += trimmedPart;
+            
+            // If accumulated fragment is long enough, add it
+            if (currentFragment.length() >= 20) {
+                fragments.append(currentFragment);
+                currentFragment.clear();
+            }
+        }
+    }
+    
+    // Add any remaining fragment (only if it's substantial)
+    if (!currentFragment.isEmpty() && currentFragment.length() >= 5) {
+        fragments.append(currentFragment);
+    }
+    
+    return fragments;
+}
+
+quint64 LogClassifier::hitCount(Rule rule) const
+{
+    return m_hits[rule];
+}
+
+QString LogClassifier::ruleName(Rule rule)
+{
+    switch (rule) {
+    case LevelTag:           return "Level tag";
+    case ClockTimestamp:     return "[hh:mm:ss] timestamp";
+    case UptimeTimestamp:    return "Uptime timestamp";
+    case TimestampFragment:  return "Timestamp fragment";
+    case ShortFragment:      return "Short fragment";
+    case SingleChar:         return "Single character";
+    case FragmentPrefix:     return "Fragment prefix";
+    case ShellPrompt:        return "Shell prompt";
+    case VeryShort:          return "Very short line";
+    case CorruptedKeyword:   return "Untagged keyword";
+    case CorruptedTimestamp: return "Untagged timestamp";
+    case CorruptedContent:   return "Untagged content";
+    case CorruptedShort:     return "Untagged short line";
+    case CommandResponse:    return "Command response";
+    case RuleCount:          break;
+    }
+    return QString();
+}
+
+void LogClassifier::resetCounters()
+{
+    for (quint64 &hits : m_hits) {
+        hits = 0;
+    }
+}
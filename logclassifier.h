@@ -0,0 +1,60 @@
+#ifndef LOGCLASSIFIER_H
+#define LOGCLASSIFIER_H
+
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+// Decides whether a received line is device log output (terminal pane) or
+// a command response (command pane). Lines are classified by a single pass
+// over a QStringView that never allocates; every decision is attributed to
+// the rule that made it so the hot rules can be profiled.
+class LogClassifier
+{
+public:
+    enum Rule {
+        LevelTag,           // <inf>, <wrn>, <err>, ...
+        ClockTimestamp,     // [hh:mm:ss]
+        UptimeTimestamp,    // [00:00:01.234,567] and other bracketed stamps
+        TimestampFragment,  // [01.04 cut off by the line break
+        ShortFragment,      // <= 5 chars with log-ish characters
+        SingleChar,
+        FragmentPrefix,     // "w ", "nf> ", ... left of a torn tag
+        ShellPrompt,        // login>, dev>, uart:~$ - never log
+        VeryShort,          // <= 2 chars
+        CorruptedKeyword,   // MQTT/LTE/GNSS/... without a tag
+        CorruptedTimestamp,
+        CorruptedContent,   // publish/fix/since/new without a tag
+        CorruptedShort,     // < 10 chars and not help output
+        CommandResponse,    // No log rule matched (Corrupted* may still claim it)
+        RuleCount
+    };
+
+    LogClassifier();
+
+    bool isLogMessage(QStringView line);
+    bool isLikelyCorruptedLogLine(QStringView line);
+    QStringList splitLongLine(const QString &line, int maxLineLength) const;
+
+    // Rule that decides a line, without touching the hit counters
+    Rule logRule(QStringView line) const;
+    Rule corruptedRule(QStringView line) const;
+
+    // Regex formulation of the same rules. Slower; kept as the reference
+    // the scanner is checked against (see bench_classifier.cpp)
+    Rule regexLogRule(const QString &line) const;
+    Rule regexCorruptedRule(const QString &line) const;
+
+    quint64 hitCount(Rule rule) const;
+    static QString ruleName(Rule rule);
+    void resetCounters();
+
+private:
+    QRegularExpression m_timestampRegex;  // Combined alternation, named groups
+    QRegularExpression m_clockRegex;
+    QRegularExpression m_splitRegex;
+    quint64 m_hits[RuleCount];
+};
+
+#endif // LOGCLASSIFIER_H
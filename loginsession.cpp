@@ -0,0 +1,177 @@
+#include "loginsession.h"
+#include "serialdevice.h"
+#include <QStringList>
+#include <QTimer>
+
+LoginSession::LoginSession(QObject *parent)
+    : QObject(parent)
+    , m_device(nullptr)
+    , m_timeoutTimer(new QTimer(this))
+    , m_loggedIn(false)
+    , m_waitingForLoginTest(false)
+    , m_retryCount(0)
+{
+    m_timeoutTimer->setSingleShot(true);
+    connect(m_timeoutTimer, &QTimer::timeout, this, &LoginSession::handleTimeout);
+}
+
+void LoginSession::setDevice(SerialDevice *device)
+{
+    m_device = device;
+}
+
+void LoginSession::login(const QString &password)
+{
+    if (!m_device || !m_device->isOpen()) {
+        return;
+    }
+
+    m_password = password;
+    m_retryCount = 0;
+    m_waitingForLoginTest = true;
+    m_pendingPassword = password;
+
+    // Send the real password first
+    sendLogin(password);
+
+    m_timeoutTimer->start(LOGIN_RETRY_TIMEOUT_MS);
+}
+
+void LoginSession::refresh()
+{
+    if (m_loggedIn && !m_password.isEmpty()) {
+        login(m_password);
+    }
+}
+
+void LoginSession::keepAlive()
+{
+    if (m_loggedIn && !m_waitingForLoginTest) {
+        m_timeoutTimer->start(LOGIN_TIMEOUT_MS);
+    }
+}
+
+void LoginSession::reset()
+{
+    m_loggedIn = false;
+    m_waitingForLoginTest = false;
+    m_pendingPassword.clear();
+    m_timeoutTimer->stop();
+}
+
+void LoginSession::handleResponse(const QString &response)
+{
+    const QString trimmedResponse = response.trimmed();
+
+    // "messages dropped" means the shell is ready again
+    if (trimmedResponse.contains("messages dropped", Qt::CaseInsensitive)) {
+        emit message("Connection established - messages dropped detected", "[INFO] ");
+        emit deviceReady();
+        emit message("Nordic terminal ready for commands", "[INFO] ");
+
+        // If we're waiting for login test after sending real password, send it now
+        if (m_waitingForLoginTest && !m_pendingPassword.isEmpty()) {
+            sendLoginTest();
+        }
+    }
+
+    if (trimmedResponse.contains("OK", Qt::CaseInsensitive)) {
+        setLoggedIn("Login successful");
+    } else if (trimmedResponse.contains("Already Logged in", Qt::CaseInsensitive)) {
+        setLoggedIn("Already logged in");
+    } else if (trimmedResponse.contains("Already authenticated", Qt::CaseInsensitive)) {
+        // Reply to the login test command
+        m_waitingForLoginTest = false;
+        setLoggedIn("Already authenticated");
+    } else if (m_waitingForLoginTest && (trimmedResponse.contains("uart:~$", Qt::CaseInsensitive)
+                                         || trimmedResponse.contains("dev>", Qt::CaseInsensitive)
+                                         || trimmedResponse.contains("login>", Qt::CaseInsensitive))) {
+        // Serial input has resumed, send the actual login command
+        m_waitingForLoginTest = false;
+        if (!m_loggedIn && !m_pendingPassword.isEmpty()) {
+            sendLogin(m_pendingPassword);
+            m_pendingPassword.clear();
+        }
+    } else if (trimmedResponse.contains("Not Logged In", Qt::CaseInsensitive)) {
+        fail("Not Logged In");
+    } else if (trimmedResponse.contains("ERROR", Qt::CaseInsensitive)
+               || trimmedResponse.contains("FAIL", Qt::CaseInsensitive)
+               || trimmedResponse.contains("Invalid", Qt::CaseInsensitive)) {
+        fail(trimmedResponse);
+    }
+    // Anything else may be a partial or unrelated response; the timeout
+    // covers the case where no verdict ever arrives
+}
+
+bool LoginSession::isLoggedIn() const
+{
+    return m_loggedIn;
+}
+
+int LoginSession::retryCount() const
+{
+    return m_retryCount;
+}
+
+QDateTime LoginSession::lastLoginTime() const
+{
+    return m_lastLoginTime;
+}
+
+bool LoginSession::isLoginRequired(const QString &command)
+{
+    // Commands that don't require login
+    static const QStringList noLoginCommands = { "backup" };
+
+    for (const QString &noLoginCmd : noLoginCommands) {
+        if (command.trimmed().startsWith(noLoginCmd, Qt::CaseInsensitive)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void LoginSession::sendLogin(const QString &password)
+{
+    m_device->enqueue(QString("login %1\n").arg(password).toUtf8());
+    emit message(QString("Sending login command (attempt %1/%2)").arg(m_retryCount + 1).arg(MAX_LOGIN_RETRIES), "> ");
+}
+
+void LoginSession::sendLoginTest()
+{
+    // Check whether the password was accepted
+    m_device->enqueue("login test\n");
+    emit message("Sending login test command", "> ");
+}
+
+void LoginSession::setLoggedIn(const QString &reason)
+{
+    m_loggedIn = true;
+    m_lastLoginTime = QDateTime::currentDateTime();
+    m_timeoutTimer->start(LOGIN_TIMEOUT_MS); // Login expires without activity
+
+    emit message(reason, "[INFO] ");
+    emit loggedIn();
+}
+
+void LoginSession::fail(const QString &reason)
+{
+    ++m_retryCount;
+    emit message(QString("Login failed - %1 (attempt %2/%3)").arg(reason).arg(m_retryCount).arg(MAX_LOGIN_RETRIES), "[ERROR] ");
+    emit loginFailed(QString("Login failed - %1").arg(reason));
+
+    if (m_retryCount >= MAX_LOGIN_RETRIES) {
+        handleTimeout();
+    } else {
+        QTimer::singleShot(LOGIN_RETRY_TIMEOUT_MS, this, &LoginSession::retryAvailable);
+    }
+}
+
+void LoginSession::handleTimeout()
+{
+    m_loggedIn = false;
+    m_timeoutTimer->stop();
+
+    emit message("Login timeout - authentication required", "[WARNING] ");
+    emit loginTimedOut();
+}
@@ -0,0 +1,76 @@
+#ifndef LOGINSESSION_H
+#define LOGINSESSION_H
+
+#include <QDateTime>
+#include <QObject>
+#include <QString>
+
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
+class SerialDevice;
+
+// Device login state machine. login() sends the password; the device's
+// replies, fed in through handleResponse(), drive the "login test"
+// handshake, success, failure and retry counting. A login expires after
+// LOGIN_TIMEOUT_MS unless refresh() is called with new activity.
+class LoginSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LoginSession(QObject *parent = nullptr);
+
+    void setDevice(SerialDevice *device);
+
+    void login(const QString &password);
+    void refresh();
+    // Restarts the expiry for activity that keeps the device's login alive
+    // (e.g. a running upload) without sending the password again
+    void keepAlive();
+    // Forget the login, e.g. on connect/disconnect
+    void reset();
+
+    // Command output from the device, possibly several lines
+    void handleResponse(const QString &response);
+
+    bool isLoggedIn() const;
+    int retryCount() const;
+    QDateTime lastLoginTime() const;
+
+    static bool isLoginRequired(const QString &command);
+
+    static const int LOGIN_TIMEOUT_MS = 30000; // 30 seconds
+    static const int LOGIN_RETRY_TIMEOUT_MS = 15000; // 15 seconds for retry (increased for computational delay)
+    static const int MAX_LOGIN_RETRIES = 3;
+
+signals:
+    // Progress worth logging, prefix as used by the log ("> ", "[INFO] ", ...)
+    void message(const QString &text, const QString &prefix);
+    // The shell is up ("messages dropped" seen)
+    void deviceReady();
+    void loggedIn();
+    void loginFailed(const QString &reason);
+    // A failed attempt may be retried now
+    void retryAvailable();
+    void loginTimedOut();
+
+private:
+    void sendLogin(const QString &password);
+    void sendLoginTest();
+    void setLoggedIn(const QString &reason);
+    void fail(const QString &reason);
+    void handleTimeout();
+
+    SerialDevice *m_device;
+    QTimer *m_timeoutTimer;
+    bool m_loggedIn;
+    bool m_waitingForLoginTest;
+    int m_retryCount;
+    QString m_password;
+    QString m_pendingPassword;
+    QDateTime m_lastLoginTime;
+};
+
+#endif // LOGINSESSION_H
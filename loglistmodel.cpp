@@ -0,0 +1,212 @@
+#include "loglistmodel.h"
+#include "logstore.h"
+#include "updatebatcher.h"
+#include <QBrush>
+#include <QColor>
+#include <QDateTime>
+#include <climits>
+
+LogListModel::LogListModel(LogStore *store, const QString &timeFormat, UpdateBatcher *batcher,
+                           QObject *parent)
+    : QAbstractListModel(parent)
+    , m_store(store)
+    , m_timeFormat(timeFormat)
+    , m_batcher(batcher)
+    , m_rows(0)
+    , m_evictedSeen(store->evictedCount())
+    , m_filtered(false)
+    , m_levelMask(LogStore::AllLevels)
+    , m_moduleId(-1)
+    , m_scanned(0)
+{
+    connect(m_batcher, &UpdateBatcher::flushRequested, this, &LogListModel::flush);
+
+    // Pick up anything already in the store
+    m_rows = int(qMin<qsizetype>(store->size(), INT_MAX));
+}
+
+int LogListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rows;
+}
+
+QVariant LogListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows) {
+        return QVariant();
+    }
+
+    const qsizetype i = storeIndex(index.row());
+    if (i < 0) {
+        return QVariant(); // Evicted since the last flush
+    }
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::ToolTipRole:
+        return rowText(index.row());
+    case Qt::ForegroundRole:
+        switch (m_store->level(i)) {
+        case LogStore::Error:
+            return QBrush(QColor("#c0392b"));
+        case LogStore::Warning:
+            return QBrush(QColor("#d35400"));
+        case LogStore::Debug:
+            return QBrush(QColor("#7f8c8d"));
+        default:
+            break;
+        }
+        break;
+    default:
+        break;
+    }
+    return QVariant();
+}
+
+void LogListModel::append(QStringView text, qint64 hostTimeMs)
+{
+    int lines = 0;
+    for (QStringView line : text.tokenize(u'\n')) {
+        m_store->append(line, hostTimeMs);
+        ++lines;
+    }
+    m_batcher->addPending(lines);
+}
+
+void LogListModel::clear()
+{
+    beginResetModel();
+    m_store->clear();
+    m_rows = 0;
+    m_evictedSeen = m_store->evictedCount();
+    m_matches.clear();
+    m_scanned = m_evictedSeen;
+    endResetModel();
+}
+
+void LogListModel::setFilter(quint32 levelMask, int moduleId)
+{
+    beginResetModel();
+    m_levelMask = levelMask;
+    m_moduleId = moduleId;
+    m_filtered = (levelMask & LogStore::AllLevels) != LogStore::AllLevels || moduleId >= 0;
+    m_evictedSeen = m_store->evictedCount();
+    m_matches.clear();
+    if (m_filtered) {
+        const QList<qsizetype> found = m_store->filter(m_levelMask, m_moduleId);
+        m_matches.reserve(found.size());
+        for (const qsizetype index : found) {
+            m_matches.append(m_evictedSeen + quint64(index));
+        }
+        m_rows = int(m_matches.size());
+    } else {
+        m_rows = int(qMin<qsizetype>(m_store->size(), INT_MAX));
+    }
+    m_scanned = m_evictedSeen + quint64(m_store->size());
+    endResetModel();
+}
+
+bool LogListModel::isFiltered() const
+{
+    return m_filtered;
+}
+
+QString LogListModel::rowText(int row) const
+{
+    const qsizetype i = storeIndex(row);
+    if (i < 0) {
+        return QString();
+    }
+    const QString time = QDateTime::fromMSecsSinceEpoch(m_store->hostTimeMs(i)).toString(m_timeFormat);
+    const QStringView text = m_store->text(i);
+    QString display;
+    display.reserve(time.size() + 1 + text.size());
+    display += time;
+    display += u' ';
+    display += text;
+    return display;
+}
+
+void LogListModel::flush()
+{
+    if (m_filtered) {
+        flushFiltered();
+        return;
+    }
+    if (m_store->size() == m_rows && m_store->evictedCount() == m_evictedSeen) {
+        return; // The other pane had the updates
+    }
+
+    // Rows the store dropped from the front since the last flush
+    const quint64 evicted = m_store->evictedCount();
+    if (evicted > m_evictedSeen) {
+        const int removed = int(qMin<quint64>(evicted - m_evictedSeen, quint64(m_rows)));
+        if (removed > 0) {
+            beginRemoveRows(QModelIndex(), 0, removed - 1);
+            m_rows -= removed;
+            m_evictedSeen += removed;
+            endRemoveRows();
+        }
+        m_evictedSeen = evicted;
+    }
+
+    const int total = int(qMin<qsizetype>(m_store->size(), INT_MAX));
+    if (total > m_rows) {
+        beginInsertRows(QModelIndex(), m_rows, total - 1);
+        m_rows = total;
+        endInsertRows();
+    }
+
+    emit rowsFlushed();
+}
+
+void LogListModel::flushFiltered()
+{
+    const quint64 evicted = m_store->evictedCount();
+    if (m_scanned == evicted + quint64(m_store->size())) {
+        return; // Nothing added since the last flush
+    }
+
+    // Matches the store dropped from the front
+    qsizetype removed = 0;
+    while (removed < m_matches.size() && m_matches[removed] < evicted) {
+        ++removed;
+    }
+    if (removed > 0) {
+        beginRemoveRows(QModelIndex(), 0, int(removed) - 1);
+        m_matches.remove(0, removed);
+        m_rows = int(m_matches.size());
+        endRemoveRows();
+    }
+    m_evictedSeen = evicted;
+
+    // Only the records added since the last flush are looked at
+    const qsizetype from = qsizetype(qMax(m_scanned, evicted) - evicted);
+    const QList<qsizetype> found = m_store->filter(m_levelMask, m_moduleId, from);
+    m_scanned = evicted + quint64(m_store->size());
+    if (!found.isEmpty()) {
+        beginInsertRows(QModelIndex(), m_rows, m_rows + int(found.size()) - 1);
+        for (const qsizetype index : found) {
+            m_matches.append(evicted + quint64(index));
+        }
+        m_rows = int(m_matches.size());
+        endInsertRows();
+    }
+
+    emit rowsFlushed();
+}
+
+qsizetype LogListModel::storeIndex(int row) const
+{
+    if (m_filtered) {
+        if (row < 0 || row >= m_matches.size()) {
+            return -1;
+        }
+        const qint64 index = qint64(m_matches[row]) - qint64(m_store->evictedCount());
+        return index >= 0 && index < m_store->size() ? qsizetype(index) : -1;
+    }
+
+    // Row numbers are relative to the evictions the view has seen
+    const qint64 index = qint64(m_evictedSeen) + row - qint64(m_store->evictedCount());
+    return index >= 0 && index < m_store->size() ? qsizetype(index) : -1;
+}
@@ -0,0 +1,70 @@
+#ifndef LOGLISTMODEL_H
+#define LOGLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QList>
+#include <QString>
+#include <QStringView>
+
+class LogStore;
+class UpdateBatcher;
+
+// List model over a LogStore for a QListView with uniform item sizes, so
+// only the visible rows are ever formatted or laid out. Appends go straight
+// into the store; the view is told about new (and evicted) rows only when
+// the shared UpdateBatcher flushes, keeping the cost per frame independent
+// of how many lines arrived or how many are held.
+//
+// With a filter set only the matching records are rows; LogStore::filter()
+// finds them once when the filter changes and then only among the records
+// added since the last flush.
+class LogListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    // timeFormat is a QDateTime format prefixed to every row,
+    // e.g. "hh:mm:ss.zzz" or "[hh:mm:ss]"
+    LogListModel(LogStore *store, const QString &timeFormat, UpdateBatcher *batcher,
+                 QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    // Adds one line per '\n'-separated part of text
+    void append(QStringView text, qint64 hostTimeMs);
+    void clear();
+
+    // Shows only records whose level is in levelMask (LogStore::levelBit())
+    // and, unless moduleId is -1, from that module. LogStore::AllLevels
+    // and -1 show everything again.
+    void setFilter(quint32 levelMask, int moduleId = -1);
+    bool isFiltered() const;
+
+    // Row text as displayed, for copying
+    QString rowText(int row) const;
+
+signals:
+    // Emitted after pending rows were published to the view
+    void rowsFlushed();
+
+public slots:
+    void flush();
+
+private:
+    qsizetype storeIndex(int row) const;
+    void flushFiltered();
+
+    LogStore *m_store;
+    QString m_timeFormat;
+    UpdateBatcher *m_batcher;
+    int m_rows;             // Rows the view knows about
+    quint64 m_evictedSeen;  // Store evictions already removed from the view
+    bool m_filtered;
+    quint32 m_levelMask;
+    int m_moduleId;
+    QList<quint64> m_matches; // Filtered rows as absolute record numbers (evictions + index)
+    quint64 m_scanned;        // Absolute record number the filter has looked at up to
+};
+
+#endif // LOGLISTMODEL_H
@@ -0,0 +1,303 @@
+#include "logstore.h"
+
+namespace {
+
+bool isDigit(char16_t c)
+{
+    return c >= '0' && c <= '9';
+}
+
+bool isModuleChar(char16_t c)
+{
+    return isDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '.'
+        || c == '-';
+}
+
+bool matchesAt(QStringView text, qsizetype pos, const char *word, qsizetype length)
+{
+    if (text.size() - pos < length) {
+        return false;
+    }
+    for (qsizetype i = 0; i < length; ++i) {
+        if (text[pos + i].unicode() != char16_t(word[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Reads a run of digits at pos; returns false if there is none
+bool readNumber(QStringView text, qsizetype &pos, qint64 &value)
+{
+    const qsizetype start = pos;
+    value = 0;
+    while (pos < text.size() && isDigit(text[pos].unicode()) && pos - start < 9) {
+        value = value * 10 + (text[pos].unicode() - '0');
+        ++pos;
+    }
+    return pos > start;
+}
+
+bool expect(QStringView text, qsizetype &pos, char16_t c)
+{
+    if (pos < text.size() && text[pos].unicode() == c) {
+        ++pos;
+        return true;
+    }
+    return false;
+}
+
+void skipSpaces(QStringView text, qsizetype &pos)
+{
+    while (pos < text.size() && text[pos].unicode() == ' ') {
+        ++pos;
+    }
+}
+
+// Zephyr's "[hh:mm:ss.mmm,uuu]" uptime stamp, in microseconds
+qint64 parseDeviceTime(QStringView text, qsizetype &pos)
+{
+    qsizetype p = pos;
+    qint64 hours, minutes, seconds, millis, micros;
+    if (!expect(text, p, '[') || !readNumber(text, p, hours) || !expect(text, p, ':')
+        || !readNumber(text, p, minutes) || !expect(text, p, ':')
+        || !readNumber(text, p, seconds) || !expect(text, p, '.')
+        || !readNumber(text, p, millis) || !expect(text, p, ',')
+        || !readNumber(text, p, micros) || !expect(text, p, ']')) {
+        return -1;
+    }
+    pos = p;
+    return ((hours * 60 + minutes) * 60 + seconds) * 1000000 + millis * 1000 + micros;
+}
+
+LogStore::Level parseLevel(QStringView text, qsizetype &pos)
+{
+    static const struct { const char *tag; qsizetype length; LogStore::Level level; } tags[] = {
+        { "<dbg>", 5, LogStore::Debug },
+        { "<inf>", 5, LogStore::Info },
+        { "<wrn>", 5, LogStore::Warning },
+        { "<err>", 5, LogStore::Error },
+        { "<nfo>", 5, LogStore::Info },
+        { "<debug>", 7, LogStore::Debug },
+        { "<warn>", 6, LogStore::Warning },
+        { "<error>", 7, LogStore::Error },
+        // Prefixes of the GUI's own messages
+        { "[DEBUG] ", 8, LogStore::Debug },
+        { "[INFO] ", 7, LogStore::Info },
+        { "[WARNING] ", 10, LogStore::Warning },
+        { "[ERROR] ", 8, LogStore::Error },
+    };
+    for (const auto &tag : tags) {
+        if (matchesAt(text, pos, tag.tag, tag.length)) {
+            pos += tag.length;
+            return tag.level;
+        }
+    }
+    return LogStore::NoLevel;
+}
+
+} // namespace
+
+LogStore::LogStore(qsizetype maxRecords)
+    : m_maxSegments(qMax<qsizetype>(1, (maxRecords + SEGMENT_SIZE - 1) / SEGMENT_SIZE))
+    , m_evicted(0)
+{
+    m_moduleNames.append(QString()); // Id 0: no module
+}
+
+void LogStore::append(QStringView line, qint64 hostTimeMs)
+{
+    // [00:00:01.234,567] <inf> module: message
+    qsizetype pos = 0;
+    const qint64 deviceTime = parseDeviceTime(line, pos);
+    skipSpaces(line, pos);
+    const Level level = parseLevel(line, pos);
+    skipSpaces(line, pos);
+
+    int module = 0;
+    if (level != NoLevel) {
+        qsizetype end = pos;
+        while (end < line.size() && isModuleChar(line[end].unicode())) {
+            ++end;
+        }
+        if (end > pos && end + 1 < line.size() && line[end] == u':' && line[end + 1] == u' ') {
+            module = internModule(line.sliced(pos, end - pos));
+            pos = end + 2;
+        }
+    }
+    if (pos > 0xFFFF) {
+        pos = 0; // Absurdly long header; keep the whole line as the message
+    }
+
+    if (m_segments.empty() || m_segments.back().size() == SEGMENT_SIZE) {
+        if (qsizetype(m_segments.size()) == m_maxSegments) {
+            m_evicted += m_segments.front().size();
+            m_segments.pop_front();
+        }
+        m_segments.emplace_back();
+        Segment &segment = m_segments.back();
+        segment.deviceTimeUs.reserve(SEGMENT_SIZE);
+        segment.hostTimeMs.reserve(SEGMENT_SIZE);
+        segment.levels.reserve(SEGMENT_SIZE);
+        segment.modules.reserve(SEGMENT_SIZE);
+        segment.textStart.reserve(SEGMENT_SIZE);
+        segment.messageStart.reserve(SEGMENT_SIZE);
+    }
+
+    Segment &segment = m_segments.back();
+    segment.deviceTimeUs.append(deviceTime);
+    segment.hostTimeMs.append(hostTimeMs);
+    segment.levels.append(level);
+    segment.modules.append(quint16(module));
+    segment.textStart.append(quint32(segment.text.size()));
+    segment.messageStart.append(quint16(pos));
+    segment.text.append(line);
+}
+
+void LogStore::clear()
+{
+    m_segments.clear();
+    m_evicted = 0;
+}
+
+qsizetype LogStore::size() const
+{
+    if (m_segments.empty()) {
+        return 0;
+    }
+    return (qsizetype(m_segments.size()) - 1) * SEGMENT_SIZE + m_segments.back().size();
+}
+
+bool LogStore::isEmpty() const
+{
+    return size() == 0;
+}
+
+quint64 LogStore::evictedCount() const
+{
+    return m_evicted;
+}
+
+qsizetype LogStore::memoryUsage() const
+{
+    qsizetype bytes = 0;
+    for (const Segment &segment : m_segments) {
+        bytes += segment.deviceTimeUs.capacity() * qsizetype(sizeof(qint64))
+            + segment.hostTimeMs.capacity() * qsizetype(sizeof(qint64))
+            + segment.levels.capacity() * qsizetype(sizeof(quint8))
+            + segment.modules.capacity() * qsizetype(sizeof(quint16))
+            + segment.textStart.capacity() * qsizetype(sizeof(quint32))
+            + segment.messageStart.capacity() * qsizetype(sizeof(quint16))
+            + segment.text.capacity() * qsizetype(sizeof(QChar));
+    }
+    return bytes;
+}
+
+qint64 LogStore::deviceTimeUs(qsizetype index) const
+{
+    return segmentOf(index).deviceTimeUs.at(rowOf(index));
+}
+
+qint64 LogStore::hostTimeMs(qsizetype index) const
+{
+    return segmentOf(index).hostTimeMs.at(rowOf(index));
+}
+
+LogStore::Level LogStore::level(qsizetype index) const
+{
+    return Level(segmentOf(index).levels.at(rowOf(index)));
+}
+
+int LogStore::moduleId(qsizetype index) const
+{
+    return segmentOf(index).modules.at(rowOf(index));
+}
+
+QStringView LogStore::text(qsizetype index) const
+{
+    const Segment &segment = segmentOf(index);
+    const qsizetype row = rowOf(index);
+    const qsizetype start = segment.textStart.at(row);
+    const qsizetype end = row + 1 < segment.size() ? segment.textStart.at(row + 1)
+                                                   : segment.text.size();
+    return QStringView(segment.text).sliced(start, end - start);
+}
+
+QStringView LogStore::message(qsizetype index) const
+{
+    return text(index).sliced(segmentOf(index).messageStart.at(rowOf(index)));
+}
+
+QString LogStore::moduleName(int moduleId) const
+{
+    return m_moduleNames.value(moduleId);
+}
+
+int LogStore::findModule(const QString &name) const
+{
+    const auto it = m_moduleIds.constFind(name);
+    return it != m_moduleIds.constEnd() ? int(it.value()) : -1;
+}
+
+QStringList LogStore::modules() const
+{
+    return m_moduleNames;
+}
+
+QList<qsizetype> LogStore::filter(quint32 levelMask, int moduleId, qsizetype from) const
+{
+    QList<qsizetype> matches;
+    for (size_t s = size_t(qMax<qsizetype>(from, 0) >> SEGMENT_SHIFT); s < m_segments.size(); ++s) {
+        const Segment &segment = m_segments[s];
+        const quint8 *levels = segment.levels.constData();
+        const quint16 *modules = segment.modules.constData();
+        const qsizetype base = qsizetype(s) * SEGMENT_SIZE;
+        const qsizetype count = segment.size();
+        for (qsizetype row = qMax<qsizetype>(from - base, 0); row < count; ++row) {
+            if ((levelMask & (1u << levels[row])) && (moduleId < 0 || modules[row] == moduleId)) {
+                matches.append(base + row);
+            }
+        }
+    }
+    return matches;
+}
+
+QString LogStore::levelName(Level level)
+{
+    switch (level) {
+    case NoLevel: return "none";
+    case Debug:   return "dbg";
+    case Info:    return "inf";
+    case Warning: return "wrn";
+    case Error:   return "err";
+    }
+    return QString();
+}
+
+const LogStore::Segment &LogStore::segmentOf(qsizetype index) const
+{
+    Q_ASSERT(index >= 0 && index < size());
+    return m_segments[size_t(index >> SEGMENT_SHIFT)];
+}
+
+qsizetype LogStore::rowOf(qsizetype index)
+{
+    return index & (SEGMENT_SIZE - 1);
+}
+
+int LogStore::internModule(QStringView name)
+{
+    // fromRawData() avoids a copy for the lookup; modules repeat constantly
+    const QString key = QString::fromRawData(reinterpret_cast<const QChar *>(name.utf16()), name.size());
+    const auto it = m_moduleIds.constFind(key);
+    if (it != m_moduleIds.constEnd()) {
+        return it.value();
+    }
+    if (m_moduleNames.size() > 0xFFFF) {
+        return 0; // Out of ids; treat as unnamed
+    }
+    const quint16 id = quint16(m_moduleNames.size());
+    m_moduleNames.append(name.toString());
+    m_moduleIds.insert(m_moduleNames.last(), id);
+    return id;
+}
@@ -0,0 +1,90 @@
+#ifndef LOGSTORE_H
+#define LOGSTORE_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <deque>
+
+// In-memory log history. Each line is parsed once into a record (device
+// timestamp, host timestamp, level, module, message offset) and the records
+// are kept column by column in fixed-size segments, with the line text in a
+// per-segment arena. A record costs ~25 bytes plus its UTF-16 text, and
+// dropping old history frees a whole segment without copying anything.
+class LogStore
+{
+public:
+    enum Level : quint8 {
+        NoLevel,
+        Debug,
+        Info,
+        Warning,
+        Error
+    };
+
+    static constexpr quint32 levelBit(Level level) { return 1u << level; }
+    static constexpr quint32 AllLevels = 0x1F;
+
+    // maxRecords is rounded up to whole segments
+    explicit LogStore(qsizetype maxRecords = 1000000);
+
+    // Parses and stores one line (no embedded newlines)
+    void append(QStringView line, qint64 hostTimeMs);
+    void clear();
+
+    qsizetype size() const;
+    bool isEmpty() const;
+    quint64 evictedCount() const;  // Records dropped to stay under maxRecords
+    qsizetype memoryUsage() const; // Approximate bytes held
+
+    // Record accessors, 0 = oldest record still held
+    qint64 deviceTimeUs(qsizetype index) const; // -1 if the line had no [hh:mm:ss.mmm,uuu]
+    qint64 hostTimeMs(qsizetype index) const;
+    Level level(qsizetype index) const;
+    int moduleId(qsizetype index) const;        // 0 if the line had no module
+    // Views into the arena stay valid until the next append() or clear()
+    QStringView text(qsizetype index) const;
+    QStringView message(qsizetype index) const;
+
+    QString moduleName(int moduleId) const;
+    int findModule(const QString &name) const;  // -1 if never seen
+    QStringList modules() const;                // Indexed by module id
+
+    // Indices of the records from index 'from' on matching a level mask
+    // and, unless moduleId is -1, a module. Only the level/module columns
+    // are touched.
+    QList<qsizetype> filter(quint32 levelMask, int moduleId = -1, qsizetype from = 0) const;
+
+    static QString levelName(Level level);
+
+private:
+    static constexpr int SEGMENT_SHIFT = 16;
+    static constexpr qsizetype SEGMENT_SIZE = qsizetype(1) << SEGMENT_SHIFT;
+
+    struct Segment
+    {
+        QList<qint64> deviceTimeUs;
+        QList<qint64> hostTimeMs;
+        QList<quint8> levels;
+        QList<quint16> modules;
+        QList<quint32> textStart;     // Record text starts here in the arena
+        QList<quint16> messageStart;  // Message offset within the record text
+        QString text;                 // Arena: record texts back to back
+
+        qsizetype size() const { return levels.size(); }
+    };
+
+    const Segment &segmentOf(qsizetype index) const;
+    static qsizetype rowOf(qsizetype index);
+    int internModule(QStringView name);
+
+    std::deque<Segment> m_segments;
+    qsizetype m_maxSegments;
+    quint64 m_evicted;
+    QHash<QString, quint16> m_moduleIds;
+    QStringList m_moduleNames;
+};
+
+#endif // LOGSTORE_H
@@ -0,0 +1,288 @@
+#include "logwriter.h"
+#include <QDir>
+#include <QThread>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef CONFIGGUI_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+const int IDLE_WAKE_MS = 1000; // Re-check hourly rotation and interval sync
+
+#ifdef CONFIGGUI_HAVE_ZLIB
+// Compresses path into path.gz and removes the original on success
+bool gzipFile(const QString &path)
+{
+    QFile source(path);
+    if (!source.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const QByteArray target = QFile::encodeName(path + ".gz");
+    gzFile out = gzopen(target.constData(), "wb6");
+    if (!out) {
+        return false;
+    }
+
+    bool ok = true;
+    while (ok && !source.atEnd()) {
+        const QByteArray chunk = source.read(256 * 1024);
+        ok = chunk.isEmpty()
+            || gzwrite(out, chunk.constData(), unsigned(chunk.size())) == int(chunk.size());
+    }
+    ok = gzclose(out) == Z_OK && ok;
+    source.close();
+
+    if (ok) {
+        QFile::remove(path);
+    } else {
+        QFile::remove(path + ".gz");
+    }
+    return ok;
+}
+#endif
+
+} // namespace
+
+LogWriter::LogWriter(const LogWriterSettings &settings)
+    : m_settings(settings)
+    , m_thread(nullptr)
+    , m_stopping(false)
+    , m_dropped(0)
+    , m_droppedReported(0)
+{
+}
+
+LogWriter::~LogWriter()
+{
+    stop();
+}
+
+bool LogWriter::start(QString *error)
+{
+    if (m_thread) {
+        return true;
+    }
+
+    // Opened here so a bad path is reported to the caller right away
+    if (!openFile(error)) {
+        return false;
+    }
+
+    m_stopping = false;
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName("LogWriter");
+    m_thread->start(QThread::LowPriority);
+    return true;
+}
+
+void LogWriter::stop()
+{
+    if (!m_thread) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeOne();
+    }
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+}
+
+void LogWriter::write(const QString &line)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_thread || m_stopping) {
+        return;
+    }
+    if (m_queue.size() >= m_settings.queueCapacity) {
+        ++m_dropped; // Disk can't keep up; never stall the caller
+        return;
+    }
+    m_queue.append(line);
+    if (m_queue.size() == 1) {
+        m_wake.wakeOne();
+    }
+}
+
+quint64 LogWriter::droppedLines() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_dropped;
+}
+
+QString LogWriter::fileName() const
+{
+    return QDir(m_settings.directory).filePath(m_settings.baseName + ".log");
+}
+
+bool LogWriter::compressionAvailable()
+{
+#ifdef CONFIGGUI_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+void LogWriter::run()
+{
+    QStringList batch;
+    while (true) {
+        bool stopping;
+        quint64 dropped;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_queue.isEmpty() && !m_stopping) {
+                m_wake.wait(&m_mutex, IDLE_WAKE_MS);
+            }
+            // Everything queued so far goes out as one batch
+            batch.swap(m_queue);
+            stopping = m_stopping;
+            dropped = m_dropped;
+        }
+
+        if (dropped > m_droppedReported) {
+            batch.append(QString("[WARNING] %1 log line(s) dropped - log writer queue full")
+                             .arg(dropped - m_droppedReported));
+            m_droppedReported = dropped;
+        }
+
+        writeBatch(batch);
+        batch.clear();
+
+        if (stopping) {
+            break;
+        }
+    }
+
+    sync();
+    m_file.close();
+}
+
+bool LogWriter::openFile(QString *error)
+{
+    if (!QDir().mkpath(m_settings.directory)) {
+        if (error) {
+            *error = QString("Failed to create log directory %1").arg(m_settings.directory);
+        }
+        return false;
+    }
+
+    m_file.setFileName(fileName());
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        if (error) {
+            *error = QString("Failed to open %1: %2").arg(m_file.fileName(), m_file.errorString());
+        }
+        return false;
+    }
+
+    m_openedAt = QDateTime::currentDateTime();
+    m_lastSync = m_openedAt;
+    return true;
+}
+
+void LogWriter::writeBatch(const QStringList &lines)
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    if (m_settings.rotateHourly && m_file.isOpen()
+        && (now.date() != m_openedAt.date() || now.time().hour() != m_openedAt.time().hour())) {
+        rotate();
+    }
+
+    if (!lines.isEmpty() && m_file.isOpen()) {
+        QByteArray data;
+        for (const QString &line : lines) {
+            data += line.toUtf8();
+            data += '\n';
+        }
+
+        if (m_settings.maxFileSize > 0 && m_file.size() > 0
+            && m_file.size() + data.size() > m_settings.maxFileSize) {
+            rotate();
+        }
+
+        // One write and one flush per batch instead of per line
+        m_file.write(data);
+        m_file.flush();
+
+        if (m_settings.syncPolicy == LogWriterSettings::SyncEveryBatch) {
+            sync();
+        }
+    }
+
+    if (m_settings.syncPolicy == LogWriterSettings::SyncInterval
+        && m_lastSync.msecsTo(now) >= m_settings.syncIntervalMs) {
+        sync();
+    }
+}
+
+void LogWriter::rotate()
+{
+    sync();
+    m_file.close();
+
+    // <baseName>-yyyyMMdd-hhmmss.log; names sort oldest first
+    const QDir dir(m_settings.directory);
+    const QString stamp = QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss");
+    QString rotated = dir.filePath(QString("%1-%2.log").arg(m_settings.baseName, stamp));
+    for (int n = 1; QFile::exists(rotated) || QFile::exists(rotated + ".gz"); ++n) {
+        rotated = dir.filePath(QString("%1-%2-%3.log").arg(m_settings.baseName, stamp).arg(n));
+    }
+    QFile::rename(fileName(), rotated);
+
+#ifdef CONFIGGUI_HAVE_ZLIB
+    if (m_settings.compressRotated) {
+        gzipFile(rotated);
+    }
+#endif
+
+    pruneRotated();
+
+    if (openFile(nullptr)) {
+        m_file.write(QString("=== Log continued: %1 ===\n")
+                         .arg(m_openedAt.toString("yyyy-MM-dd hh:mm:ss")).toUtf8());
+    }
+}
+
+void LogWriter::sync()
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    m_file.flush();
+    if (m_settings.syncPolicy != LogWriterSettings::SyncNever) {
+#ifdef Q_OS_WIN
+        _commit(m_file.handle());
+#else
+        ::fsync(m_file.handle());
+#endif
+    }
+    m_lastSync = QDateTime::currentDateTime();
+}
+
+void LogWriter::pruneRotated()
+{
+    if (m_settings.maxRotatedFiles <= 0) {
+        return;
+    }
+
+    const QDir dir(m_settings.directory);
+    QStringList rotated = dir.entryList({ m_settings.baseName + "-*.log",
+                                          m_settings.baseName + "-*.log.gz" },
+                                        QDir::Files, QDir::Name);
+    while (rotated.size() > m_settings.maxRotatedFiles) {
+        dir.remove(rotated.takeFirst());
+    }
+}
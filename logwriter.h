@@ -0,0 +1,83 @@
+#ifndef LOGWRITER_H
+#define LOGWRITER_H
+
+#include <QDateTime>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QWaitCondition>
+
+QT_BEGIN_NAMESPACE
+class QThread;
+QT_END_NAMESPACE
+
+struct LogWriterSettings
+{
+    enum SyncPolicy {
+        SyncNever,      // Leave write-back to the OS
+        SyncEveryBatch, // fsync after every batch of lines
+        SyncInterval    // fsync at most every syncIntervalMs
+    };
+
+    QString directory = "logs";
+    QString baseName = "config_gui";  // Active file is <baseName>.log
+    qint64 maxFileSize = 16 * 1024 * 1024;  // Rotate beyond this size, 0 = never
+    bool rotateHourly = false;        // Also rotate when the hour changes
+    int maxRotatedFiles = 20;         // Oldest rotated segments are deleted
+    bool compressRotated = true;      // gzip rotated segments (needs zlib)
+    SyncPolicy syncPolicy = SyncInterval;
+    int syncIntervalMs = 5000;
+    int queueCapacity = 65536;        // Lines; further lines are dropped and counted
+};
+
+// Log file sink running on its own thread. write() only queues the line,
+// so the GUI never waits on the disk; the writer thread drains the queue in
+// batches, writes each batch with a single call, and rotates the file by
+// size and/or hour. Rotated segments are renamed with a timestamp and
+// optionally gzip-compressed.
+class LogWriter
+{
+public:
+    explicit LogWriter(const LogWriterSettings &settings = LogWriterSettings());
+    ~LogWriter(); // Writes out whatever is still queued
+
+    LogWriter(const LogWriter &) = delete;
+    LogWriter &operator=(const LogWriter &) = delete;
+
+    bool start(QString *error = nullptr);
+    void stop();
+
+    // Thread-safe, never blocks on I/O
+    void write(const QString &line);
+
+    quint64 droppedLines() const;
+    QString fileName() const;
+    static bool compressionAvailable();
+
+private:
+    void run();
+    bool openFile(QString *error);
+    void writeBatch(const QStringList &lines);
+    void rotate();
+    void sync();
+    void pruneRotated();
+
+    const LogWriterSettings m_settings;
+    QThread *m_thread;
+
+    // Shared with the writer thread
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;
+    QStringList m_queue;
+    bool m_stopping;
+    quint64 m_dropped;
+
+    // Writer thread only
+    QFile m_file;
+    QDateTime m_openedAt;
+    QDateTime m_lastSync;
+    quint64 m_droppedReported;
+};
+
+#endif // LOGWRITER_H
@@ -6,42 +6,57 @@
 #include <QApplication>
 #include <QScrollBar>
 #include <QKeyEvent>
-#include <QRegularExpression>
 #include <QMenuBar>
 #include <QMenu>
 #include <QAction>
+#include <QActionGroup>
 #include <QDir>
+#include <QFileInfo>
 #include <QStandardPaths>
-#include <QSerialPortInfo>
 #include <QTabWidget>
 #include <QFileDialog>
 #include <QProgressBar>
 #include <QRadioButton>
 #include <QButtonGroup>
+#include <QClipboard>
+#include <QInputDialog>
+#include <QHeaderView>
+#include <QSpinBox>
 #include <algorithm>
+#include <functional>
+#include "devicesession.h"
+#include "iothreadpool.h"
+#include "sessionview.h"
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
-    , serialPort(new SerialPort(this))
-    , dataTimer(new QTimer(this))
-    , portScanTimer(new QTimer(this))
+    , sessionManager(new SessionManager(0, this))
+    , serialPort(new SerialPort(sessionManager->ioPool(), this))
+    , device(serialPort)
+    , replaySource(nullptr)
+    , portWatcher(new PortWatcher(this))
+    , portProber(new PortProber(this))
+    , probeDelayTimer(new QTimer(this))
+    , baudProber(new BaudProber(this))
     , autoClearTimer(new QTimer(this))
+    , updateBatcher(new UpdateBatcher(UpdateBatcher::DEFAULT_INTERVAL_MS, this))
     , userScrolling(false)
     , isConnected(false)
     , currentComPort("COM9")
     , currentBaudRate(115200)
-    , logFile(nullptr)
-    , logBuffer()
-    , logFileName("config_gui.log")
+    , autoBaudRate(115200)
+    , logWriter(new LogWriter)
+    , logStore(MAX_LOG_LINES)
+    , commandStore(MAX_COMMAND_LINES)
     , flushTimer(new QTimer(this))
-    , keymgmtTimer(new QTimer(this))
-    , isLoggedIn(false)
-    , loginTimeoutTimer(new QTimer(this))
-    , loginRetryCount(0)
-    , waitingForLoginTest(false)
+    , keymgmtUploader(new KeymgmtUploader(this))
+    , provisioningQueue(new ProvisioningQueue(this))
+    , loginSession(new LoginSession(this))
+    , rxPipeline(MAX_ACCUMULATED_SIZE, MAX_LINE_LENGTH)
+    , reportedDroppedBytes(0)
+    , drainScheduled(false)
 {
     setupUI();
-    scanAvailablePorts();
     populateBaudRates();
     
     // Initialize log file
@@ -50,14 +65,49 @@ MainWindow::MainWindow(QWidget *parent)
     // Connect serial port signals
     connect(serialPort, &SerialPort::errorOccurred, this, &MainWindow::handleError);
     
-    // Set up timer for checking data - optimized for robust line reconstruction
-    connect(dataTimer, &QTimer::timeout, this, &MainWindow::checkForData);
-    dataTimer->setInterval(2); // Check every 2ms for maximum responsiveness
+    // Read only when the port reports new bytes
+    connect(serialPort, &SerialPort::dataReceived, this, &MainWindow::readData);
+    connect(serialPort, &SerialPort::writeFailed, this, [this](quint64 id, const QString &error) {
+        logMessage(QString("Write #%1 failed: %2").arg(id).arg(error), "[ERROR] ");
+    });
+    
+    // Additional boards log to the same file, tagged with their port
+    connect(sessionManager, &SessionManager::sessionAdded, this, [this](DeviceSession *session) {
+        const QString portName = session->portName();
+        connect(session, &DeviceSession::linesReceived, this,
+                [this, portName](const QStringList &logLines, const QStringList &commandLines) {
+            const QString timestamp = QDateTime::currentDateTime().toString("hh:mm:ss.zzz");
+            for (const QString &line : logLines + commandLines) {
+                writeToLogFile(QString("%1 [%2] %3").arg(timestamp, portName, line));
+            }
+        });
+        connect(session, &DeviceSession::message, this,
+                [this, portName](const QString &text, const QString &prefix) {
+            const QString timestamp = QDateTime::currentDateTime().toString("hh:mm:ss.zzz");
+            writeToLogFile(QString("%1 [%2] %3%4").arg(timestamp, portName, prefix, text));
+        });
+    });
     
-    // Set up timer for periodic port scanning
-    connect(portScanTimer, &QTimer::timeout, this, &MainWindow::scanAvailablePorts);
-    portScanTimer->setInterval(2000); // Scan every 2 seconds
-    portScanTimer->start();
+    // List the ports present, then follow hotplug events
+    portWatcher->start();
+    populateComPorts();
+    connect(portWatcher, &PortWatcher::portAdded, this, &MainWindow::onPortAdded);
+    connect(portWatcher, &PortWatcher::portRemoved, this, &MainWindow::onPortRemoved);
+    
+    // Identify the shell UART on boards plugged in from now on
+    probeDelayTimer->setSingleShot(true);
+    probeDelayTimer->setInterval(PROBE_DELAY_MS);
+    connect(probeDelayTimer, &QTimer::timeout, this, [this]() {
+        if (portProber->isRunning()) {
+            probeDelayTimer->start();
+            return;
+        }
+        const QStringList portNames = pendingProbePorts;
+        pendingProbePorts.clear();
+        probePorts(portNames);
+    });
+    connect(portProber, &PortProber::finished, this, &MainWindow::onProbeFinished);
+    connect(baudProber, &BaudProber::finished, this, &MainWindow::onBaudProbeFinished);
     
     // Set up timer for auto-clearing command output
     connect(autoClearTimer, &QTimer::timeout, this, &MainWindow::autoClearCommandOutput);
@@ -68,26 +118,102 @@ MainWindow::MainWindow(QWidget *parent)
     connect(flushTimer, &QTimer::timeout, this, &MainWindow::flushIncompleteData);
     flushTimer->setSingleShot(true);
     
-    // Set up timer for key management uploads
-    connect(keymgmtTimer, &QTimer::timeout, this, [this]() {
-        if (currentPemLine < pemLines.size()) {
-            QString line = pemLines[currentPemLine];
-            int secTag = mqttRadio->isChecked() ? 42 : 44;
-            QString certType = certTypeCombo->currentText().toLower();
-            sendKeymgmtLine(line, secTag, certType);
-            currentPemLine++;
-            updateKeymgmtProgress(currentPemLine, pemLines.size());
+    // Key management uploads, paced by the device's acknowledgements
+    keymgmtUploader->setDevice(device);
+    connect(keymgmtUploader, &KeymgmtUploader::lineSent, this, [this](int current, int total, const QString &line) {
+        // Log the line being sent for debugging
+        logMessage(QString("Sent keymgmt line %1/%2: %3").arg(current).arg(total)
+                       .arg(line.isEmpty() ? QString("(empty line)") : line), "> ");
+        updateKeymgmtProgress(current, total);
+        resetAutoClearTimer();
+        loginSession->keepAlive();
+    });
+    connect(keymgmtUploader, &KeymgmtUploader::finished, this, [this]() {
+        const QString summary = QString("%1 lines, %2 bytes in %3 s (%4 lines/s)")
+                                    .arg(keymgmtUploader->acknowledgedLines())
+                                    .arg(keymgmtUploader->bytesSent())
+                                    .arg(keymgmtUploader->elapsedMs() / 1000.0, 0, 'f', 1)
+                                    .arg(keymgmtUploader->linesPerSecond(), 0, 'f', 1);
+        logMessage(QString("Certificate upload complete: %1, %2 without acknowledgement")
+                       .arg(summary).arg(keymgmtUploader->timedOutLines()), "[INFO] ");
+        keymgmtStatus->setText(QString("Upload complete! %1").arg(summary));
+        uploadButton->setEnabled(true);
+        abortButton->setEnabled(true); // Keep abort enabled after completion
+    });
+    connect(keymgmtUploader, &KeymgmtUploader::failed, this, [this](const QString &reason) {
+        logMessage(QString("Certificate upload failed: %1").arg(reason), "[ERROR] ");
+        keymgmtStatus->setText(QString("Upload failed: %1").arg(reason));
+        keymgmtStatus->setStyleSheet("color: red;");
+        uploadButton->setEnabled(true);
+        uploadProgress->setVisible(false);
+    });
+    
+    // Provisioning queue, streamed over the current login
+    provisioningQueue->setDevice(device);
+    connect(provisioningQueue, &ProvisioningQueue::itemStarted, this, [this](int index) {
+        const CertificateUpload upload = provisioningQueue->item(index).upload;
+        logMessage(QString("Uploading %1 (%2/%3)").arg(ProvisioningQueue::itemName(upload))
+                       .arg(index + 1).arg(provisioningQueue->size()), "[INFO] ");
+        setQueueRowStatus(index, "Uploading...", "blue");
+    });
+    connect(provisioningQueue, &ProvisioningQueue::itemProgress, this, [this](int index, int current, int total) {
+        setQueueRowStatus(index, QString("Uploading %1/%2").arg(current).arg(total), "blue");
+        queueProgress->setValue(qRound(provisioningQueue->overallProgress() * queueProgress->maximum()));
+        keymgmtStatus->setText(QString("Queue item %1/%2: %3/%4 commands").arg(index + 1)
+                                   .arg(provisioningQueue->size()).arg(current).arg(total));
+        resetAutoClearTimer();
+        loginSession->keepAlive();
+    });
+    connect(provisioningQueue, &ProvisioningQueue::itemFinished, this, [this](int index, bool success, const QString &message) {
+        const ProvisioningQueue::Item item = provisioningQueue->item(index);
+        if (success) {
+            setQueueRowStatus(index, QString("Done (%1 s)").arg(item.elapsedMs / 1000.0, 0, 'f', 1), "green");
+            logMessage(QString("Uploaded %1 in %2 s").arg(ProvisioningQueue::itemName(item.upload))
+                           .arg(item.elapsedMs / 1000.0, 0, 'f', 1), "[INFO] ");
         } else {
-            keymgmtTimer->stop();
-            keymgmtStatus->setText("Upload complete!");
-            uploadButton->setEnabled(true);
-            abortButton->setEnabled(true); // Keep abort enabled after completion
+            setQueueRowStatus(index, QString("Failed: %1").arg(message), "red");
+            logMessage(QString("Upload of %1 failed: %2").arg(ProvisioningQueue::itemName(item.upload), message), "[ERROR] ");
+        }
+        queueProgress->setValue(qRound(provisioningQueue->overallProgress() * queueProgress->maximum()));
+    });
+    connect(provisioningQueue, &ProvisioningQueue::finished, this, [this](int succeeded, int failed) {
+        for (int row = 0; row < provisioningQueue->size(); ++row) {
+            if (provisioningQueue->item(row).state == ProvisioningQueue::Skipped) {
+                setQueueRowStatus(row, "Skipped", "gray");
+            }
         }
+        keymgmtStatus->setText(QString("Queue finished: %1 uploaded, %2 failed or skipped").arg(succeeded).arg(failed));
+        keymgmtStatus->setStyleSheet(failed == 0 ? "color: green;" : "color: red;");
+        logMessage(keymgmtStatus->text(), failed == 0 ? "[INFO] " : "[ERROR] ");
+        uploadQueueButton->setEnabled(true);
+        uploadButton->setEnabled(!keymgmtUploader->lines().isEmpty());
+        queueTable->setEnabled(true);
     });
     
-    // Set up timer for login timeout
-    connect(loginTimeoutTimer, &QTimer::timeout, this, &MainWindow::handleLoginTimeout);
-    loginTimeoutTimer->setSingleShot(true);
+    // Login state machine; the window only reflects its state
+    loginSession->setDevice(device);
+    connect(loginSession, &LoginSession::message, this, &MainWindow::logMessage);
+    connect(loginSession, &LoginSession::deviceReady, this, [this]() {
+        statusLabel->setText("Connected (Login Required)");
+        statusLabel->setStyleSheet("color: orange; font-weight: bold;");
+    });
+    connect(loginSession, &LoginSession::loggedIn, this, [this]() {
+        statusLabel->setText("Connected & Logged In");
+        statusLabel->setStyleSheet("color: green; font-weight: bold;");
+        closeLoginDialog();
+    });
+    connect(loginSession, &LoginSession::loginFailed, this, [this](const QString &reason) {
+        updateLoginDialogStatus(reason, "red");
+    });
+    connect(loginSession, &LoginSession::retryAvailable, this, [this]() {
+        updateLoginDialogStatus("Login failed - click Retry to try again", "orange");
+        enableLoginDialogRetry();
+    });
+    connect(loginSession, &LoginSession::loginTimedOut, this, [this]() {
+        statusLabel->setText("Connected (Login Required)");
+        statusLabel->setStyleSheet("color: orange; font-weight: bold;");
+        updateLoginDialogStatus("Login timeout - please retry", "red");
+    });
     
     logMessage("Configuration GUI v1.0", "[INFO] ");
     logMessage("Ready for serial communication", "[INFO] ");
@@ -101,29 +227,29 @@ MainWindow::~MainWindow()
         disconnectFromPort();
     }
     
-    if (logFile) {
-        logFile->close();
-        delete logFile;
-    }
+    // Ports give their pool thread back only when deleted, so the main
+    // port and the sessions have to go before the pool does
+    delete serialPort;
+    serialPort = nullptr;
+    device = nullptr;
+    delete sessionManager;
+    
+    // Writes out any queued lines before returning
+    delete logWriter;
 }
 
 void MainWindow::initializeLogFile()
 {
-    // Create logs directory if it doesn't exist
-    QDir logsDir("logs");
-    if (!logsDir.exists()) {
-        logsDir.mkpath(".");
+    // Creates logs/ if needed; the file is written and rotated on the
+    // writer's own thread
+    QString error;
+    if (!logWriter->start(&error)) {
+        logMessage(error, "[WARNING] ");
+        return;
     }
     
-    logFileName = "logs/" + logFileName;
-    logFile = new QFile(logFileName);
-    
-    if (logFile->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-        QTextStream stream(logFile);
-        stream << "=== Configuration GUI Log Started: " 
-               << QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss") << " ===\n";
-        stream.flush();
-    }
+    logWriter->write(QString("=== Configuration GUI Log Started: %1 ===")
+                         .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss")));
 }
 
 void MainWindow::setupUI()
@@ -149,9 +275,89 @@ void MainWindow::createMenuBar()
 {
     QMenuBar *menuBar = this->menuBar();
     
+    // Capture menu - raw RX/TX recording for reproducing field issues
+    QMenu *captureMenu = menuBar->addMenu("&Capture");
+    startCaptureAction = captureMenu->addAction("&Start Raw Capture...");
+    stopCaptureAction = captureMenu->addAction("S&top Raw Capture");
+    stopCaptureAction->setEnabled(false);
+    connect(startCaptureAction, &QAction::triggered, this, &MainWindow::startCapture);
+    connect(stopCaptureAction, &QAction::triggered, this, &MainWindow::stopCapture);
+    captureMenu->addSeparator();
+    startReplayAction = captureMenu->addAction("&Replay Session...");
+    stopReplayAction = captureMenu->addAction("Stop Re&play");
+    stopReplayAction->setEnabled(false);
+    connect(startReplayAction, &QAction::triggered, this, &MainWindow::startReplay);
+    connect(stopReplayAction, &QAction::triggered, this, &MainWindow::stopReplay);
+    
+    // View menu - how often the output panes repaint
+    QMenu *viewMenu = menuBar->addMenu("&View");
+    QMenu *refreshMenu = viewMenu->addMenu("Display &Refresh");
+    QActionGroup *refreshGroup = new QActionGroup(this);
+    const struct { const char *label; int intervalMs; } refreshRates[] = {
+        { "60 Hz", 16 },
+        { "30 Hz", 33 },
+        { "10 Hz", 100 },
+    };
+    for (const auto &rate : refreshRates) {
+        QAction *rateAction = refreshMenu->addAction(rate.label);
+        rateAction->setCheckable(true);
+        rateAction->setChecked(rate.intervalMs == updateBatcher->interval());
+        refreshGroup->addAction(rateAction);
+        const int intervalMs = rate.intervalMs;
+        connect(rateAction, &QAction::triggered, this, [this, intervalMs]() {
+            updateBatcher->setInterval(intervalMs);
+        });
+    }
+    
+    // Serial menu - line settings, applied on the next connect
+    QMenu *serialMenu = menuBar->addMenu("&Serial");
+    QMenu *flowMenu = serialMenu->addMenu("&Flow Control");
+    QActionGroup *flowGroup = new QActionGroup(this);
+    const struct { const char *label; SerialSettings::FlowControl flowControl; } flowControls[] = {
+        { "None", SerialSettings::NoFlowControl },
+        { "RTS/CTS (Hardware)", SerialSettings::HardwareFlowControl },
+        { "XON/XOFF (Software)", SerialSettings::SoftwareFlowControl },
+    };
+    for (const auto &flow : flowControls) {
+        QAction *flowAction = flowMenu->addAction(flow.label);
+        flowAction->setCheckable(true);
+        flowAction->setChecked(flow.flowControl == serialSettings.flowControl);
+        flowGroup->addAction(flowAction);
+        const SerialSettings::FlowControl flowControl = flow.flowControl;
+        const QString label = flow.label;
+        connect(flowAction, &QAction::triggered, this, [this, flowControl, label]() {
+            serialSettings.flowControl = flowControl;
+            logMessage(QString("Flow control: %1 (applies on the next connect)").arg(label), "[INFO] ");
+        });
+    }
+    QMenu *framingMenu = serialMenu->addMenu("F&raming");
+    QActionGroup *framingGroup = new QActionGroup(this);
+    const char *framings[] = { "8N1", "8E1", "8O1", "8N2", "7E1", "7O1" };
+    for (const char *framing : framings) {
+        QAction *framingAction = framingMenu->addAction(framing);
+        framingAction->setCheckable(true);
+        framingAction->setChecked(framing == serialSettings.framing());
+        framingGroup->addAction(framingAction);
+        const QString text = framing;
+        connect(framingAction, &QAction::triggered, this, [this, text]() {
+            serialSettings.setFraming(text);
+            logMessage(QString("Framing: %1 (applies on the next connect)").arg(text), "[INFO] ");
+        });
+    }
+    
+    // Devices menu - more boards alongside the main one, a tab each
+    QMenu *devicesMenu = menuBar->addMenu("&Devices");
+    QAction *openDeviceAction = devicesMenu->addAction("&Open Additional Device...");
+    connect(openDeviceAction, &QAction::triggered, this, &MainWindow::openAdditionalDevice);
+    
     // Help menu
     QMenu *helpMenu = menuBar->addMenu("&Help");
     
+    // Statistics action
+    QAction *statsAction = new QAction("&Statistics", this);
+    connect(statsAction, &QAction::triggered, this, &MainWindow::showStatistics);
+    helpMenu->addAction(statsAction);
+    
     // About action
     QAction *aboutAction = new QAction("&About", this);
     aboutAction->setShortcut(QKeySequence::HelpContents);
@@ -188,6 +394,9 @@ void MainWindow::createToolbar()
     toolbarLayout->addWidget(comPortCombo);
     connect(comPortCombo, QOverload<const QString &>::of(&QComboBox::currentTextChanged),
             this, &MainWindow::onComPortChanged);
+    connect(comPortCombo, QOverload<int>::of(&QComboBox::activated), this, [this]() {
+        dualWritePort.clear(); // Picked by hand: single port
+    });
     
     // Refresh ports button
     refreshPortsButton = new QPushButton("🔄");
@@ -197,6 +406,14 @@ void MainWindow::createToolbar()
     toolbarLayout->addWidget(refreshPortsButton);
     connect(refreshPortsButton, &QPushButton::clicked, this, &MainWindow::refreshSerialPorts);
     
+    // Find the shell port(s) by probing
+    detectPortsButton = new QPushButton("🔍");
+    detectPortsButton->setFixedWidth(23);
+    detectPortsButton->setFixedHeight(20);
+    detectPortsButton->setToolTip("Detect the device shell port (single or dual UART)");
+    toolbarLayout->addWidget(detectPortsButton);
+    connect(detectPortsButton, &QPushButton::clicked, this, &MainWindow::detectPorts);
+    
     toolbarLayout->addSpacing(10);
     
     // Baud rate selection
@@ -206,7 +423,9 @@ void MainWindow::createToolbar()
     toolbarLayout->addWidget(baudLabel);
     
     baudRateCombo = new QComboBox;
-    baudRateCombo->setFixedWidth(69); // 60 * 1.15 = 69
+    baudRateCombo->setEditable(true); // Any rate the adapter supports can be typed in
+    baudRateCombo->setInsertPolicy(QComboBox::NoInsert);
+    baudRateCombo->setFixedWidth(80); // Fits 1000000
     baudRateCombo->setFixedHeight(20);
     toolbarLayout->addWidget(baudRateCombo);
     connect(baudRateCombo, QOverload<const QString &>::of(&QComboBox::currentTextChanged),
@@ -304,12 +523,39 @@ void MainWindow::setupSerialTerminalTab()
     serialTerminalTab = new QWidget;
     QVBoxLayout *terminalLayout = new QVBoxLayout(serialTerminalTab);
     
-    terminal = new QTextEdit;
-    terminal->setReadOnly(false); // Allow text selection and copying
-    terminal->setFont(QFont("Consolas", 9));
-    terminal->setMinimumHeight(400);
+    // Level/module filter over the parsed log records
+    QHBoxLayout *filterLayout = new QHBoxLayout;
+    filterLayout->addWidget(new QLabel("Show:"));
+    levelFilterCombo = new QComboBox;
+    levelFilterCombo->addItem("All levels", LogStore::AllLevels);
+    levelFilterCombo->addItem("Info and above", LogStore::levelBit(LogStore::Info)
+                              | LogStore::levelBit(LogStore::Warning) | LogStore::levelBit(LogStore::Error));
+    levelFilterCombo->addItem("Warnings and errors", LogStore::levelBit(LogStore::Warning)
+                              | LogStore::levelBit(LogStore::Error));
+    levelFilterCombo->addItem("Errors only", LogStore::levelBit(LogStore::Error));
+    filterLayout->addWidget(levelFilterCombo);
+    moduleFilterCombo = new QComboBox;
+    moduleFilterCombo->addItem("All modules", -1);
+    moduleFilterCombo->setMinimumWidth(140);
+    filterLayout->addWidget(moduleFilterCombo);
+    filterLayout->addStretch();
+    terminalLayout->addLayout(filterLayout);
+    
+    terminalModel = new LogListModel(&logStore, "hh:mm:ss.zzz", updateBatcher, this);
+    terminal = createLogView(terminalModel);
     terminalLayout->addWidget(terminal);
     
+    connect(levelFilterCombo, &QComboBox::currentIndexChanged, this, &MainWindow::applyLogFilter);
+    connect(moduleFilterCombo, &QComboBox::currentIndexChanged, this, &MainWindow::applyLogFilter);
+    
+    // Follow new output unless the user scrolled up
+    connect(terminalModel, &LogListModel::rowsFlushed, this, [this]() {
+        updateModuleFilter();
+        if (!userScrolling) {
+            terminal->scrollToBottom();
+        }
+    });
+    
     // Connect scrollbar signals to track user scrolling
     connect(terminal->verticalScrollBar(), &QScrollBar::valueChanged, this, [this](int value) {
         QScrollBar *scrollBar = terminal->verticalScrollBar();
@@ -358,16 +604,65 @@ void MainWindow::setupCommandInterfaceTab()
     commandLayout->addLayout(inputLayout);
     
     // Command output area below
-    commandOutput = new QTextEdit;
-    commandOutput->setReadOnly(true);
-    commandOutput->setFont(QFont("Consolas", 9));
-    commandOutput->setMinimumHeight(400);
-    commandOutput->setStyleSheet("QTextEdit { background-color: #f8f8f8; }");
+    commandModel = new LogListModel(&commandStore, "[hh:mm:ss]", updateBatcher, this);
+    commandOutput = createLogView(commandModel);
+    commandOutput->setStyleSheet("QListView { background-color: #f8f8f8; }");
     commandLayout->addWidget(commandOutput);
+    connect(commandModel, &LogListModel::rowsFlushed, commandOutput, &QListView::scrollToBottom);
     
     mainTabWidget->addTab(commandInterfaceTab, "Command Interface");
 }
 
+void MainWindow::applyLogFilter()
+{
+    terminalModel->setFilter(levelFilterCombo->currentData().toUInt(), moduleFilterCombo->currentData().toInt());
+    if (!userScrolling) {
+        terminal->scrollToBottom();
+    }
+}
+
+void MainWindow::updateModuleFilter()
+{
+    // Module ids only ever grow, so new modules are appended in id order
+    const QStringList modules = logStore.modules();
+    for (int id = moduleFilterCombo->count(); id < modules.size(); ++id) {
+        moduleFilterCombo->addItem(modules[id], id);
+    }
+}
+
+QListView *MainWindow::createLogView(LogListModel *model)
+{
+    QListView *view = new QListView;
+    view->setModel(model);
+    view->setFont(QFont("Consolas", 9));
+    view->setMinimumHeight(400);
+    
+    // Fixed row height lets the view skip laying out anything off screen
+    view->setUniformItemSizes(true);
+    view->setWordWrap(false);
+    view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    view->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    view->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    
+    // Copy selected lines (the panes used to be selectable text edits)
+    QAction *copyAction = new QAction("Copy", view);
+    copyAction->setShortcut(QKeySequence::Copy);
+    copyAction->setShortcutContext(Qt::WidgetShortcut);
+    view->addAction(copyAction);
+    view->setContextMenuPolicy(Qt::ActionsContextMenu);
+    connect(copyAction, &QAction::triggered, view, [view, model]() {
+        QModelIndexList selected = view->selectionModel()->selectedRows();
+        std::sort(selected.begin(), selected.end());
+        QStringList lines;
+        for (const QModelIndex &index : selected) {
+            lines.append(model->rowText(index.row()));
+        }
+        QApplication::clipboard()->setText(lines.join('\n'));
+    });
+    
+    return view;
+}
+
 void MainWindow::setupConfigTab()
 {
     configTab = new QWidget;
@@ -450,70 +745,173 @@ void MainWindow::setupBackupTab()
     mainTabWidget->addTab(backupTab, "Backup");
 }
 
-void MainWindow::scanAvailablePorts()
+void MainWindow::populateComPorts()
+{
+    comPortCombo->clear();
+    const QList<PortInfo> ports = portWatcher->ports();
+    QStringList names;
+    for (const PortInfo &info : ports) {
+        comPortCombo->addItem(info.portName);
+        comPortCombo->setItemData(comPortCombo->count() - 1, info.details(), Qt::ToolTipRole);
+        names << info.portName;
+    }
+    
+    if (names.isEmpty()) {
+        logMessage("No serial ports found", "[WARNING] ");
+    } else {
+        logMessage(QString("Found %1 available serial port(s): %2")
+                  .arg(names.size())
+                  .arg(names.join(", ")), "[INFO] ");
+    }
+    if (!portWatcher->isEventDriven()) {
+        logMessage("Hotplug notifications unavailable, polling for serial ports", "[INFO] ");
+    }
+}
+
+void MainWindow::onPortAdded(const PortInfo &info)
 {
-    QStringList availablePorts;
+    // The combo box mirrors the watcher's natural order (COM2 before COM10)
+    const QList<PortInfo> ports = portWatcher->ports();
+    int index = 0;
+    while (index < ports.size() && ports[index].portName != info.portName) {
+        ++index;
+    }
+    comPortCombo->insertItem(index, info.portName);
+    comPortCombo->setItemData(index, info.details(), Qt::ToolTipRole);
     
-    // Get all available serial ports using Qt6 SerialPort
-    const auto infos = QSerialPortInfo::availablePorts();
-    for (const QSerialPortInfo &info : infos) {
-        availablePorts << info.portName();
+    logMessage(QString("Serial port added: %1%2")
+              .arg(info.portName)
+              .arg(info.description.isEmpty() ? QString() : QString(" (%1)").arg(info.description)), "[INFO] ");
+    
+    // Follow the selected device if it comes back, possibly under another name
+    if (!isConnected && info.key() == selectedPortKey) {
+        comPortCombo->setCurrentIndex(index);
     }
     
-    // Sort ports numerically (COM1, COM2, etc.)
-    std::sort(availablePorts.begin(), availablePorts.end(), [](const QString &a, const QString &b) {
-        // Extract numbers from COM port names
-        int numA = a.mid(3).toInt();
-        int numB = b.mid(3).toInt();
-        return numA < numB;
-    });
+    if (!isConnected) {
+        pendingProbePorts << info.portName;
+        probeDelayTimer->start();
+    }
+}
+
+void MainWindow::onPortRemoved(const PortInfo &info)
+{
+    const int index = comPortCombo->findText(info.portName);
+    if (index >= 0) {
+        // Removing the current item selects another; remember the device
+        // the user picked so it is selected again when it reappears
+        const QString key = selectedPortKey;
+        comPortCombo->removeItem(index);
+        if (info.key() == key) {
+            selectedPortKey = key;
+        }
+    }
     
-    // Update combo box if ports have changed
-    QString currentSelection = comPortCombo->currentText();
-    QStringList currentPorts;
-    for (int i = 0; i < comPortCombo->count(); ++i) {
-        currentPorts << comPortCombo->itemText(i);
+    pendingProbePorts.removeAll(info.portName);
+    if (!isConnected && info.portName == dualWritePort) {
+        dualWritePort.clear();
     }
     
-    if (currentPorts != availablePorts) {
-        comPortCombo->clear();
-        if (!availablePorts.isEmpty()) {
-            comPortCombo->addItems(availablePorts);
-            
-            // Try to maintain current selection if it's still available
-            if (!currentSelection.isEmpty() && availablePorts.contains(currentSelection)) {
-                comPortCombo->setCurrentText(currentSelection);
-            } else {
-                comPortCombo->setCurrentIndex(0);
-                currentComPort = comPortCombo->currentText();
-            }
-            
-            logMessage(QString("Found %1 available serial port(s): %2")
-                      .arg(availablePorts.size())
-                      .arg(availablePorts.join(", ")), "[INFO] ");
-        } else {
-            logMessage("No serial ports found", "[WARNING] ");
+    logMessage(QString("Serial port removed: %1").arg(info.portName),
+               isConnected && (info.portName == currentComPort || info.portName == dualWritePort)
+               ? "[WARNING] " : "[INFO] ");
+}
+
+void MainWindow::detectPorts()
+{
+    if (isConnected) {
+        logMessage("Disconnect before detecting ports", "[WARNING] ");
+        return;
+    }
+    
+    probeDelayTimer->stop();
+    pendingProbePorts.clear();
+    QStringList portNames;
+    const QList<PortInfo> ports = portWatcher->ports();
+    for (const PortInfo &info : ports) {
+        portNames << info.portName;
+    }
+    probePorts(portNames);
+}
+
+bool MainWindow::isSessionPort(const QString &portName) const
+{
+    const DeviceSession *session = sessionManager->findSession(portName);
+    return session && session->isOpen();
+}
+
+void MainWindow::probePorts(const QStringList &candidates)
+{
+    // Opens aren't exclusive everywhere; a probe on a board another tab
+    // has open would type into its shell and steal its RX bytes
+    QStringList portNames;
+    for (const QString &portName : candidates) {
+        if (!isSessionPort(portName)) {
+            portNames << portName;
         }
     }
+    if (isConnected || baudProber->isRunning() || portNames.isEmpty()) {
+        return;
+    }
+    
+    logMessage(QString("Probing %1 for the device shell...").arg(portNames.join(", ")), "[INFO] ");
+    detectPortsButton->setEnabled(false);
+    portProber->probe(portNames, currentBaudRate > 0 ? currentBaudRate : autoBaudRate);
 }
 
-void MainWindow::populateComPorts()
+void MainWindow::onProbeFinished()
 {
-    // This function is now replaced by scanAvailablePorts()
-    // Keeping it for backward compatibility
-    scanAvailablePorts();
+    detectPortsButton->setEnabled(true);
+    
+    const QList<ProbeResult> results = portProber->results();
+    for (const ProbeResult &result : results) {
+        QString text = QString("%1: %2").arg(result.portName, ProbeResult::roleName(result.role));
+        if (!result.answeredOn.isEmpty()) {
+            text += QString(", answered on %1").arg(result.answeredOn);
+        }
+        if (result.responseMs >= 0) {
+            text += QString(" (%1 ms)").arg(result.responseMs);
+        }
+        if (!result.error.isEmpty()) {
+            text += QString(" - %1").arg(result.error);
+        }
+        logMessage(QString("Probe %1").arg(text), "[INFO] ");
+    }
+    
+    const ProbeChoice choice = PortProber::choose(results);
+    if (!choice.found) {
+        logMessage(QString("No device shell found (%1 ms)").arg(portProber->elapsedMs()), "[WARNING] ");
+        return;
+    }
+    if (isConnected) {
+        return;
+    }
+    
+    comPortCombo->setCurrentText(choice.readPort);
+    dualWritePort = choice.writePort;
+    if (choice.dual) {
+        logMessage(QString("Detected device shell: reading %1, writing %2 (dual port, %3 ms)")
+                  .arg(choice.readPort, choice.writePort)
+                  .arg(portProber->elapsedMs()), "[INFO] ");
+    } else {
+        logMessage(QString("Detected device shell on %1 (%2 ms)")
+                  .arg(choice.readPort)
+                  .arg(portProber->elapsedMs()), "[INFO] ");
+    }
 }
 
 void MainWindow::refreshSerialPorts()
 {
     logMessage("Manually refreshing serial ports...", "[INFO] ");
-    scanAvailablePorts();
+    portWatcher->rescan();
 }
 
 void MainWindow::populateBaudRates()
 {
     baudRateCombo->clear();
-    QStringList baudRates = {"9600", "19200", "38400", "57600", "115200"};
+    // "Auto" finds the rate when connecting
+    QStringList baudRates = {"Auto", "9600", "19200", "38400", "57600", "115200",
+                             "230400", "460800", "921600", "1000000"};
     baudRateCombo->addItems(baudRates);
     // Set the current baud rate (115200) as the default selection
     baudRateCombo->setCurrentText("115200");
@@ -522,14 +920,21 @@ void MainWindow::populateBaudRates()
 void MainWindow::onComPortChanged()
 {
     currentComPort = comPortCombo->currentText();
+    selectedPortKey = portWatcher->port(currentComPort).key();
     logMessage(QString("Selected COM port: %1").arg(currentComPort), "[INFO] ");
 }
 
 void MainWindow::onBaudRateChanged()
 {
+    const QString text = baudRateCombo->currentText().trimmed();
+    if (text.compare("Auto", Qt::CaseInsensitive) == 0) {
+        currentBaudRate = 0;
+        return;
+    }
+    
     bool ok;
-    int baudRate = baudRateCombo->currentText().toInt(&ok);
-    if (ok) {
+    int baudRate = text.toInt(&ok);
+    if (ok && baudRate > 0) {
         currentBaudRate = baudRate;
     }
 }
@@ -545,34 +950,192 @@ void MainWindow::toggleConnection()
 
 void MainWindow::connectToPort()
 {
-    // Use single COM port for Nordic terminal
-    bool success = serialPort->open(currentComPort, currentBaudRate);
+    // device and the login/keymgmt/queue helpers point at the replay
+    if (replaySource) {
+        QMessageBox::warning(this, "Connection Error", "Stop the replay before connecting to a device.");
+        return;
+    }
+    
+    // The probe has the ports open; the user's choice wins
+    portProber->abort();
+    probeDelayTimer->stop();
+    pendingProbePorts.clear();
+    detectPortsButton->setEnabled(true);
+    
+    const QString busyPort = isSessionPort(currentComPort) ? currentComPort
+        : !dualWritePort.isEmpty() && isSessionPort(dualWritePort) ? dualWritePort : QString();
+    if (!busyPort.isEmpty()) {
+        QMessageBox::warning(this, "Connection Error",
+                            QString("%1 is already open in its own device tab").arg(busyPort));
+        return;
+    }
+    
+    if (currentBaudRate == 0) {
+        detectBaudRate(); // Connects when a rate is found
+        return;
+    }
+    openPort(currentBaudRate);
+}
+
+void MainWindow::openPort(int baudRate)
+{
+    serialPort->setDeviceProfile(deviceProfile());
+    
+    // One port for the Nordic shell, or a read/write pair found by the probe
+    bool success = dualWritePort.isEmpty()
+        ? serialPort->open(currentComPort, baudRate)
+        : serialPort->openDual(currentComPort, dualWritePort, baudRate);
     
     if (success) {
-        logMessage(QString("Connected to %1 at %2 baud").arg(currentComPort, QString::number(currentBaudRate)));
+        if (dualWritePort.isEmpty()) {
+            logMessage(QString("Connected to %1 at %2 baud, %3").arg(currentComPort, QString::number(baudRate), serialSettings.framing()));
+        } else {
+            logMessage(QString("Connected to %1 (read) and %2 (write) at %3 baud, %4")
+                      .arg(currentComPort, dualWritePort, QString::number(baudRate), serialSettings.framing()));
+        }
         logMessage("Establishing connection...", "[INFO] ");
         
         isConnected = true;
-        isLoggedIn = false; // Reset login state on new connection
+        loginSession->reset(); // Reset login state on new connection
+        reportedDroppedBytes = 0;
+        rxPipeline.reset();
         connectButton->setText("Disconnect");
         statusLabel->setText("Connecting...");
         statusLabel->setStyleSheet("color: orange; font-weight: bold;");
-        
-        // Start timer for data checking immediately to monitor for "messages dropped"
-        dataTimer->start();
     } else {
         QMessageBox::critical(this, "Connection Error",
                             QString("Failed to connect: %1").arg(serialPort->errorString()));
     }
 }
 
+DeviceProfile MainWindow::deviceProfile() const
+{
+    // Flow control holds writes back when the device is busy; without it
+    // the default pacing has to
+    DeviceProfile profile;
+    if (serialSettings.flowControl != SerialSettings::NoFlowControl) {
+        profile = DeviceProfile::lineRate(serialSettings);
+    } else {
+        profile.serial = serialSettings;
+    }
+    return profile;
+}
+
+void MainWindow::openAdditionalDevice()
+{
+    // Any port not already in use here, including the main board's write
+    // port when it reads and writes on different ones
+    QStringList portNames;
+    for (const PortInfo &info : portWatcher->ports()) {
+        const bool mainPort = info.portName == currentComPort
+            || (!dualWritePort.isEmpty() && info.portName == dualWritePort);
+        if ((mainPort && isConnected) || isSessionPort(info.portName)) {
+            continue;
+        }
+        portNames.append(info.portName);
+    }
+    if (portNames.isEmpty()) {
+        QMessageBox::information(this, "Open Additional Device", "No free serial ports found.");
+        return;
+    }
+    
+    bool ok = false;
+    const QString portName = QInputDialog::getItem(this, "Open Additional Device", "Serial port:",
+                                                   portNames, 0, false, &ok);
+    if (!ok || portName.isEmpty()) {
+        return;
+    }
+    
+    // Same line settings as the main board; Auto uses the last rate found
+    const int baudRate = currentBaudRate > 0 ? currentBaudRate : autoBaudRate;
+    DeviceSession *session = sessionManager->session(portName);
+    
+    // A board that dropped off keeps its tab; reconnect it there
+    SessionView *view = nullptr;
+    for (int i = 0; i < mainTabWidget->count() && !view; ++i) {
+        view = qobject_cast<SessionView *>(mainTabWidget->widget(i));
+        if (view && view->session() != session) {
+            view = nullptr;
+        }
+    }
+    
+    if (!session->open(baudRate, deviceProfile())) {
+        QMessageBox::critical(this, "Connection Error",
+                            QString("Failed to connect to %1: %2").arg(portName, session->errorString()));
+        if (!view) {
+            sessionManager->removeSession(portName);
+        }
+        return;
+    }
+    
+    if (view) {
+        mainTabWidget->setCurrentWidget(view);
+        return;
+    }
+    
+    view = new SessionView(session, updateBatcher);
+    connect(view, &SessionView::closeRequested, this, [this, view]() {
+        closeSessionView(view);
+    });
+    mainTabWidget->setCurrentIndex(mainTabWidget->addTab(view, portName));
+    logMessage(QString("Opened %1 in its own tab (%2 boards on %3 I/O threads)")
+                   .arg(portName)
+                   .arg(sessionManager->openCount())
+                   .arg(sessionManager->ioPool()->threadCount()), "[INFO] ");
+}
+
+void MainWindow::closeSessionView(SessionView *view)
+{
+    const QString portName = view->session()->portName();
+    mainTabWidget->removeTab(mainTabWidget->indexOf(view));
+    view->deleteLater();
+    sessionManager->removeSession(portName);
+}
+
+void MainWindow::detectBaudRate()
+{
+    logMessage(QString("Detecting baud rate on %1...").arg(currentComPort), "[INFO] ");
+    connectButton->setEnabled(false);
+    baudProber->probe(currentComPort, dualWritePort, BaudProber::candidateRates(autoBaudRate));
+}
+
+void MainWindow::onBaudProbeFinished()
+{
+    connectButton->setEnabled(true);
+    
+    QStringList tried;
+    const QList<BaudScore> scores = baudProber->scores();
+    for (const BaudScore &score : scores) {
+        if (!score.error.isEmpty()) {
+            tried << QString("%1 (%2)").arg(score.baudRate).arg(score.error);
+        } else {
+            tried << QString("%1 (%2 bytes, %3% text%4)")
+                     .arg(score.baudRate)
+                     .arg(score.bytes)
+                     .arg(qRound(score.printable * 100))
+                     .arg(score.prompts > 0 ? ", prompt" : "");
+        }
+    }
+    logMessage(QString("Baud rates tried: %1").arg(tried.join(", ")), "[INFO] ");
+    
+    const int baudRate = baudProber->detectedBaudRate();
+    if (baudRate == 0) {
+        QMessageBox::warning(this, "Baud Rate Detection",
+                             QString("No baud rate on %1 produced shell or log output. "
+                                     "Select the rate by hand.").arg(currentComPort));
+        return;
+    }
+    
+    logMessage(QString("Detected %1 baud (%2 ms)").arg(baudRate).arg(baudProber->elapsedMs()), "[INFO] ");
+    autoBaudRate = baudRate;
+    openPort(baudRate);
+}
+
 void MainWindow::disconnectFromPort()
 {
-    dataTimer->stop();
     serialPort->close();
     isConnected = false;
-    isLoggedIn = false; // Reset login state on disconnect
-    loginTimeoutTimer->stop(); // Stop login timeout timer
+    loginSession->reset(); // Reset login state and its timeout on disconnect
     connectButton->setText("Connect");
     statusLabel->setText("Disconnected");
     statusLabel->setStyleSheet("color: red; font-weight: bold;");
@@ -595,9 +1158,9 @@ void MainWindow::sendCommand()
         QString commandToSend = command + "\n";
         
         QByteArray data = commandToSend.toUtf8();
-        qint64 bytesWritten = serialPort->write(data);
         
-        if (bytesWritten == data.size()) {
+        // Queued for the I/O thread; failures arrive via writeFailed()
+        if (device->enqueue(data)) {
             logMessage(QString("Sent: %1").arg(command), "> ");
             logCommandToOutput(command);
             commandInput->clear();
@@ -606,190 +1169,67 @@ void MainWindow::sendCommand()
             resetAutoClearTimer();
             
             // Refresh login if we're logged in (extends timeout)
-            if (isLoggedIn) {
-                refreshLogin();
+            if (loginSession->isLoggedIn()) {
+                loginSession->refresh();
             }
         } else {
-            logMessage(QString("Send failed: wrote %1 of %2 bytes").arg(QString::number(bytesWritten), QString::number(data.size())), "[ERROR] ");
+            logMessage(QString("Send failed: %1").arg(device->errorString()), "[ERROR] ");
             QMessageBox::critical(this, "Send Error",
-                                QString("Failed to send command: %1").arg(serialPort->errorString()));
+                                QString("Failed to send command: %1").arg(device->errorString()));
         }
     }
 }
 
-void MainWindow::checkForData()
+void MainWindow::readData()
 {
-    if (isConnected && serialPort->hasData()) {
-        readData();
+    // Drain the RX ring in bounded batches so a log flood can't starve
+    // typing and repainting; come back for the rest on the next pass. One
+    // pass is queued at a time, however often dataReceived() fires
+    const QByteArray data = device->read(RX_BATCH_SIZE);
+    if (device->hasData() && !drainScheduled) {
+        drainScheduled = true;
+        QTimer::singleShot(0, this, [this]() {
+            drainScheduled = false;
+            readData();
+        });
     }
-}
-
-QString MainWindow::cleanAnsiCodes(const QString &input)
-{
-    QString cleaned = input;
-    
-    // Remove ANSI escape sequences
-    QRegularExpression ansiRegex(R"(\x1B\[[0-9;]*[a-zA-Z])");
-    cleaned = cleaned.remove(ansiRegex);
     
-    // Remove terminal control sequences like [8D[J
-    QRegularExpression controlRegex(R"(\[[0-9]*[A-Z]\[[0-9]*[A-Z])");
-    cleaned = cleaned.remove(controlRegex);
+    const quint64 dropped = device->droppedBytes();
+    if (dropped > reportedDroppedBytes) {
+        logMessage(QString("RX buffer overflow - %1 bytes dropped").arg(dropped - reportedDroppedBytes), "[WARNING] ");
+        reportedDroppedBytes = dropped;
+    }
     
-    // Remove color codes like [1;33m, [0m, [1;32m
-    QRegularExpression colorRegex(R"(\[[0-9;]*m)");
-    cleaned = cleaned.remove(colorRegex);
+    if (data.isEmpty()) {
+        return;
+    }
     
-    // Remove cursor positioning codes
-    QRegularExpression cursorRegex(R"(\x1B\[[0-9]*[ABCD])");
-    cleaned = cleaned.remove(cursorRegex);
+    // Only the new bytes are parsed; partial lines and escape sequences
+    // carry over to the next chunk
+    QStringList logLines, commandLines;
+    rxPipeline.feed(data, logLines, commandLines);
+    keymgmtUploader->handleReceived(commandLines, rxPipeline.parser().promptCount());
+    provisioningQueue->handleReceived(commandLines, rxPipeline.parser().promptCount());
+    dispatchLines(logLines, commandLines);
     
-    // Remove other control characters except newlines and carriage returns
-    QString result;
-    for (QChar ch : cleaned) {
-        if (ch == '\n' || ch == '\r' || (ch.unicode() >= 32 && ch.unicode() < 127)) {
-            result += ch;
-        }
+    if (rxPipeline.hasPartialLine()) {
+        // Incomplete message - start flush timer for line reconstruction
+        flushTimer->start(LINE_RECONSTRUCTION_TIMEOUT);
+    } else {
+        flushTimer->stop();
     }
-    
-    return result;
 }
 
-QString MainWindow::filterShellPrompts(const QString &input)
+void MainWindow::dispatchLines(const QStringList &logLines, const QStringList &commandLines)
 {
-    QString filtered = input;
-    
-    // Remove shell prompts like "uart:~$ " and variations
-    QRegularExpression shellPromptRegex(R"(uart:~\$?\s*)");
-    filtered = filtered.remove(shellPromptRegex);
-    
-    // Remove "dev>" shell prompt (activated when logged in)
-    QRegularExpression devPromptRegex(R"(dev>\s*)");
-    filtered = filtered.remove(devPromptRegex);
-    
-    // Remove "login>" shell prompt
-    QRegularExpression loginPromptRegex(R"(login>\s*)");
-    filtered = filtered.remove(loginPromptRegex);
-    
-    // Remove other common shell prompts
-    QRegularExpression genericPromptRegex(R"([a-zA-Z0-9_-]+:~?\$?\s*)");
-    filtered = filtered.remove(genericPromptRegex);
-    
-    // Remove the 'x' shell line start marker completely
-    filtered = filtered.remove('x');
-    
-    // Remove standalone 'x' characters that are shell markers
-    QRegularExpression xMarkerRegex(R"(^x\s*$)");
-    filtered = filtered.remove(xMarkerRegex);
-    
-    // Remove lines that start with 'x' followed by whitespace
-    QRegularExpression xStartRegex(R"(^x\s+)");
-    filtered = filtered.remove(xStartRegex);
-    
-    // Remove empty lines that might be left after filtering
-    QStringList lines = filtered.split('\n', Qt::SkipEmptyParts);
-    filtered = lines.join('\n');
+    // Send log lines to terminal
+    if (!logLines.isEmpty()) {
+        logMessage(logLines.join('\n'), "");
+    }
     
-    return filtered;
-}
-
-void MainWindow::readData()
-{
-    const QByteArray data = serialPort->readAll();
-    if (!data.isEmpty()) {
-        // Convert to string and handle potential encoding issues
-        QString receivedData;
-        
-        // Try UTF-8 first
-        receivedData = QString::fromUtf8(data);
-        
-        // If UTF-8 fails, try other encodings
-        if (receivedData.isEmpty() && !data.isEmpty()) {
-            receivedData = QString::fromLatin1(data);
-        }
-        
-        // If still empty, use raw bytes
-        if (receivedData.isEmpty() && !data.isEmpty()) {
-            receivedData = QString::fromLocal8Bit(data);
-        }
-        
-        // Accumulate data for better message handling
-        accumulatedData += receivedData;
-        
-        // Limit accumulated data size to prevent memory issues
-        if (accumulatedData.length() > MAX_ACCUMULATED_SIZE) {
-            accumulatedData = accumulatedData.right(MAX_ACCUMULATED_SIZE / 2);
-        }
-        
-        // Clean ANSI codes and control sequences
-        QString cleanedData = cleanAnsiCodes(accumulatedData);
-        
-        // Filter out shell prompts
-        QString filteredData = filterShellPrompts(cleanedData);
-        
-        if (!filteredData.isEmpty()) {
-            // Replace carriage returns with newlines for proper display
-            filteredData = filteredData.replace("\r\n", "\n");
-            filteredData = filteredData.replace("\r", "\n");
-            
-            // Check if we have complete lines (ending with newline)
-            if (filteredData.endsWith('\n')) {
-                // Process complete lines with robust line reconstruction
-                QStringList lines = filteredData.split('\n', Qt::SkipEmptyParts);
-                QStringList logLines, commandLines;
-                QString currentLine;
-                
-                for (const QString &line : lines) {
-                    QString trimmedLine = line.trimmed();
-                    if (trimmedLine.isEmpty()) continue;
-                    
-                    // Check if this line is too long (likely fragmented)
-                    if (trimmedLine.length() > MAX_LINE_LENGTH) {
-                        // Split long lines that might be concatenated fragments
-                        QStringList fragments = splitLongLine(trimmedLine);
-                        for (const QString &fragment : fragments) {
-                            if (fragment.isEmpty()) continue;
-                            
-                            // Check if this fragment is a log message
-                            if (isLogMessage(fragment)) {
-                                logLines.append(fragment);
-                            } else {
-                                commandLines.append(fragment);
-                            }
-                        }
-                    } else {
-                        // Normal line processing with corruption detection
-                        if (isLogMessage(trimmedLine)) {
-                            logLines.append(trimmedLine);
-                        } else {
-                            // Additional check for corrupted log lines without tags
-                            if (isLikelyCorruptedLogLine(trimmedLine)) {
-                                logLines.append(trimmedLine);
-                            } else {
-                                commandLines.append(trimmedLine);
-                            }
-                        }
-                    }
-                }
-                
-                // Send log lines to terminal
-                if (!logLines.isEmpty()) {
-                    logMessage(logLines.join('\n'), "");
-                }
-                
-                // Send command lines to command interface
-                if (!commandLines.isEmpty()) {
-                    parseCommandOutput(commandLines.join('\n'));
-                }
-                
-                // Clear accumulated data after processing complete lines
-                accumulatedData.clear();
-                flushTimer->stop(); // Stop flush timer since we processed complete data
-            } else {
-                // Incomplete message - start flush timer for line reconstruction
-                flushTimer->start(LINE_RECONSTRUCTION_TIMEOUT);
-            }
-        }
+    // Send command lines to command interface
+    if (!commandLines.isEmpty()) {
+        parseCommandOutput(commandLines.join('\n'));
     }
 }
 
@@ -804,19 +1244,112 @@ void MainWindow::handleError(const QString &error)
 
 void MainWindow::writeToLogFile(const QString &message)
 {
-    if (logFile && logFile->isOpen()) {
-        QTextStream stream(logFile);
-        stream << message << "\n";
-        stream.flush();
+    // Only queues the line; never waits on the disk
+    logWriter->write(message);
+}
+
+void MainWindow::startCapture()
+{
+    QDir().mkpath("captures");
+    const QString defaultName = QString("captures/capture-%1.cap")
+                                    .arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"));
+    const QString fileName = QFileDialog::getSaveFileName(this, "Start Raw Capture", defaultName,
+                                                          "Serial Captures (*.cap);;All Files (*)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+    
+    // Errors are reported through errorOccurred()
+    if (serialPort->startCapture(fileName)) {
+        startCaptureAction->setEnabled(false);
+        stopCaptureAction->setEnabled(true);
+        logMessage(QString("Raw capture started: %1").arg(fileName), "[INFO] ");
+    }
+}
+
+void MainWindow::stopCapture()
+{
+    const QString fileName = serialPort->captureFileName();
+    serialPort->stopCapture();
+    startCaptureAction->setEnabled(true);
+    stopCaptureAction->setEnabled(false);
+    logMessage(QString("Raw capture saved: %1").arg(fileName), "[INFO] ");
+}
+
+void MainWindow::startReplay()
+{
+    if (isConnected || baudProber->isRunning()) {
+        QMessageBox::warning(this, "Replay Session", "Disconnect from the device before replaying a session.");
+        return;
+    }
+    
+    const QString fileName = QFileDialog::getOpenFileName(this, "Replay Session", "captures",
+                                                          "Serial Captures (*.cap);;Text Logs (*.log *.txt);;All Files (*)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+    
+    const QStringList speeds = { "Original timing", "10x", "100x", "As fast as possible" };
+    bool ok = false;
+    const QString speed = QInputDialog::getItem(this, "Replay Session", "Replay speed:", speeds, 0, false, &ok);
+    if (!ok) {
+        return;
+    }
+    
+    replaySource = new ReplaySource(this);
+    if (!replaySource->open(fileName)) {
+        QMessageBox::critical(this, "Replay Session", replaySource->errorString());
+        delete replaySource;
+        replaySource = nullptr;
+        return;
     }
+    replaySource->setSpeed(speed == speeds[0] ? 1.0 : speed == speeds[1] ? 10.0 : speed == speeds[2] ? 100.0 : 0.0);
+    
+    // Same receive path as a live port
+    connect(replaySource, &ReplaySource::dataReceived, this, &MainWindow::readData);
+    connect(replaySource, &ReplaySource::finished, this, &MainWindow::stopReplay);
+    rxPipeline.reset();
+    reportedDroppedBytes = 0;
+    device = replaySource;
+    loginSession->setDevice(device);
+    keymgmtUploader->setDevice(device);
+    provisioningQueue->setDevice(device);
+    
+    startReplayAction->setEnabled(false);
+    stopReplayAction->setEnabled(true);
+    connectButton->setEnabled(false);
+    logMessage(QString("Replaying %1 (%2)").arg(fileName, speed), "[INFO] ");
+    replaySource->start();
 }
 
-void MainWindow::rotateLogFile()
+void MainWindow::stopReplay()
 {
-    // Keep only the last MAX_LOG_LINES in memory
-    if (logBuffer.size() > MAX_LOG_LINES) {
-        logBuffer = logBuffer.mid(logBuffer.size() - MAX_LOG_LINES);
+    if (!replaySource) {
+        return;
+    }
+    
+    // Whatever is still buffered goes through the pipeline first
+    while (replaySource->hasData()) {
+        readData();
     }
+    flushIncompleteData();
+    
+    logMessage(QString("Replay %1: %2 MB in %3 s (%4 MB/s)")
+                   .arg(replaySource->isFinished() ? "finished" : "stopped")
+                   .arg(replaySource->bytesDelivered() / 1e6, 0, 'f', 2)
+                   .arg(replaySource->elapsedMs() / 1000.0, 0, 'f', 2)
+                   .arg(replaySource->throughputMBps(), 0, 'f', 2), "[INFO] ");
+    
+    device = serialPort;
+    loginSession->setDevice(device);
+    keymgmtUploader->setDevice(device);
+    provisioningQueue->setDevice(device);
+    replaySource->close();
+    replaySource->deleteLater();
+    replaySource = nullptr;
+    startReplayAction->setEnabled(true);
+    stopReplayAction->setEnabled(false);
+    connectButton->setEnabled(true);
 }
 
 void MainWindow::showAbout()
@@ -833,162 +1366,71 @@ void MainWindow::showAbout()
         "<li>Real-time data logging</li>"
         "<li>ANSI code filtering</li>"
         "<li>Shell prompt filtering</li>"
-        "<li>Log file with 10,000 line history</li>"
+        "<li>In-memory log history of 1,000,000 lines</li>"
         "</ul>"
         "<p>Built with Qt6 and C++</p>");
 }
 
+void MainWindow::showStatistics()
+{
+    QString stats = QString("<h3>Display updates</h3><table>"
+                            "<tr><td>Repaints</td><td align=\"right\">%1</td></tr>"
+                            "<tr><td>Lines</td><td align=\"right\">%2</td></tr>"
+                            "<tr><td>Lines per repaint</td><td align=\"right\">%3</td></tr>"
+                            "<tr><td>Largest batch</td><td align=\"right\">%4</td></tr>"
+                            "</table>")
+                        .arg(updateBatcher->repaintCount())
+                        .arg(updateBatcher->lineCount())
+                        .arg(updateBatcher->linesPerRepaint(), 0, 'f', 1)
+                        .arg(updateBatcher->maxLinesPerRepaint());
+    
+    stats += "<h3>Line classifier rule hits</h3><table>";
+    for (int rule = 0; rule < LogClassifier::RuleCount; ++rule) {
+        const auto r = static_cast<LogClassifier::Rule>(rule);
+        stats += QString("<tr><td>%1</td><td align=\"right\">%2</td></tr>")
+                     .arg(LogClassifier::ruleName(r))
+                     .arg(rxPipeline.classifier().hitCount(r));
+    }
+    stats += "</table>";
+    
+    stats += QString("<h3>Devices</h3><table>"
+                     "<tr><td>Additional boards open</td><td align=\"right\">%1</td></tr>"
+                     "<tr><td>I/O threads</td><td align=\"right\">%2 of %3</td></tr>"
+                     "</table>")
+                 .arg(sessionManager->openCount())
+                 .arg(sessionManager->ioPool()->threadCount())
+                 .arg(sessionManager->ioPool()->maxThreads());
+    
+    QMessageBox::information(this, "Statistics", stats);
+}
+
 void MainWindow::logMessage(const QString &message, const QString &prefix)
 {
-    QString timestamp = QDateTime::currentDateTime().toString("hh:mm:ss.zzz"); // Include milliseconds
+    const QDateTime now = QDateTime::currentDateTime();
+    QString timestamp = now.toString("hh:mm:ss.zzz"); // Include milliseconds
     QString formattedMessage = QString("%1 %2%3").arg(timestamp, prefix, message);
     
-    // Add to terminal
-    terminal->insertPlainText(formattedMessage + "\n");
-    
-    // Add to log buffer
-    logBuffer.append(formattedMessage);
-    rotateLogFile();
+    // Add to log history (one parsed record per line); the terminal view
+    // picks the new rows up on its next refresh
+    terminalModel->append(QString(prefix + message), now.toMSecsSinceEpoch());
     
     // Write to log file
     writeToLogFile(formattedMessage);
-    
-    // Auto-scroll to bottom only if user isn't manually scrolling
-    if (!userScrolling) {
-        QScrollBar *scrollBar = terminal->verticalScrollBar();
-        scrollBar->setValue(scrollBar->maximum());
-    }
 }
 
 void MainWindow::parseCommandOutput(const QString &data)
 {
-    QString timestamp = QDateTime::currentDateTime().toString("hh:mm:ss");
-    QString formattedOutput = QString("[%1] %2").arg(timestamp, data.trimmed());
-    
     // Check for login response
-    checkLoginResponse(data);
+    loginSession->handleResponse(data);
     
     // Add to command output pane
-    commandOutput->insertPlainText(formattedOutput + "\n");
-    
-    // Auto-scroll to bottom
-    QScrollBar *scrollBar = commandOutput->verticalScrollBar();
-    scrollBar->setValue(scrollBar->maximum());
-}
-
-bool MainWindow::isLogMessage(const QString &line)
-{
-    QString trimmed = line.trimmed();
-    
-    // Skip empty lines
-    if (trimmed.isEmpty()) {
-        return false;
-    }
-    
-    // Check for log level tags - these indicate log messages
-    // Pattern like: <inf>, <wrn>, <dbg>, <err>, etc.
-    if (trimmed.contains("<inf>") || trimmed.contains("<wrn>") || 
-        trimmed.contains("<dbg>") || trimmed.contains("<err>") ||
-        trimmed.contains("<nfo>") || trimmed.contains("<warn>") ||
-        trimmed.contains("<debug>") || trimmed.contains("<error>")) {
-        return true; // Has log level tag, this is a log message
-    }
-    
-    // Check for timestamp patterns with brackets (log messages)
-    if (trimmed.contains('[') && trimmed.contains(']')) {
-        // Check for timestamp pattern (numbers, dots, commas, colons inside brackets)
-        QRegularExpression timestampPattern(R"(\[[0-9.,:]+\])");
-        if (timestampPattern.match(trimmed).hasMatch()) {
-            return true; // Has timestamp pattern, this is a log message
-        }
-        
-        // Check for [hh:mm:ss] format timestamps specifically
-        QRegularExpression timePattern(R"(\[[0-9]{1,2}:[0-9]{2}:[0-9]{2}\])");
-        if (timePattern.match(trimmed).hasMatch()) {
-            return true; // Has time format timestamp, this is a log message
-        }
-    }
-    
-    // Check for lines that start with [hh:mm:ss] followed by log content
-    QRegularExpression timeStartPattern(R"(^\[[0-9]{1,2}:[0-9]{2}:[0-9]{2}\])");
-    if (timeStartPattern.match(trimmed).hasMatch()) {
-        return true; // Line starts with timestamp, this is a log message
-    }
-    
-    // Check for lines that start with [hh:mm:ss] followed by any content (more aggressive)
-    if (trimmed.startsWith('[') && trimmed.contains(']') && trimmed.contains(':')) {
-        // Check if it's a timestamp pattern at the start
-        QRegularExpression timePrefixPattern(R"(^\[[0-9]{1,2}:[0-9]{2}:[0-9]{2}\])");
-        if (timePrefixPattern.match(trimmed).hasMatch()) {
-            return true; // Starts with timestamp, filter out as log message
-        }
-    }
-    
-    // Check for lines that start with [hh:mm:ss] followed by log content (very aggressive)
-    // This catches patterns like "[11:34:05] MQTT and LTE 1, 1"
-    QRegularExpression timeStartLogPattern(R"(^\[[0-9]{1,2}:[0-9]{2}:[0-9]{2}\].*$)");
-    if (timeStartLogPattern.match(trimmed).hasMatch()) {
-        return true; // Line starts with timestamp followed by any content, this is a log message
-    }
-    
-    // Check for incomplete timestamp fragments (like [01.04, [01.431,67)
-    QRegularExpression fragmentPattern(R"(^\[[0-9.,:]*$)");
-    if (fragmentPattern.match(trimmed).hasMatch()) {
-        return true; // Incomplete timestamp fragment, this is log noise
-    }
-    
-    // Check for lines that contain timestamp-like fragments anywhere
-    QRegularExpression anyFragmentPattern(R"(\[[0-9.,:]{1,10}\])");
-    if (anyFragmentPattern.match(trimmed).hasMatch()) {
-        return true; // Contains timestamp-like fragment, likely log message
-    }
-    
-    // Check for any line containing a timestamp pattern (very aggressive)
-    // This catches any line with [hh:mm:ss] pattern anywhere
-    QRegularExpression anyTimePattern(R"(\[[0-9]{1,2}:[0-9]{2}:[0-9]{2}\])");
-    if (anyTimePattern.match(trimmed).hasMatch()) {
-        return true; // Contains timestamp pattern anywhere, this is a log message
-    }
-    
-    // Check for fragmented log content (single characters or very short fragments)
-    // These are often corrupted log messages where timestamp gets separated
-    if (trimmed.length() <= 5 && (trimmed.contains("w") || trimmed.contains("d") || 
-        trimmed.contains(":") || trimmed.contains("n") || trimmed.contains("f") ||
-        trimmed.contains(">") || trimmed.contains(" ") || trimmed.contains("x"))) {
-        return true; // Very short fragments, likely corrupted log messages
-    }
-    
-    // Check for single character lines (definitely noise)
-    if (trimmed.length() == 1) {
-        return true; // Single characters are always noise
-    }
-    
-    // Check for lines that start with common log fragments
-    if (trimmed.startsWith("w ") || trimmed.startsWith("d ") || 
-        trimmed.startsWith(": ") || trimmed.startsWith("nf> ") ||
-        trimmed.startsWith("n ") || trimmed.startsWith("f> ")) {
-        return true; // Starts with log fragment, this is a corrupted log message
-    }
-    
-    // Check for shell prompt patterns (not log messages)
-    if (trimmed.contains("login>") || trimmed.contains("dev>") || 
-        trimmed.contains("uart:~$") || trimmed.contains("$ ")) {
-        return false; // Shell prompts are not log messages
-    }
-    
-    // Check for single character lines or very short lines (likely control characters)
-    if (trimmed.length() <= 2) {
-        return true; // Treat very short lines as log noise
-    }
-    
-    // Everything else is considered a command response (not a log message)
-    return false;
+    commandModel->append(data.trimmed(), QDateTime::currentMSecsSinceEpoch());
 }
 
 void MainWindow::selectPemFile()
 {
     QString fileName = QFileDialog::getOpenFileName(this,
-        "Select PEM File", "", "PEM Files (*.pem *.crt *.key *.pem);;All Files (*)");
+        "Select PEM File", "", "Certificates and Keys (*.pem *.crt *.key *.der);;All Files (*)");
     
     if (!fileName.isEmpty()) {
         pemFileEdit->setText(fileName);
@@ -999,38 +1441,43 @@ void MainWindow::selectPemFile()
 void MainWindow::processPemFile(const QString &filePath)
 {
     QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        keymgmtStatus->setText("Error: Could not open file");
+    if (!file.open(QIODevice::ReadOnly)) {
+        pemFileInfo = CredentialInfo();
+        keymgmtStatus->setText(QString("Error: Could not open file: %1").arg(file.errorString()));
         keymgmtStatus->setStyleSheet("color: red;");
+        uploadButton->setEnabled(false);
+        abortButton->setEnabled(false);
         return;
     }
     
-    pemLines.clear();
-    QTextStream in(&file);
-    while (!in.atEnd()) {
-        QString line = in.readLine();
-        // Keep ALL lines including empty ones to preserve PEM structure
-        pemLines.append(line);
-    }
-    file.close();
-    
-    if (pemLines.isEmpty()) {
-        keymgmtStatus->setText("Error: No valid lines found in PEM file");
+    // Parsed now rather than found out after a long upload; DER is converted to PEM
+    pemFileInfo = CredentialValidator::inspect(file.readAll());
+    QString error = pemFileInfo.error;
+    if (!pemFileInfo.valid || !keymgmtUploader->setPemData(pemFileInfo.pem, &error)) {
+        keymgmtStatus->setText(QString("Error: %1").arg(error));
         keymgmtStatus->setStyleSheet("color: red;");
         uploadButton->setEnabled(false);
         abortButton->setEnabled(false);
-    } else {
-        keymgmtStatus->setText(QString("Loaded %1 lines from PEM file").arg(pemLines.size()));
-        keymgmtStatus->setStyleSheet("color: green;");
-        uploadButton->setEnabled(true);
-        abortButton->setEnabled(true); // Enable abort button when file is loaded
-        
-        // Log the first and last lines for debugging
-        if (!pemLines.isEmpty()) {
-            logMessage(QString("PEM file structure - First line: '%1'").arg(pemLines.first()), "[DEBUG] ");
-            logMessage(QString("PEM file structure - Last line: '%2'").arg(pemLines.last()), "[DEBUG] ");
-        }
+        return;
+    }
+    
+    QString description = pemFileInfo.kind == CredentialInfo::Certificate
+        ? QString("certificate %1, valid until %2").arg(pemFileInfo.subject,
+                                                         pemFileInfo.notAfter.toString("yyyy-MM-dd"))
+        : QString("%1 private key").arg(pemFileInfo.keyAlgorithm);
+    if (pemFileInfo.kind == CredentialInfo::EncryptedPrivateKey) {
+        description = "encrypted private key";
     }
+    
+    const QStringList pemLines = keymgmtUploader->lines();
+    keymgmtStatus->setText(QString("Loaded %1 (%2 lines)").arg(description).arg(pemLines.size()));
+    keymgmtStatus->setStyleSheet("color: green;");
+    uploadButton->setEnabled(true);
+    abortButton->setEnabled(true); // Enable abort button when file is loaded
+    
+    // Log the first and last lines for debugging
+    logMessage(QString("PEM file structure - First line: '%1'").arg(pemLines.first()), "[DEBUG] ");
+    logMessage(QString("PEM file structure - Last line: '%2'").arg(pemLines.last()), "[DEBUG] ");
 }
 
 void MainWindow::uploadCertificate()
@@ -1040,69 +1487,53 @@ void MainWindow::uploadCertificate()
         return;
     }
     
-    if (!isLoggedIn) {
+    if (!loginSession->isLoggedIn()) {
         QMessageBox::warning(this, "Login Required", 
             "Certificate upload requires authentication. Please login first.");
         showLoginDialog();
         return;
     }
     
-    if (pemLines.isEmpty()) {
+    if (keymgmtUploader->lines().isEmpty()) {
         QMessageBox::warning(this, "No File", "Please select a PEM file first.");
         return;
     }
     
+    if (provisioningQueue->isRunning()) {
+        QMessageBox::warning(this, "Queue Running", "Wait for the provisioning queue to finish.");
+        return;
+    }
+    
+    // The type can change after the file was loaded, so check it now
+    QStringList warnings;
+    const QStringList errors = CredentialValidator::check(pemFileInfo, certTypeCombo->currentText(),
+                                                          QDateTime::currentDateTimeUtc(), &warnings);
+    if (!errors.isEmpty()) {
+        QMessageBox::warning(this, "Invalid File", errors.join('\n'));
+        return;
+    }
+    if (!warnings.isEmpty()
+        && QMessageBox::question(this, "Upload Anyway?", warnings.join('\n') + "\n\nUpload anyway?")
+               != QMessageBox::Yes) {
+        return;
+    }
+    
     // Start the upload process
-    currentPemLine = 0;
     uploadButton->setEnabled(false);
     abortButton->setEnabled(true); // Keep abort enabled during upload
     uploadProgress->setVisible(true);
-    uploadProgress->setMaximum(pemLines.size());
     uploadProgress->setValue(0);
     keymgmtStatus->setText("Starting upload...");
     keymgmtStatus->setStyleSheet("color: blue;");
     
-    // Send abort command first
-    QString abortCommand = "keymgmt abort\n";
-    QByteArray abortData = abortCommand.toUtf8();
-    serialPort->write(abortData);
-    
     // Reset auto-clear timer when starting upload
     resetAutoClearTimer();
     
-    // Start timer for line-by-line upload (500ms delay between lines)
-    keymgmtTimer->setInterval(500);
-    keymgmtTimer->start();
-}
-
-void MainWindow::sendKeymgmtLine(const QString &line, int secTag, const QString &certType)
-{
-    // Quote the line to handle special characters like dashes
-    QString quotedLine = line;
-    if (!quotedLine.isEmpty()) {
-        // Escape quotes and wrap in quotes to handle shell interpretation
-        quotedLine = quotedLine.replace("\"", "\\\"");
-        quotedLine = "\"" + quotedLine + "\"";
-    }
-    
-    // Fix: Use "cert" instead of "certificate" for the command
-    QString commandType = certType;
-    if (commandType.toLower() == "certificate") {
-        commandType = "cert";
-    }
-    QString command = QString("keymgmt put %1 %2 %3\n").arg(secTag).arg(commandType).arg(quotedLine);
-    QByteArray data = command.toUtf8();
-    serialPort->write(data);
-    
-    // Log the command being sent with line content for debugging
-    QString logLine = line;
-    if (logLine.isEmpty()) {
-        logLine = "(empty line)";
-    }
-    logMessage(QString("Sent keymgmt line %1/%2: %3").arg(currentPemLine + 1).arg(pemLines.size()).arg(logLine), "> ");
-    
-    // Reset auto-clear timer when keymgmt command is sent
-    resetAutoClearTimer();
+    // Clears the device buffer, then sends lines as the device takes them
+    const int secTag = mqttRadio->isChecked() ? KeymgmtUploader::MQTT_SEC_TAG : KeymgmtUploader::FOTA_SEC_TAG;
+    keymgmtUploader->setMode(bulkTransferCheck->isChecked() ? KeymgmtUploader::Bulk : KeymgmtUploader::LineByLine);
+    keymgmtUploader->start(secTag, certTypeCombo->currentText().toLower());
+    uploadProgress->setMaximum(keymgmtUploader->commandCount());
 }
 
 void MainWindow::updateKeymgmtProgress(int current, int total)
@@ -1113,17 +1544,10 @@ void MainWindow::updateKeymgmtProgress(int current, int total)
 
 void MainWindow::abortUpload()
 {
-    bool wasUploading = keymgmtTimer->isActive();
-    
-    // Stop the upload timer if it's running
-    if (wasUploading) {
-        keymgmtTimer->stop();
-    }
-    
-    // Send abort command to clear the buffer
-    QString abortCommand = "keymgmt abort\n";
-    QByteArray abortData = abortCommand.toUtf8();
-    serialPort->write(abortData);
+    // Stops a running upload or queue and clears the device buffer
+    const bool queueRunning = provisioningQueue->isRunning();
+    provisioningQueue->abort();
+    bool wasUploading = keymgmtUploader->abort() || queueRunning;
     
     // Reset UI state
     uploadButton->setEnabled(true);
@@ -1144,6 +1568,212 @@ void MainWindow::abortUpload()
     resetAutoClearTimer();
 }
 
+QGroupBox *MainWindow::createProvisioningQueueGroup()
+{
+    QGroupBox *queueGroup = new QGroupBox("Provisioning Queue");
+    QVBoxLayout *queueLayout = new QVBoxLayout(queueGroup);
+    
+    // One row per file; sec tag and type can be changed per row
+    queueTable = new QTableWidget(0, 4);
+    queueTable->setHorizontalHeaderLabels({"File", "Sec Tag", "Type", "Status"});
+    queueTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    queueTable->horizontalHeader()->setSectionResizeMode(3, QHeaderView::Stretch);
+    queueTable->verticalHeader()->setVisible(false);
+    queueTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    queueTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    queueTable->setMinimumHeight(150);
+    
+    QHBoxLayout *queueButtonLayout = new QHBoxLayout;
+    addQueueFilesButton = new QPushButton("Add Files...");
+    loadBundleButton = new QPushButton("Load Bundle...");
+    loadBundleButton->setToolTip("JSON list of {\"file\", \"secTag\", \"type\"} entries, "
+                                 "as in the provisioning manifest");
+    removeQueueButton = new QPushButton("Remove");
+    uploadQueueButton = new QPushButton("Upload Queue");
+    uploadQueueButton->setEnabled(false);
+    
+    connect(addQueueFilesButton, &QPushButton::clicked, this, &MainWindow::addQueueFiles);
+    connect(loadBundleButton, &QPushButton::clicked, this, &MainWindow::loadQueueBundle);
+    connect(removeQueueButton, &QPushButton::clicked, this, &MainWindow::removeQueueRows);
+    connect(uploadQueueButton, &QPushButton::clicked, this, &MainWindow::uploadQueue);
+    
+    queueButtonLayout->addWidget(addQueueFilesButton);
+    queueButtonLayout->addWidget(loadBundleButton);
+    queueButtonLayout->addWidget(removeQueueButton);
+    queueButtonLayout->addStretch();
+    queueButtonLayout->addWidget(uploadQueueButton);
+    
+    // Overall progress, in thousandths of the queue
+    queueProgress = new QProgressBar;
+    queueProgress->setRange(0, 1000);
+    queueProgress->setTextVisible(false);
+    queueProgress->setVisible(false);
+    
+    queueLayout->addWidget(queueTable);
+    queueLayout->addLayout(queueButtonLayout);
+    queueLayout->addWidget(queueProgress);
+    
+    return queueGroup;
+}
+
+void MainWindow::addQueueFiles()
+{
+    const QStringList fileNames = QFileDialog::getOpenFileNames(this,
+        "Add PEM Files", "", "Certificates and Keys (*.pem *.crt *.key *.der);;All Files (*)");
+    
+    // Start from the single-file settings; each row can be changed after
+    const int secTag = mqttRadio->isChecked() ? KeymgmtUploader::MQTT_SEC_TAG : KeymgmtUploader::FOTA_SEC_TAG;
+    for (const QString &fileName : fileNames) {
+        CertificateUpload upload;
+        upload.file = fileName;
+        upload.secTag = secTag;
+        upload.type = certTypeCombo->currentText().toLower();
+        addQueueRow(upload);
+    }
+}
+
+void MainWindow::loadQueueBundle()
+{
+    QString fileName = QFileDialog::getOpenFileName(this,
+        "Load Credential Bundle", "", "Bundle Files (*.json);;All Files (*)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+    
+    QList<CertificateUpload> uploads;
+    QString error;
+    if (!loadCertificateBundle(fileName, &uploads, &error)) {
+        QMessageBox::warning(this, "Bundle Error", error);
+        return;
+    }
+    
+    for (const CertificateUpload &upload : uploads) {
+        addQueueRow(upload);
+    }
+    logMessage(QString("Loaded %1 credentials from %2").arg(uploads.size()).arg(fileName), "[INFO] ");
+}
+
+void MainWindow::addQueueRow(const CertificateUpload &upload)
+{
+    const int row = queueTable->rowCount();
+    queueTable->insertRow(row);
+    
+    QTableWidgetItem *fileItem = new QTableWidgetItem(QFileInfo(upload.file).fileName());
+    fileItem->setData(Qt::UserRole, upload.file);
+    fileItem->setToolTip(upload.file);
+    queueTable->setItem(row, 0, fileItem);
+    
+    // Any sec tag the modem accepts, not just the MQTT/FOTA presets
+    QSpinBox *secTagSpin = new QSpinBox;
+    secTagSpin->setRange(0, 2147483647);
+    secTagSpin->setValue(upload.secTag);
+    queueTable->setCellWidget(row, 1, secTagSpin);
+    
+    QComboBox *typeCombo = new QComboBox;
+    typeCombo->addItems({"CA", "Certificate", "Key"});
+    typeCombo->setCurrentIndex(upload.type == "ca" ? 0 : upload.type == "key" ? 2 : 1);
+    queueTable->setCellWidget(row, 2, typeCombo);
+    
+    queueTable->setItem(row, 3, new QTableWidgetItem("Pending"));
+    uploadQueueButton->setEnabled(true);
+}
+
+void MainWindow::removeQueueRows()
+{
+    if (provisioningQueue->isRunning()) {
+        return;
+    }
+    
+    // Bottom up so the remaining row numbers stay valid
+    QList<int> rows;
+    for (const QModelIndex &index : queueTable->selectionModel()->selectedRows()) {
+        rows.append(index.row());
+    }
+    std::sort(rows.begin(), rows.end(), std::greater<int>());
+    for (int row : rows) {
+        queueTable->removeRow(row);
+    }
+    uploadQueueButton->setEnabled(queueTable->rowCount() > 0);
+}
+
+QList<CertificateUpload> MainWindow::queueUploads() const
+{
+    QList<CertificateUpload> uploads;
+    for (int row = 0; row < queueTable->rowCount(); ++row) {
+        CertificateUpload upload;
+        upload.file = queueTable->item(row, 0)->data(Qt::UserRole).toString();
+        upload.secTag = qobject_cast<QSpinBox *>(queueTable->cellWidget(row, 1))->value();
+        upload.type = qobject_cast<QComboBox *>(queueTable->cellWidget(row, 2))->currentText().toLower();
+        uploads.append(upload);
+    }
+    return uploads;
+}
+
+void MainWindow::setQueueRowStatus(int row, const QString &status, const QString &color)
+{
+    QTableWidgetItem *statusItem = queueTable->item(row, 3);
+    if (statusItem) {
+        statusItem->setText(status);
+        statusItem->setToolTip(status);
+        statusItem->setForeground(QColor(color));
+    }
+}
+
+void MainWindow::uploadQueue()
+{
+    if (!isConnected) {
+        QMessageBox::warning(this, "Not Connected", "Please connect to the device first.");
+        return;
+    }
+    
+    if (!loginSession->isLoggedIn()) {
+        QMessageBox::warning(this, "Login Required", 
+            "Certificate upload requires authentication. Please login first.");
+        showLoginDialog();
+        return;
+    }
+    
+    if (keymgmtUploader->isUploading() || provisioningQueue->isRunning()) {
+        QMessageBox::warning(this, "Upload Running", "Wait for the current upload to finish.");
+        return;
+    }
+    
+    // Every file is read and checked before anything is sent
+    provisioningQueue->setUploads(queueUploads());
+    const bool valid = provisioningQueue->prepare();
+    QStringList problems;
+    for (int row = 0; row < provisioningQueue->size(); ++row) {
+        const ProvisioningQueue::Item item = provisioningQueue->item(row);
+        if (item.state == ProvisioningQueue::Invalid) {
+            setQueueRowStatus(row, QString("Invalid: %1").arg(item.message), "red");
+            problems.append(QString("%1: %2").arg(queueTable->item(row, 0)->text(), item.message));
+        } else if (!item.warnings.isEmpty()) {
+            setQueueRowStatus(row, QString("Ready: %1").arg(item.warnings.join("; ")), "darkorange");
+            logMessage(QString("%1: %2").arg(queueTable->item(row, 0)->text(), item.warnings.join("; ")), "[WARNING] ");
+        } else {
+            setQueueRowStatus(row, "Ready", "black");
+        }
+    }
+    if (!valid) {
+        QMessageBox::warning(this, "Invalid Files", "Nothing was sent:\n" + problems.join('\n'));
+        return;
+    }
+    
+    provisioningQueue->uploader()->setMode(bulkTransferCheck->isChecked() ? KeymgmtUploader::Bulk
+                                                                          : KeymgmtUploader::LineByLine);
+    uploadQueueButton->setEnabled(false);
+    uploadButton->setEnabled(false);
+    abortButton->setEnabled(true);
+    queueTable->setEnabled(false);
+    queueProgress->setVisible(true);
+    queueProgress->setValue(0);
+    keymgmtStatus->setText(QString("Uploading %1 queued items...").arg(provisioningQueue->size()));
+    keymgmtStatus->setStyleSheet("color: blue;");
+    resetAutoClearTimer();
+    
+    provisioningQueue->start();
+}
+
 void MainWindow::addCommandToHistory(const QString &command)
 {
     // Don't add empty commands or duplicates of the last command
@@ -1201,134 +1831,32 @@ void MainWindow::resetAutoClearTimer()
 void MainWindow::logCommandToOutput(const QString &command)
 {
     // Add command to command output with timestamp
-    QString timestamp = QDateTime::currentDateTime().toString("hh:mm:ss");
-    QString formattedCommand = QString("[%1] > %2").arg(timestamp, command);
-    
-    commandOutput->insertPlainText(formattedCommand + "\n");
-    
-    // Auto-scroll to bottom
-    QScrollBar *scrollBar = commandOutput->verticalScrollBar();
-    scrollBar->setValue(scrollBar->maximum());
+    commandModel->append(QString("> " + command), QDateTime::currentMSecsSinceEpoch());
 }
 
 void MainWindow::clearCommandOutput()
 {
-    commandOutput->clear();
+    commandModel->clear();
     logMessage("Command output cleared", "[INFO] ");
 }
 
 void MainWindow::autoClearCommandOutput()
 {
     // Only auto-clear if there's content in the command output
-    if (!commandOutput->toPlainText().isEmpty()) {
-        commandOutput->clear();
+    if (!commandStore.isEmpty()) {
+        commandModel->clear();
         logMessage("Command output auto-cleared (15s interval)", "[INFO] ");
     }
 }
 
 void MainWindow::flushIncompleteData()
 {
-    // If we have accumulated data that hasn't been processed, force process it
-    if (!accumulatedData.isEmpty()) {
-        QString cleanedData = cleanAnsiCodes(accumulatedData);
-        QString filteredData = filterShellPrompts(cleanedData);
-        
-        if (!filteredData.isEmpty()) {
-            // Replace carriage returns with newlines for proper display
-            filteredData = filteredData.replace("\r\n", "\n");
-            filteredData = filteredData.replace("\r", "\n");
-            
-            // Process whatever we have with better line reconstruction
-            QStringList lines = filteredData.split('\n', Qt::SkipEmptyParts);
-            QStringList logLines, commandLines;
-            
-            for (const QString &line : lines) {
-                QString trimmedLine = line.trimmed();
-                if (trimmedLine.isEmpty()) continue;
-                
-                // Check if this line is too long (likely fragmented)
-                if (trimmedLine.length() > MAX_LINE_LENGTH) {
-                    // Split long lines that might be concatenated fragments
-                    QStringList fragments = splitLongLine(trimmedLine);
-                    for (const QString &fragment : fragments) {
-                        if (fragment.isEmpty()) continue;
-                        
-                        // Check if this fragment is a log message
-                        if (isLogMessage(fragment)) {
-                            logLines.append(fragment);
-                        } else {
-                            commandLines.append(fragment);
-                        }
-                    }
-                } else {
-                    // Normal line processing
-                    if (isLogMessage(trimmedLine)) {
-                        logLines.append(trimmedLine);
-                    } else {
-                        commandLines.append(trimmedLine);
-                    }
-                }
-            }
-            
-            // Send log lines to terminal
-            if (!logLines.isEmpty()) {
-                logMessage(logLines.join('\n'), "");
-            }
-            
-            // Send command lines to command interface
-            if (!commandLines.isEmpty()) {
-                parseCommandOutput(commandLines.join('\n'));
-            }
-        }
-        
-        // Clear accumulated data
-        accumulatedData.clear();
-    }
-}
-
-QStringList MainWindow::splitLongLine(const QString &line)
-{
-    QStringList fragments;
-    QString currentFragment;
-    
-    // Split on common delimiters that indicate separate messages
-    QStringList parts = line.split(QRegularExpression(R"(\s{2,}|\|\s*|\]\s*\[|x\s*)"), Qt::SkipEmptyParts);
-    
-    for (const QString &part : parts) {
-        QString trimmedPart = part.trimmed();
-        if (trimmedPart.isEmpty()) continue;
-        
-        // Filter out single characters and very short fragments
-        if (trimmedPart.length() <= 2) {
-            continue; // Skip single characters and very short fragments
-        }
-        
-        // If this part looks like a complete message, add it as a fragment
-        if (trimmedPart.length() <= MAX_LINE_LENGTH && 
-            (trimmedPart.contains('[') || trimmedPart.contains('<') || 
-             trimmedPart.length() > 10)) {
-            fragments.append(trimmedPart);
-        } else {
-            // Accumulate smaller parts
-            if (!currentFragment.isEmpty()) {
-                currentFragment += " ";
-            }
-            currentFragment += trimmedPart;
-            
-            // If accumulated fragment is long enough, add it
-            if (currentFragment.length() >= 20) {
-                fragments.append(currentFragment);
-                currentFragment.clear();
-            }
-        }
-    }
-    
-    // Add any remaining fragment (only if it's substantial)
-    if (!currentFragment.isEmpty() && currentFragment.length() >= 5) {
-        fragments.append(currentFragment);
-    }
-    
-    return fragments;
+    // No line ending arrived in time - process whatever is buffered
+    QStringList logLines, commandLines;
+    rxPipeline.flush(logLines, commandLines);
+    keymgmtUploader->handleReceived(commandLines, rxPipeline.parser().promptCount());
+    provisioningQueue->handleReceived(commandLines, rxPipeline.parser().promptCount());
+    dispatchLines(logLines, commandLines);
 }
 
 bool MainWindow::eventFilter(QObject *obj, QEvent *event)
@@ -1390,6 +1918,11 @@ void MainWindow::setupKeyManagementTab()
     tagLayout->addWidget(fotaRadio);
     tagLayout->addStretch();
     
+    // Bulk transfer needs the keymgmt bulk/bulkend firmware commands
+    bulkTransferCheck = new QCheckBox("Bulk transfer (base64 chunks, CRC32 verified)");
+    bulkTransferCheck->setToolTip("Sends the file in shell-buffer sized base64 chunks and checks the "
+                                  "CRC32 the device reports. Requires firmware support.");
+    
     // Upload and abort buttons
     QHBoxLayout *buttonLayout = new QHBoxLayout;
     
@@ -1417,57 +1950,16 @@ void MainWindow::setupKeyManagementTab()
     keymgmtLayout->addLayout(fileLayout);
     keymgmtLayout->addLayout(typeLayout);
     keymgmtLayout->addLayout(tagLayout);
+    keymgmtLayout->addWidget(bulkTransferCheck);
     keymgmtLayout->addLayout(buttonLayout);
     keymgmtLayout->addWidget(uploadProgress);
     keymgmtLayout->addWidget(keymgmtStatus);
+    keymgmtLayout->addWidget(createProvisioningQueueGroup());
     keymgmtLayout->addStretch();
     
     mainTabWidget->addTab(keymgmtWidget, "Key Management");
 }
 
-bool MainWindow::isLikelyCorruptedLogLine(const QString &line)
-{
-    QString trimmed = line.trimmed();
-    
-    // Skip empty lines
-    if (trimmed.isEmpty()) {
-        return false;
-    }
-    
-    // Check for common log message patterns that might have lost their tags
-    // These are typical log message content without the log level tags
-    
-    // Check for MQTT-related content (common in your logs)
-    if (trimmed.contains("MQTT", Qt::CaseInsensitive) || 
-        trimmed.contains("LTE", Qt::CaseInsensitive) ||
-        trimmed.contains("GNSS", Qt::CaseInsensitive) ||
-        trimmed.contains("Thread", Qt::CaseInsensitive) ||
-        trimmed.contains("ms", Qt::CaseInsensitive)) {
-        return true; // Likely a corrupted log message
-    }
-    
-    // Check for timestamp patterns (from terminal program)
-    if (trimmed.contains(QRegularExpression(R"(\[[0-9]{1,2}:[0-9]{2}:[0-9]{2}\])"))) {
-        return true; // Contains timestamp, likely corrupted log
-    }
-    
-    // Check for lines that look like log content but lack tags
-    if (trimmed.contains("publish", Qt::CaseInsensitive) ||
-        trimmed.contains("fix", Qt::CaseInsensitive) ||
-        trimmed.contains("since", Qt::CaseInsensitive) ||
-        trimmed.contains("new", Qt::CaseInsensitive)) {
-        return true; // Likely log content without tags
-    }
-    
-    // Check for lines that are too short to be meaningful commands
-    if (trimmed.length() < 10 && !trimmed.contains("help", Qt::CaseInsensitive)) {
-        return true; // Too short, likely corrupted log fragment
-    }
-    
-    // Everything else is considered a legitimate command response
-    return false;
-}
-
 void MainWindow::saveConfiguration()
 {
     if (!isConnected) {
@@ -1485,7 +1977,7 @@ void MainWindow::saveConfiguration()
         // Send backup command: backup copyinto 0 1
         QString command = "backup copyinto 0 1\n";
         QByteArray data = command.toUtf8();
-        serialPort->write(data);
+        device->enqueue(data);
         
         logMessage("Sending backup command: backup copyinto 0 1", "> ");
         logMessage("Configuration backup initiated", "[INFO] ");
@@ -1563,7 +2055,7 @@ void MainWindow::showLoginDialog()
         statusLabel->setText("Logging in... Please wait (may take several seconds)");
         statusLabel->setStyleSheet("color: blue; font-size: 11px;");
         
-        performLogin(password);
+        loginSession->login(password);
     });
     
     connect(retryButton, &QPushButton::clicked, [=]() {
@@ -1578,7 +2070,7 @@ void MainWindow::showLoginDialog()
         statusLabel->setText("Retrying login...");
         statusLabel->setStyleSheet("color: blue; font-size: 11px;");
         
-        performLogin(password);
+        loginSession->login(password);
     });
     
     // Store dialog reference for status updates
@@ -1590,221 +2082,17 @@ void MainWindow::showLoginDialog()
     loginDialog->exec();
 }
 
-void MainWindow::performLogin(const QString &password)
-{
-    if (!isConnected) {
-        return;
-    }
-    
-    currentPassword = password;
-    loginRetryCount = 0;
-    waitingForLoginTest = true;
-    pendingLoginPassword = password;
-    
-    // Send the real password first
-    QString command = QString("login %1\n").arg(password);
-    QByteArray data = command.toUtf8();
-    serialPort->write(data);
-    
-    logMessage(QString("Sending login command (attempt %1/%2)").arg(loginRetryCount + 1).arg(MAX_LOGIN_RETRIES), "> ");
-    
-    // Start timeout timer
-    loginTimeoutTimer->start(LOGIN_RETRY_TIMEOUT_MS);
-}
-
-void MainWindow::sendLoginTestCommand()
+void MainWindow::closeLoginDialog()
 {
-    // First send "login test" to check if already authenticated
-    QString testCommand = "login test\n";
-    QByteArray testData = testCommand.toUtf8();
-    serialPort->write(testData);
-    
-    logMessage("Sending login test command", "> ");
-}
-
-void MainWindow::checkLoginResponse(const QString &response)
-{
-    QString trimmedResponse = response.trimmed();
-    
-    // Check for "messages dropped" indicating connection is ready
-    if (trimmedResponse.contains("messages dropped", Qt::CaseInsensitive)) {
-        logMessage("Connection established - messages dropped detected", "[INFO] ");
-        statusLabel->setText("Connected (Login Required)");
-        statusLabel->setStyleSheet("color: orange; font-weight: bold;");
-        logMessage("Nordic terminal ready for commands", "[INFO] ");
-        
-        // If we're waiting for login test after sending real password, send it now
-        if (waitingForLoginTest && !pendingLoginPassword.isEmpty()) {
-            sendLoginTestCommand();
-        }
-    }
-    
-    // Check for successful login
-    if (trimmedResponse.contains("OK", Qt::CaseInsensitive)) {
-        isLoggedIn = true;
-        lastLoginTime = QDateTime::currentDateTime();
-        loginTimeoutTimer->stop();
-        loginTimeoutTimer->start(LOGIN_TIMEOUT_MS); // Start 30-second timeout
-        
-        logMessage("Login successful", "[INFO] ");
-        statusLabel->setText("Connected & Logged In");
-        statusLabel->setStyleSheet("color: green; font-weight: bold;");
-        
-        // Close any open login dialog
-        QWidgetList widgets = QApplication::topLevelWidgets();
-        for (QWidget *widget : widgets) {
-            if (widget->windowTitle() == "Device Login") {
-                widget->close();
-                break;
-            }
-        }
-    }
-    // Check for "Already Logged in" - this is also a success case
-    else if (trimmedResponse.contains("Already Logged in", Qt::CaseInsensitive) || 
-             trimmedResponse.contains("Already Logged In", Qt::CaseInsensitive)) {
-        isLoggedIn = true;
-        lastLoginTime = QDateTime::currentDateTime();
-        loginTimeoutTimer->stop();
-        loginTimeoutTimer->start(LOGIN_TIMEOUT_MS); // Start 30-second timeout
-        
-        logMessage("Already logged in", "[INFO] ");
-        statusLabel->setText("Connected & Logged In");
-        statusLabel->setStyleSheet("color: green; font-weight: bold;");
-        
-        // Close any open login dialog
-        QWidgetList widgets = QApplication::topLevelWidgets();
-        for (QWidget *widget : widgets) {
-            if (widget->windowTitle() == "Device Login") {
-                widget->close();
-                break;
-            }
-        }
-    }
-    // Check for "Already authenticated" from login test command
-    else if (trimmedResponse.contains("Already authenticated", Qt::CaseInsensitive)) {
-        isLoggedIn = true;
-        lastLoginTime = QDateTime::currentDateTime();
-        loginTimeoutTimer->stop();
-        loginTimeoutTimer->start(LOGIN_TIMEOUT_MS); // Start 30-second timeout
-        waitingForLoginTest = false;
-        
-        logMessage("Already authenticated", "[INFO] ");
-        statusLabel->setText("Connected & Logged In");
-        statusLabel->setStyleSheet("color: green; font-weight: bold;");
-        
-        // Close any open login dialog
-        QWidgetList widgets = QApplication::topLevelWidgets();
-        for (QWidget *widget : widgets) {
-            if (widget->windowTitle() == "Device Login") {
-                widget->close();
-                break;
-            }
-        }
-    }
-    // Check for shell prompt or serial input resuming after login test
-    else if (waitingForLoginTest && (trimmedResponse.contains("uart:~$", Qt::CaseInsensitive) || 
-                                    trimmedResponse.contains("dev>", Qt::CaseInsensitive) ||
-                                    trimmedResponse.contains("login>", Qt::CaseInsensitive))) {
-        // Serial input has resumed, send the actual login command
-        waitingForLoginTest = false;
-        
-        if (!isLoggedIn && !pendingLoginPassword.isEmpty()) {
-            // Send actual login command
-            QString command = QString("login %1\n").arg(pendingLoginPassword);
-            QByteArray data = command.toUtf8();
-            serialPort->write(data);
-            
-            logMessage(QString("Sending login command (attempt %1/%2)").arg(loginRetryCount + 1).arg(MAX_LOGIN_RETRIES), "> ");
-            pendingLoginPassword.clear();
-        }
-    }
-    // Check for "Not Logged In" - this is a failure case
-    else if (trimmedResponse.contains("Not Logged In", Qt::CaseInsensitive) || 
-             trimmedResponse.contains("Not Logged in", Qt::CaseInsensitive)) {
-        loginRetryCount++;
-        logMessage(QString("Login failed - Not Logged In (attempt %1/%2)").arg(loginRetryCount).arg(MAX_LOGIN_RETRIES), "[ERROR] ");
-        
-        // Update dialog status
-        updateLoginDialogStatus("Login failed - Not Logged In", "red");
-        
-        if (loginRetryCount >= MAX_LOGIN_RETRIES) {
-            handleLoginTimeout();
-        } else {
-            // Enable retry button after delay
-            QTimer::singleShot(LOGIN_RETRY_TIMEOUT_MS, this, [this]() {
-                updateLoginDialogStatus("Login failed - click Retry to try again", "orange");
-                enableLoginDialogRetry();
-            });
-        }
-    }
-    // Check for other error cases
-    else if (trimmedResponse.contains("ERROR", Qt::CaseInsensitive) || 
-             trimmedResponse.contains("FAIL", Qt::CaseInsensitive) ||
-             trimmedResponse.contains("Invalid", Qt::CaseInsensitive)) {
-        loginRetryCount++;
-        logMessage(QString("Login failed - %1 (attempt %2/%3)").arg(trimmedResponse).arg(loginRetryCount).arg(MAX_LOGIN_RETRIES), "[ERROR] ");
-        
-        // Update dialog status
-        updateLoginDialogStatus(QString("Login failed - %1").arg(trimmedResponse), "red");
-        
-        if (loginRetryCount >= MAX_LOGIN_RETRIES) {
-            handleLoginTimeout();
-        } else {
-            // Enable retry button after delay
-            QTimer::singleShot(LOGIN_RETRY_TIMEOUT_MS, this, [this]() {
-                updateLoginDialogStatus("Login failed - click Retry to try again", "orange");
-                enableLoginDialogRetry();
-            });
-        }
-    }
-    // If we get here, it might be a partial response or unrelated data
-    // We'll let the timeout handle it
-}
-
-void MainWindow::handleLoginTimeout()
-{
-    isLoggedIn = false;
-    loginTimeoutTimer->stop();
-    
-    logMessage("Login timeout - authentication required", "[WARNING] ");
-    statusLabel->setText("Connected (Login Required)");
-    statusLabel->setStyleSheet("color: orange; font-weight: bold;");
-    
-    // Update any open login dialog
     QWidgetList widgets = QApplication::topLevelWidgets();
     for (QWidget *widget : widgets) {
         if (widget->windowTitle() == "Device Login") {
-            QLabel *statusLabel = widget->findChild<QLabel*>();
-            if (statusLabel) {
-                statusLabel->setText("Login timeout - please retry");
-                statusLabel->setStyleSheet("color: red; font-size: 11px;");
-            }
+            widget->close();
             break;
         }
     }
 }
 
-bool MainWindow::isLoginRequired(const QString &command)
-{
-    // Commands that don't require login
-    QStringList noLoginCommands = {"backup"};
-    
-    for (const QString &noLoginCmd : noLoginCommands) {
-        if (command.trimmed().toLower().startsWith(noLoginCmd.toLower())) {
-            return false;
-        }
-    }
-    
-    return true;
-}
-
-void MainWindow::refreshLogin()
-{
-    if (isLoggedIn && !currentPassword.isEmpty()) {
-        performLogin(currentPassword);
-    }
-}
-
 void MainWindow::updateLoginDialogStatus(const QString &message, const QString &color)
 {
     // Find and update the login dialog status label
@@ -1853,7 +2141,7 @@ void MainWindow::restoreConfiguration()
         // Send restore command: backup copyinto 1 0
         QString command = "backup copyinto 1 0\n";
         QByteArray data = command.toUtf8();
-        serialPort->write(data);
+        device->enqueue(data);
         
         logMessage("Sending restore command: backup copyinto 1 0", "> ");
         logMessage("Configuration restore initiated", "[INFO] ");
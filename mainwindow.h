@@ -2,7 +2,7 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <QTextEdit>
+#include <QListView>
 #include <QPushButton>
 #include <QComboBox>
 #include <QLabel>
@@ -28,12 +28,30 @@
 #include <QProgressBar>
 #include <QRadioButton>
 #include <QButtonGroup>
+#include <QCheckBox>
+#include <QTableWidget>
+#include "baudprober.h"
+#include "credentialvalidator.h"
+#include "keymgmtuploader.h"
+#include "loginsession.h"
+#include "loglistmodel.h"
+#include "logstore.h"
+#include "logwriter.h"
+#include "portprober.h"
+#include "portwatcher.h"
+#include "provisioningqueue.h"
+#include "replaysource.h"
+#include "rxpipeline.h"
 #include "serialport.h"
+#include "sessionmanager.h"
+#include "updatebatcher.h"
 
 QT_BEGIN_NAMESPACE
 class QSerialPortInfo;
 QT_END_NAMESPACE
 
+class SessionView;
+
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -47,9 +65,15 @@ private slots:
     void sendCommand();
     void onComPortChanged();
     void onBaudRateChanged();
-    void checkForData();
     void showAbout();
+    void showStatistics();
+    void startCapture();
+    void stopCapture();
+    void startReplay();
+    void stopReplay();
     void refreshSerialPorts();
+    void detectPorts();
+    void openAdditionalDevice();
 
 private:
     void setupUI();
@@ -65,45 +89,56 @@ private:
     void populateComPorts();
     void populateBaudRates();
     void connectToPort();
+    void openPort(int baudRate);
+    DeviceProfile deviceProfile() const;
+    void detectBaudRate();
+    void onBaudProbeFinished();
     void disconnectFromPort();
     void readData();
+    void dispatchLines(const QStringList &logLines, const QStringList &commandLines);
     void handleError(const QString &error);
     void logMessage(const QString &message, const QString &prefix = "");
-    QString cleanAnsiCodes(const QString &input);
-    QString filterShellPrompts(const QString &input);
     void writeToLogFile(const QString &message);
-    void rotateLogFile();
     void initializeLogFile();
-    void scanAvailablePorts();
+    void onPortAdded(const PortInfo &info);
+    void onPortRemoved(const PortInfo &info);
+    bool isSessionPort(const QString &portName) const;
+    void probePorts(const QStringList &candidates);
+    void onProbeFinished();
     void parseCommandOutput(const QString &data);
-    bool isLogMessage(const QString &line);
     void logCommandToOutput(const QString &command);
+    QListView *createLogView(LogListModel *model);
+    void applyLogFilter();
+    void updateModuleFilter();
     void clearCommandOutput();
     void autoClearCommandOutput();
     void flushIncompleteData();
-    QStringList splitLongLine(const QString &line);
-    bool isLikelyCorruptedLogLine(const QString &line);
+    void closeSessionView(SessionView *view);
     
     // Key Management functions
     void selectPemFile();
     void uploadCertificate();
     void processPemFile(const QString &filePath);
-    void sendKeymgmtLine(const QString &line, int secTag, const QString &certType);
     void updateKeymgmtProgress(int current, int total);
     void abortUpload();
     
+    // Provisioning queue: several files, sec tags and types in one login
+    QGroupBox *createProvisioningQueueGroup();
+    void addQueueFiles();
+    void loadQueueBundle();
+    void addQueueRow(const CertificateUpload &upload);
+    void removeQueueRows();
+    QList<CertificateUpload> queueUploads() const;
+    void setQueueRowStatus(int row, const QString &status, const QString &color);
+    void uploadQueue();
+    
     // Backup functions
     void saveConfiguration();
     void restoreConfiguration();
     
     // Login functions
     void showLoginDialog();
-    void performLogin(const QString &password);
-    void sendLoginTestCommand();
-    void checkLoginResponse(const QString &response);
-    void handleLoginTimeout();
-    bool isLoginRequired(const QString &command);
-    void refreshLogin();
+    void closeLoginDialog();
     void updateLoginDialogStatus(const QString &message, const QString &color);
     void enableLoginDialogRetry();
     
@@ -113,19 +148,36 @@ private:
     void resetAutoClearTimer();
     bool eventFilter(QObject *obj, QEvent *event) override;
 
-    SerialPort *serialPort;
-    QTimer *dataTimer;
-    QTimer *portScanTimer;
+    SessionManager *sessionManager; // Additional boards, one tab each; owns the I/O threads
+    SerialPort *serialPort;        // The main board's port, on the same threads
+    SerialDevice *device;          // Where RX/TX goes: serialPort or replaySource
+    ReplaySource *replaySource;
+    PortWatcher *portWatcher;
+    PortProber *portProber;
+    QTimer *probeDelayTimer;
+    BaudProber *baudProber;
+    QStringList pendingProbePorts; // Plugged in, waiting for probeDelayTimer
+    static const int PROBE_DELAY_MS = 500; // Lets a USB device bring up all its ports
     QTimer *autoClearTimer;
+    UpdateBatcher *updateBatcher;  // Paces terminal/command output repaints
+    QAction *startCaptureAction;
+    QAction *stopCaptureAction;
+    QAction *startReplayAction;
+    QAction *stopReplayAction;
     bool userScrolling;
     QWidget *centralWidget;
     QWidget *toolbarWidget;
     QTabWidget *mainTabWidget;
-    QTextEdit *terminal;
-    QTextEdit *commandOutput;
+    QListView *terminal;
+    QListView *commandOutput;
+    LogListModel *terminalModel;
+    LogListModel *commandModel;
+    QComboBox *levelFilterCombo;
+    QComboBox *moduleFilterCombo;
     QPushButton *connectButton;
     QPushButton *sendButton;
     QPushButton *refreshPortsButton;
+    QPushButton *detectPortsButton;
     QPushButton *clearCommandButton;
     QComboBox *comPortCombo;
     QComboBox *baudRateCombo;
@@ -146,13 +198,22 @@ private:
     QComboBox *certTypeCombo;
     QRadioButton *mqttRadio;
     QRadioButton *fotaRadio;
+    QCheckBox *bulkTransferCheck;
     QPushButton *uploadButton;
     QPushButton *abortButton;
     QProgressBar *uploadProgress;
     QLabel *keymgmtStatus;
-    QStringList pemLines;
-    int currentPemLine;
-    QTimer *keymgmtTimer;
+    KeymgmtUploader *keymgmtUploader;
+    CredentialInfo pemFileInfo;    // What the selected file holds
+    
+    // Provisioning queue UI elements
+    QTableWidget *queueTable;
+    QPushButton *addQueueFilesButton;
+    QPushButton *loadBundleButton;
+    QPushButton *removeQueueButton;
+    QPushButton *uploadQueueButton;
+    QProgressBar *queueProgress;
+    ProvisioningQueue *provisioningQueue;
     
     // Command history
     QStringList commandHistory;
@@ -160,30 +221,29 @@ private:
     QString currentInput;
     
     bool isConnected;
-    bool isLoggedIn;
-    QString currentPassword;
     QString currentComPort;
-    int currentBaudRate;
+    QString selectedPortKey;       // PortInfo::key() of the chosen device, survives renumbering
+    QString dualWritePort;         // Set when the shell reads and writes on different ports
+    int currentBaudRate;           // 0 = detect on connect
+    int autoBaudRate;              // Last rate detected, tried first next time
+    SerialSettings serialSettings; // Serial menu; framing and flow control on connect
     
     // Login management
-    QTimer *loginTimeoutTimer;
-    QDateTime lastLoginTime;
-    static const int LOGIN_TIMEOUT_MS = 30000; // 30 seconds
-    static const int LOGIN_RETRY_TIMEOUT_MS = 15000; // 15 seconds for retry (increased for computational delay)
-    int loginRetryCount;
-    static const int MAX_LOGIN_RETRIES = 3;
-    bool waitingForLoginTest;
-    QString pendingLoginPassword;
+    LoginSession *loginSession;
     
     // Log file functionality
-    QFile *logFile;
-    QStringList logBuffer;
-    static const int MAX_LOG_LINES = 10000;
-    QString logFileName;
+    LogWriter *logWriter;
+    LogStore logStore;
+    static const int MAX_LOG_LINES = 1000000;
+    LogStore commandStore;
+    static const int MAX_COMMAND_LINES = 100000;
     
     // Enhanced buffer management
-    QString accumulatedData;
-    static const int MAX_ACCUMULATED_SIZE = 65536; // 64KB buffer (2x larger)
+    RxPipeline rxPipeline;
+    quint64 reportedDroppedBytes;
+    bool drainScheduled;           // A readData() pass is queued
+    static const int RX_BATCH_SIZE = 16384; // Max bytes drained from the RX ring per pass
+    static const int MAX_ACCUMULATED_SIZE = 65536; // 64KB cap on a single unterminated line
     QTimer *flushTimer;
     static const int FLUSH_TIMEOUT = 25; // 25ms timeout for faster processing
     static const int MAX_LINE_LENGTH = 8192; // 8KB max line length
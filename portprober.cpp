@@ -0,0 +1,211 @@
+#include "portprober.h"
+#include <QTimer>
+#include "rxpipeline.h"
+#include "serialport.h"
+
+namespace {
+
+// An empty command line: the shell prints a new prompt and runs nothing
+const char PROBE[] = "\n";
+
+} // namespace
+
+struct PortProber::Probe
+{
+    SerialPort *port = nullptr;
+    RxPipeline pipeline;
+    ProbeResult result;
+    bool answered = false; // Prompted in reply to its own probe
+};
+
+QString ProbeResult::roleName(Role role)
+{
+    switch (role) {
+    case Failed:
+        return "unavailable";
+    case Silent:
+        return "silent";
+    case Shell:
+        return "shell";
+    case Log:
+        return "log output";
+    case Unknown:
+        return "unrecognised output";
+    }
+    return QString();
+}
+
+PortProber::PortProber(QObject *parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+    , m_elapsedMs(0)
+    , m_current(-1)
+    , m_waiting(false)
+    , m_running(false)
+{
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &PortProber::probeNext);
+}
+
+PortProber::~PortProber()
+{
+    closePorts();
+}
+
+void PortProber::probe(const QStringList &portNames, int baudRate)
+{
+    abort();
+    m_results.clear();
+    m_clock.start();
+    m_current = -1;
+    m_waiting = false;
+    m_running = true;
+
+    // A probe is one byte; no pacing needed
+    DeviceProfile profile;
+    profile.chunkSize = 0;
+    profile.interChunkDelayMs = 0;
+    profile.postWriteDelayMs = 0;
+
+    for (const QString &portName : portNames) {
+        Probe *probe = new Probe;
+        probe->result.portName = portName;
+        probe->port = new SerialPort(this);
+        if (probe->port->open(portName, baudRate)) {
+            probe->port->setDeviceProfile(profile);
+            connect(probe->port, &SerialDevice::dataReceived, this, [this, probe]() { readProbe(probe); });
+        } else {
+            probe->result.role = ProbeResult::Failed;
+            probe->result.error = probe->port->errorString();
+            delete probe->port;
+            probe->port = nullptr;
+        }
+        m_probes.append(probe);
+    }
+
+    m_timer->start(LISTEN_MS);
+}
+
+void PortProber::abort()
+{
+    m_timer->stop();
+    closePorts();
+    m_running = false;
+}
+
+bool PortProber::isRunning() const
+{
+    return m_running;
+}
+
+QList<ProbeResult> PortProber::results() const
+{
+    return m_results;
+}
+
+qint64 PortProber::elapsedMs() const
+{
+    return m_running ? m_clock.elapsed() : m_elapsedMs;
+}
+
+ProbeChoice PortProber::choose(const QList<ProbeResult> &results)
+{
+    ProbeChoice choice;
+    for (const ProbeResult &result : results) {
+        if (result.role == ProbeResult::Shell) {
+            choice.found = true;
+            choice.readPort = result.portName;
+            return choice;
+        }
+    }
+    for (const ProbeResult &result : results) {
+        if (!result.answeredOn.isEmpty()) {
+            choice.found = true;
+            choice.dual = true;
+            choice.readPort = result.answeredOn;
+            choice.writePort = result.portName;
+            return choice;
+        }
+    }
+    return choice;
+}
+
+void PortProber::readProbe(Probe *probe)
+{
+    const QByteArray data = probe->port->read(SerialPort::RX_RING_SIZE);
+    probe->result.bytes += data.size();
+
+    QStringList logLines;
+    QStringList commandLines;
+    const quint64 prompts = probe->pipeline.parser().promptCount();
+    probe->pipeline.feed(data, logLines, commandLines);
+    probe->result.logLines += logLines.size();
+
+    if (!m_waiting || probe->pipeline.parser().promptCount() == prompts) {
+        return;
+    }
+
+    // The first prompt after the probe answers it, wherever it shows up
+    Probe *probed = m_probes[m_current];
+    if (probed == probe) {
+        probed->answered = true;
+    } else {
+        probed->result.answeredOn = probe->result.portName;
+    }
+    probed->result.responseMs = m_probeClock.elapsed();
+    m_waiting = false;
+
+    // Not from here: this handler runs inside the port's signal
+    m_timer->start(0);
+}
+
+void PortProber::probeNext()
+{
+    m_waiting = false;
+    do {
+        ++m_current;
+    } while (m_current < m_probes.size() && !m_probes[m_current]->port);
+
+    if (m_current >= m_probes.size()) {
+        finish();
+        return;
+    }
+
+    m_probeClock.start();
+    m_waiting = true;
+    m_probes[m_current]->port->enqueue(QByteArray(PROBE));
+    m_timer->start(RESPONSE_TIMEOUT_MS);
+}
+
+void PortProber::finish()
+{
+    for (Probe *probe : m_probes) {
+        ProbeResult &result = probe->result;
+        if (result.role == ProbeResult::Failed) {
+            // Keep the open error
+        } else if (probe->answered) {
+            result.role = ProbeResult::Shell;
+        } else if (result.logLines > 0) {
+            result.role = ProbeResult::Log;
+        } else if (result.bytes > 0) {
+            result.role = ProbeResult::Unknown;
+        } else {
+            result.role = ProbeResult::Silent;
+        }
+        m_results.append(result);
+    }
+
+    closePorts();
+    m_running = false;
+    m_elapsedMs = m_clock.elapsed();
+    emit finished();
+}
+
+void PortProber::closePorts()
+{
+    for (Probe *probe : m_probes) {
+        delete probe->port; // Closes the port and joins its I/O thread
+    }
+    qDeleteAll(m_probes);
+    m_probes.clear();
+}
@@ -0,0 +1,96 @@
+#ifndef PORTPROBER_H
+#define PORTPROBER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
+struct ProbeResult
+{
+    enum Role {
+        Failed,   // Could not be opened (busy, gone, no permission)
+        Silent,   // Nothing received
+        Shell,    // Answered the probe with a shell prompt
+        Log,      // Zephyr log output, but no prompt of its own
+        Unknown   // Traffic with neither signature
+    };
+
+    QString portName;
+    Role role = Silent;
+    QString answeredOn;     // Port the prompt came back on, if not this one
+    QString error;
+    qint64 bytes = 0;
+    int logLines = 0;
+    qint64 responseMs = -1; // Probe sent to prompt seen
+
+    static QString roleName(Role role);
+};
+
+// How to connect to the board that was found
+struct ProbeChoice
+{
+    bool found = false;
+    bool dual = false;
+    QString readPort;   // The port to open in single mode
+    QString writePort;  // Dual mode only
+};
+
+// Identifies the Nordic shell among a set of serial ports. All ports are
+// opened at once and listened to for LISTEN_MS to pick up log traffic;
+// then each one in turn is sent a bare newline, which the shell answers
+// with a fresh prompt and nothing else. A prompt on the probed port marks
+// the shell UART; a prompt on another port marks a read/write pair for
+// SerialPort::openDual(). The next port is probed as soon as a prompt
+// arrives, so a responsive board costs milliseconds per port and only
+// silent ports wait out RESPONSE_TIMEOUT_MS.
+class PortProber : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PortProber(QObject *parent = nullptr);
+    ~PortProber();
+
+    void probe(const QStringList &portNames, int baudRate);
+    // Closes every port without reporting results
+    void abort();
+    bool isRunning() const;
+
+    QList<ProbeResult> results() const;
+    qint64 elapsedMs() const;
+
+    // A port that answered itself wins (single mode), then a pair
+    static ProbeChoice choose(const QList<ProbeResult> &results);
+
+    static const int LISTEN_MS = 150;
+    static const int RESPONSE_TIMEOUT_MS = 300;
+
+signals:
+    void finished();
+
+private:
+    struct Probe;
+
+    void readProbe(Probe *probe);
+    void probeNext();
+    void finish();
+    void closePorts();
+
+    QList<Probe *> m_probes;
+    QList<ProbeResult> m_results;
+    QTimer *m_timer;
+    QElapsedTimer m_clock;       // Whole run
+    QElapsedTimer m_probeClock;  // Current probe
+    qint64 m_elapsedMs;          // Whole run, once finished
+    int m_current;               // Index into m_probes, -1 while listening
+    bool m_waiting;              // Probe sent, no prompt yet
+    bool m_running;
+};
+
+#endif // PORTPROBER_H
@@ -0,0 +1,182 @@
+#include "portwatcher.h"
+#include <QTimer>
+#include <algorithm>
+
+#ifndef Q_OS_LINUX
+#include <QSerialPortInfo>
+#endif
+
+// Platform-neutral parts of PortWatcher. Hotplug notifications live in
+// portwatcher_linux.cpp (netlink) and portwatcher_win.cpp (WM_DEVICECHANGE).
+
+QString PortInfo::key() const
+{
+    if (vendorId == 0 && productId == 0) {
+        return portName;
+    }
+    // Without an interface number (Windows) composite devices such as the
+    // nRF9160 DK would share a key; COM numbers are stable there anyway
+    return QString("%1:%2:%3:%4").arg(vendorId, 4, 16, QChar('0')).arg(productId, 4, 16, QChar('0'))
+        .arg(serialNumber, interfaceNumber >= 0 ? QString::number(interfaceNumber) : portName);
+}
+
+QString PortInfo::details() const
+{
+    QStringList lines;
+    if (!description.isEmpty()) {
+        lines.append(description);
+    }
+    if (!manufacturer.isEmpty()) {
+        lines.append(manufacturer);
+    }
+    if (vendorId != 0 || productId != 0) {
+        lines.append(QString("VID:PID %1:%2").arg(vendorId, 4, 16, QChar('0')).arg(productId, 4, 16, QChar('0')));
+    }
+    if (!serialNumber.isEmpty()) {
+        lines.append(QString("Serial %1").arg(serialNumber));
+    }
+    lines.append(systemLocation);
+    return lines.join('\n');
+}
+
+PortWatcher::PortWatcher(QObject *parent)
+    : QObject(parent)
+#if defined(Q_OS_LINUX)
+    , m_netlinkFd(-1)
+    , m_netlinkNotifier(nullptr)
+#elif defined(Q_OS_WIN)
+    , m_deviceChangeFilter(nullptr)
+    , m_rescanTimer(new QTimer(this))
+#endif
+    , m_pollTimer(new QTimer(this))
+    , m_eventDriven(false)
+{
+    m_collator.setNumericMode(true);
+    m_collator.setCaseSensitivity(Qt::CaseInsensitive);
+
+    m_pollTimer->setInterval(POLL_INTERVAL_MS);
+    connect(m_pollTimer, &QTimer::timeout, this, &PortWatcher::rescan);
+}
+
+PortWatcher::~PortWatcher()
+{
+    stopNotifications();
+}
+
+void PortWatcher::start()
+{
+    // Subscribe first so nothing plugged in during the enumeration is missed
+    m_eventDriven = startNotifications();
+    rescan();
+    if (!m_eventDriven) {
+        m_pollTimer->start();
+    }
+}
+
+void PortWatcher::rescan()
+{
+    setPorts(enumeratePorts());
+}
+
+QList<PortInfo> PortWatcher::ports() const
+{
+    QList<PortInfo> ports = m_ports.values();
+    std::sort(ports.begin(), ports.end(), [this](const PortInfo &a, const PortInfo &b) {
+        return m_collator.compare(a.portName, b.portName) < 0;
+    });
+    return ports;
+}
+
+PortInfo PortWatcher::port(const QString &portName) const
+{
+    return m_ports.value(portName);
+}
+
+PortInfo PortWatcher::portByKey(const QString &key) const
+{
+    for (const PortInfo &info : m_ports) {
+        if (info.key() == key) {
+            return info;
+        }
+    }
+    return PortInfo();
+}
+
+bool PortWatcher::isEventDriven() const
+{
+    return m_eventDriven;
+}
+
+void PortWatcher::addPort(const PortInfo &info)
+{
+    const auto it = m_ports.constFind(info.portName);
+    if (it != m_ports.constEnd()) {
+        if (it->key() == info.key()) {
+            return; // Already known, e.g. seen by the enumeration and an event
+        }
+        removePort(info.portName);
+    }
+    m_ports.insert(info.portName, info);
+    emit portAdded(info);
+}
+
+void PortWatcher::removePort(const QString &portName)
+{
+    const auto it = m_ports.find(portName);
+    if (it == m_ports.end()) {
+        return;
+    }
+    const PortInfo info = it.value();
+    m_ports.erase(it);
+    emit portRemoved(info);
+}
+
+void PortWatcher::setPorts(const QList<PortInfo> &ports)
+{
+    QMap<QString, PortInfo> present;
+    for (const PortInfo &info : ports) {
+        present.insert(info.portName, info);
+    }
+
+    const QStringList known = m_ports.keys();
+    for (const QString &portName : known) {
+        if (!present.contains(portName)) {
+            removePort(portName);
+        }
+    }
+    for (const PortInfo &info : ports) {
+        addPort(info);
+    }
+}
+
+#ifndef Q_OS_LINUX
+// Windows and the polling fallback enumerate through Qt
+QList<PortInfo> PortWatcher::enumeratePorts() const
+{
+    QList<PortInfo> ports;
+    const auto infos = QSerialPortInfo::availablePorts();
+    for (const QSerialPortInfo &serialInfo : infos) {
+        PortInfo info;
+        info.portName = serialInfo.portName();
+        info.systemLocation = serialInfo.systemLocation();
+        info.description = serialInfo.description();
+        info.manufacturer = serialInfo.manufacturer();
+        info.serialNumber = serialInfo.serialNumber();
+        info.vendorId = serialInfo.hasVendorIdentifier() ? serialInfo.vendorIdentifier() : 0;
+        info.productId = serialInfo.hasProductIdentifier() ? serialInfo.productIdentifier() : 0;
+        ports.append(info);
+    }
+    return ports;
+}
+#endif
+
+#if !defined(Q_OS_LINUX) && !defined(Q_OS_WIN)
+bool PortWatcher::startNotifications()
+{
+    return false; // Poll
+}
+
+void PortWatcher::stopNotifications()
+{
+}
+#endif
@@ -0,0 +1,94 @@
+#ifndef PORTWATCHER_H
+#define PORTWATCHER_H
+
+#include <QCollator>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+QT_BEGIN_NAMESPACE
+class QSocketNotifier;
+class QTimer;
+QT_END_NAMESPACE
+
+struct PortInfo
+{
+    QString portName;        // "ttyACM0", "COM9"
+    QString systemLocation;  // "/dev/ttyACM0", "\\.\COM9"
+    QString description;
+    QString manufacturer;
+    QString serialNumber;
+    quint16 vendorId = 0;
+    quint16 productId = 0;
+    int interfaceNumber = -1; // USB interface, where the platform reports it
+
+    // VID:PID:serial for USB adapters, so a device is recognised again
+    // when it comes back under another name; the port name otherwise
+    QString key() const;
+    // Multi-line summary for tooltips
+    QString details() const;
+};
+
+// Registry of the serial ports present, updated by hotplug notifications
+// instead of polling: netlink kernel uevents on Linux, WM_DEVICECHANGE on
+// Windows. Only the port that changed is looked at (on Linux, its sysfs
+// entry) so an event costs microseconds and an idle host costs nothing.
+// Elsewhere, or if notifications can't be set up, ports are enumerated
+// every POLL_INTERVAL_MS as before. ports() is in natural order, so
+// COM2 < COM10 and ttyACM2 < ttyACM10.
+class PortWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PortWatcher(QObject *parent = nullptr);
+    ~PortWatcher();
+
+    void start();
+    // Full enumeration, e.g. for a manual refresh
+    void rescan();
+
+    QList<PortInfo> ports() const;
+    PortInfo port(const QString &portName) const;
+    // The port now carrying this key, or an empty PortInfo
+    PortInfo portByKey(const QString &key) const;
+    bool isEventDriven() const;
+
+    static const int POLL_INTERVAL_MS = 2000;
+    static const int RESCAN_DELAY_MS = 250; // Windows: settle after a burst of device events
+
+signals:
+    void portAdded(const PortInfo &info);
+    void portRemoved(const PortInfo &info);
+
+private:
+    void addPort(const PortInfo &info);
+    void removePort(const QString &portName);
+    // Replaces the registry with a full enumeration, reporting differences
+    void setPorts(const QList<PortInfo> &ports);
+
+    // Platform hooks (portwatcher_linux.cpp, portwatcher_win.cpp, or the
+    // polling fallback in portwatcher.cpp)
+    QList<PortInfo> enumeratePorts() const;
+    bool startNotifications();
+    void stopNotifications();
+
+#if defined(Q_OS_LINUX)
+    void readUevents();
+    int m_netlinkFd;
+    QSocketNotifier *m_netlinkNotifier;
+#elif defined(Q_OS_WIN)
+    class DeviceChangeFilter;
+    DeviceChangeFilter *m_deviceChangeFilter;
+    QTimer *m_rescanTimer;
+#endif
+
+    QMap<QString, PortInfo> m_ports; // By port name
+    QCollator m_collator;
+    QTimer *m_pollTimer;
+    bool m_eventDriven;
+};
+
+#endif // PORTWATCHER_H
@@ -0,0 +1,150 @@
+#include "portwatcher.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSocketNotifier>
+#include <cerrno>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+const char SYSFS_TTY[] = "/sys/class/tty/";
+
+QString readSysfs(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+    return QString::fromUtf8(file.readAll()).trimmed();
+}
+
+// Only ttys backed by a device are ports; legacy 8250 UARTs are listed
+// whether or not anything is fitted, so they are left out
+bool isSerialPort(const QString &name)
+{
+    const QString device = SYSFS_TTY + name + "/device";
+    return QFileInfo::exists(device) && QFileInfo(device + "/driver").symLinkTarget().section('/', -1) != "serial8250";
+}
+
+// Reads this one port's details from sysfs; the USB ids live a few
+// levels up, on the device the interface belongs to
+PortInfo sysfsPortInfo(const QString &name)
+{
+    PortInfo info;
+    info.portName = name;
+    info.systemLocation = "/dev/" + name;
+
+    QDir dir(QFileInfo(SYSFS_TTY + name + "/device").canonicalFilePath());
+    for (int level = 0; level < 4 && dir.absolutePath() != "/sys/devices"; ++level) {
+        if (info.interfaceNumber < 0 && dir.exists("bInterfaceNumber")) {
+            info.interfaceNumber = readSysfs(dir.filePath("bInterfaceNumber")).toInt(nullptr, 16);
+        }
+        if (dir.exists("idVendor")) {
+            info.vendorId = quint16(readSysfs(dir.filePath("idVendor")).toUInt(nullptr, 16));
+            info.productId = quint16(readSysfs(dir.filePath("idProduct")).toUInt(nullptr, 16));
+            info.serialNumber = readSysfs(dir.filePath("serial"));
+            info.manufacturer = readSysfs(dir.filePath("manufacturer"));
+            info.description = readSysfs(dir.filePath("product"));
+            break;
+        }
+        if (!dir.cdUp()) {
+            break;
+        }
+    }
+    return info;
+}
+
+} // namespace
+
+QList<PortInfo> PortWatcher::enumeratePorts() const
+{
+    QList<PortInfo> ports;
+    const QStringList names = QDir(SYSFS_TTY).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &name : names) {
+        if (isSerialPort(name)) {
+            ports.append(sysfsPortInfo(name));
+        }
+    }
+    return ports;
+}
+
+bool PortWatcher::startNotifications()
+{
+    // Kernel uevents (group 1); udev's own messages come after rules have
+    // run and would add nothing here
+    m_netlinkFd = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (m_netlinkFd < 0) {
+        return false;
+    }
+
+    sockaddr_nl address = {};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = 1;
+    if (::bind(m_netlinkFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        ::close(m_netlinkFd);
+        m_netlinkFd = -1;
+        return false;
+    }
+
+    m_netlinkNotifier = new QSocketNotifier(m_netlinkFd, QSocketNotifier::Read, this);
+    connect(m_netlinkNotifier, &QSocketNotifier::activated, this, &PortWatcher::readUevents);
+    return true;
+}
+
+void PortWatcher::stopNotifications()
+{
+    delete m_netlinkNotifier;
+    m_netlinkNotifier = nullptr;
+    if (m_netlinkFd >= 0) {
+        ::close(m_netlinkFd);
+        m_netlinkFd = -1;
+    }
+}
+
+void PortWatcher::readUevents()
+{
+    char buffer[8192];
+    for (;;) {
+        sockaddr_nl sender = {};
+        socklen_t senderSize = sizeof(sender);
+        const ssize_t size = ::recvfrom(m_netlinkFd, buffer, sizeof(buffer) - 1, 0,
+                                        reinterpret_cast<sockaddr *>(&sender), &senderSize);
+        if (size < 0 && errno == ENOBUFS) {
+            rescan(); // The socket overflowed and events were lost
+            continue;
+        }
+        if (size <= 0) {
+            break; // EAGAIN: all read
+        }
+        if (sender.nl_pid != 0) {
+            continue; // Only the kernel's own messages
+        }
+
+        // "action@devpath\0KEY=value\0KEY=value\0..."
+        buffer[size] = '\0';
+        QByteArray action, subsystem, devName;
+        for (ssize_t offset = 0; offset < size; offset += ssize_t(qstrlen(buffer + offset)) + 1) {
+            const QByteArray field(buffer + offset);
+            if (field.startsWith("ACTION=")) {
+                action = field.mid(7);
+            } else if (field.startsWith("SUBSYSTEM=")) {
+                subsystem = field.mid(10);
+            } else if (field.startsWith("DEVNAME=")) {
+                devName = field.mid(8);
+            }
+        }
+        if (subsystem != "tty" || devName.isEmpty()) {
+            continue;
+        }
+
+        const QString name = QString::fromLocal8Bit(devName).section('/', -1);
+        if (action == "add" && isSerialPort(name)) {
+            addPort(sysfsPortInfo(name));
+        } else if (action == "remove") {
+            removePort(name);
+        }
+    }
+}
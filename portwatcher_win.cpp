@@ -0,0 +1,66 @@
+#include "portwatcher.h"
+#include <QAbstractNativeEventFilter>
+#include <QCoreApplication>
+#include <QTimer>
+#include <windows.h>
+#include <dbt.h>
+
+// WM_DEVICECHANGE for ports is broadcast to every top-level window, so the
+// application's own windows see it without RegisterDeviceNotification().
+// The message doesn't say enough to update the registry in place, so it
+// triggers one enumeration once a burst of events has settled.
+class PortWatcher::DeviceChangeFilter : public QAbstractNativeEventFilter
+{
+public:
+    explicit DeviceChangeFilter(QTimer *rescanTimer)
+        : m_rescanTimer(rescanTimer)
+    {
+    }
+
+    bool nativeEventFilter(const QByteArray &eventType, void *message, qintptr *) override
+    {
+        if (eventType != "windows_generic_MSG") {
+            return false;
+        }
+        const MSG *msg = static_cast<const MSG *>(message);
+        if (msg->message != WM_DEVICECHANGE
+            || (msg->wParam != DBT_DEVICEARRIVAL && msg->wParam != DBT_DEVICEREMOVECOMPLETE)) {
+            return false;
+        }
+        const DEV_BROADCAST_HDR *header = reinterpret_cast<const DEV_BROADCAST_HDR *>(msg->lParam);
+        if (header && header->dbch_devicetype == DBT_DEVTYP_PORT) {
+            m_rescanTimer->start();
+        }
+        return false; // Other windows may want it as well
+    }
+
+private:
+    QTimer *m_rescanTimer;
+};
+
+bool PortWatcher::startNotifications()
+{
+    if (!QCoreApplication::instance()) {
+        return false;
+    }
+
+    m_rescanTimer->setSingleShot(true);
+    m_rescanTimer->setInterval(RESCAN_DELAY_MS);
+    connect(m_rescanTimer, &QTimer::timeout, this, &PortWatcher::rescan);
+
+    m_deviceChangeFilter = new DeviceChangeFilter(m_rescanTimer);
+    QCoreApplication::instance()->installNativeEventFilter(m_deviceChangeFilter);
+    return true;
+}
+
+void PortWatcher::stopNotifications()
+{
+    if (!m_deviceChangeFilter) {
+        return;
+    }
+    if (QCoreApplication::instance()) {
+        QCoreApplication::instance()->removeNativeEventFilter(m_deviceChangeFilter);
+    }
+    delete m_deviceChangeFilter;
+    m_deviceChangeFilter = nullptr;
+}
@@ -0,0 +1,429 @@
+#include "provisioner.h"
+#include "keymgmtuploader.h"
+#include "loginsession.h"
+#include "serialport.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+
+namespace {
+
+const qint64 RX_BATCH_SIZE = 16384;
+const int LINE_RECONSTRUCTION_TIMEOUT = 100;
+
+// "framing": "8N1", "flowControl": "rtscts", buffer sizes and pacing.
+// With flow control the pacing defaults to none; explicit keys still win.
+bool parseDeviceProfile(const QJsonObject &entry, DeviceProfile *profile, QString *error)
+{
+    SerialSettings serial;
+    if (entry.contains("framing") && !serial.setFraming(entry.value("framing").toString())) {
+        *error = QString("unknown framing \"%1\"").arg(entry.value("framing").toString());
+        return false;
+    }
+    if (entry.contains("flowControl")
+        && !SerialSettings::parseFlowControl(entry.value("flowControl").toString(), &serial.flowControl)) {
+        *error = QString("unknown flow control \"%1\"").arg(entry.value("flowControl").toString());
+        return false;
+    }
+    serial.rxBufferSize = entry.value("rxBufferSize").toInt(serial.rxBufferSize);
+    serial.txBufferSize = entry.value("txBufferSize").toInt(serial.txBufferSize);
+
+    if (serial.flowControl != SerialSettings::NoFlowControl) {
+        *profile = DeviceProfile::lineRate(serial);
+    } else {
+        profile->serial = serial;
+    }
+    profile->chunkSize = entry.value("chunkSize").toInt(profile->chunkSize);
+    profile->interChunkDelayMs = entry.value("chunkDelayMs").toInt(profile->interChunkDelayMs);
+    profile->postWriteDelayMs = entry.value("writeDelayMs").toInt(profile->postWriteDelayMs);
+    return true;
+}
+
+bool parseDevice(const QJsonObject &entry, const QDir &baseDir, ProvisionJob *job, QString *error)
+{
+    job->port = entry.value("port").toString();
+    if (job->port.isEmpty()) {
+        *error = "Device entry without \"port\"";
+        return false;
+    }
+    job->baudRate = entry.value("baudRate").toInt(job->baudRate);
+    job->password = entry.value("password").toString(job->password);
+    job->window = entry.value("window").toInt(job->window);
+    job->ackTimeoutMs = entry.value("ackTimeoutMs").toInt(job->ackTimeoutMs);
+    job->bulk = entry.value("bulk").toBool(job->bulk);
+    job->timeoutMs = entry.value("timeoutMs").toInt(job->timeoutMs);
+
+    if (!parseDeviceProfile(entry, &job->profile, error)) {
+        *error = QString("%1: %2").arg(job->port, *error);
+        return false;
+    }
+
+    if (!parseCertificateList(entry.value("certificates").toArray(), baseDir, &job->certificates, error)) {
+        *error = QString("%1: %2").arg(job->port, *error);
+        return false;
+    }
+
+    // "backup": "save" or [ "save", ... ]
+    const QJsonValue backup = entry.value("backup");
+    const QJsonArray actions = backup.isString() ? QJsonArray{ backup } : backup.toArray();
+    for (const QJsonValue &value : actions) {
+        const QString action = value.toString().toLower();
+        if (action != "save" && action != "restore") {
+            *error = QString("%1: unknown backup action \"%2\"").arg(job->port, value.toString());
+            return false;
+        }
+        job->backupActions.append(action);
+    }
+
+    if (job->password.isEmpty() && !job->certificates.isEmpty()) {
+        *error = QString("%1: certificate upload needs a password").arg(job->port);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool loadProvisionManifest(const QString &fileName, QList<ProvisionJob> *jobs, QString *error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = QString("Failed to open %1: %2").arg(fileName, file.errorString());
+        return false;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (document.isNull()) {
+        *error = QString("%1: %2 at offset %3").arg(fileName, parseError.errorString()).arg(parseError.offset);
+        return false;
+    }
+
+    const QJsonObject root = document.object();
+    const QJsonObject defaults = root.value("defaults").toObject();
+    const QDir baseDir = QFileInfo(fileName).absoluteDir();
+
+    jobs->clear();
+    for (const QJsonValue &value : root.value("devices").toArray()) {
+        // Device keys override the defaults
+        QJsonObject entry = defaults;
+        const QJsonObject device = value.toObject();
+        for (auto it = device.constBegin(); it != device.constEnd(); ++it) {
+            entry.insert(it.key(), it.value());
+        }
+
+        ProvisionJob job;
+        if (!parseDevice(entry, baseDir, &job, error)) {
+            return false;
+        }
+        jobs->append(job);
+    }
+
+    if (jobs->isEmpty()) {
+        *error = QString("%1 lists no devices").arg(fileName);
+        return false;
+    }
+    return true;
+}
+
+DeviceProvisioner::DeviceProvisioner(const ProvisionJob &job, QObject *parent)
+    : DeviceProvisioner(job, nullptr, parent)
+{
+}
+
+DeviceProvisioner::DeviceProvisioner(const ProvisionJob &job, IoThreadPool *ioPool, QObject *parent)
+    : QObject(parent)
+    , m_job(job)
+    , m_port(new SerialPort(ioPool, this))
+    , m_login(new LoginSession(this))
+    , m_queue(new ProvisioningQueue(this))
+    , m_timeoutTimer(new QTimer(this))
+    , m_flushTimer(new QTimer(this))
+    , m_currentTask(0)
+    , m_loginAttempts(0)
+    , m_waitingForBackupReply(false)
+    , m_backupEchoSeen(false)
+    , m_done(false)
+{
+    m_result.port = job.port;
+
+    m_login->setDevice(m_port);
+    m_queue->setDevice(m_port);
+    m_queue->uploader()->setWindow(job.window);
+    m_queue->uploader()->setAckTimeout(job.ackTimeoutMs);
+    m_queue->uploader()->setMode(job.bulk ? KeymgmtUploader::Bulk : KeymgmtUploader::LineByLine);
+    m_queue->setUploads(job.certificates);
+
+    connect(m_port, &SerialPort::dataReceived, this, &DeviceProvisioner::readData);
+    connect(m_port, &SerialPort::errorOccurred, this, &DeviceProvisioner::fail);
+    connect(m_port, &SerialPort::writeFailed, this, [this](quint64, const QString &error) {
+        fail(error);
+    });
+
+    m_flushTimer->setSingleShot(true);
+    connect(m_flushTimer, &QTimer::timeout, this, [this]() {
+        QStringList logLines, commandLines;
+        m_rxPipeline.flush(logLines, commandLines);
+        m_queue->handleReceived(commandLines, m_rxPipeline.parser().promptCount());
+        if (!commandLines.isEmpty()) {
+            handleCommandOutput(commandLines.join('\n'));
+        }
+        handleBackupReply(commandLines);
+    });
+
+    m_timeoutTimer->setSingleShot(true);
+    connect(m_timeoutTimer, &QTimer::timeout, this, [this]() {
+        fail("Timed out");
+    });
+
+    connect(m_login, &LoginSession::loggedIn, this, [this]() {
+        if (m_currentTask < m_tasks.size() && m_tasks[m_currentTask].step == Login) {
+            completeTask();
+        }
+    });
+    connect(m_login, &LoginSession::retryAvailable, this, [this]() {
+        if (m_done || m_currentTask >= m_tasks.size() || m_tasks[m_currentTask].step != Login) {
+            return;
+        }
+        if (m_loginAttempts >= LoginSession::MAX_LOGIN_RETRIES) {
+            fail(QString("Login failed after %1 attempts").arg(m_loginAttempts));
+            return;
+        }
+        ++m_loginAttempts;
+        m_login->login(m_job.password);
+    });
+    connect(m_login, &LoginSession::loginTimedOut, this, [this]() {
+        // The session's 30 s expiry also fires mid-upload; only a pending login cares
+        if (m_currentTask < m_tasks.size() && m_tasks[m_currentTask].step == Login) {
+            fail("Login timed out");
+        }
+    });
+
+    // One login covers the whole queue; the uploads keep it alive
+    connect(m_queue, &ProvisioningQueue::itemStarted, this, [this](int index) {
+        m_taskClock.start();
+        emit progress(m_job.port, "upload " + ProvisioningQueue::itemName(m_queue->item(index).upload));
+    });
+    connect(m_queue, &ProvisioningQueue::itemProgress, m_login, &LoginSession::keepAlive);
+    connect(m_queue, &ProvisioningQueue::itemFinished, this, [this](int index, bool success, const QString &message) {
+        const QString name = ProvisioningQueue::itemName(m_queue->item(index).upload);
+        if (success) {
+            m_result.stepTimesMs.append({ "upload " + name, m_queue->item(index).elapsedMs });
+        } else {
+            fail(QString("%1: %2").arg(name, message));
+        }
+    });
+    connect(m_queue, &ProvisioningQueue::finished, this, [this](int, int failed) {
+        if (failed == 0) {
+            completeTask();
+        }
+    });
+}
+
+DeviceProvisioner::~DeviceProvisioner()
+{
+    m_port->close();
+}
+
+void DeviceProvisioner::start()
+{
+    m_clock.start();
+
+    // Every file is read and validated before the port is even opened
+    const bool valid = m_queue->prepare();
+    for (int i = 0; i < m_queue->size(); ++i) {
+        const ProvisioningQueue::Item item = m_queue->item(i);
+        for (const QString &warning : item.warnings) {
+            emit progress(m_job.port, QString("warning: %1: %2").arg(item.upload.file, warning));
+        }
+    }
+    if (!valid) {
+        for (int i = 0; i < m_queue->size(); ++i) {
+            const ProvisioningQueue::Item item = m_queue->item(i);
+            if (item.state == ProvisioningQueue::Invalid) {
+                fail(QString("%1: %2").arg(item.upload.file, item.message));
+                return;
+            }
+        }
+    }
+
+    if (!m_job.password.isEmpty()) {
+        m_tasks.append({ Login, 0 });
+    }
+    if (!m_job.certificates.isEmpty()) {
+        m_tasks.append({ Upload, 0 });
+    }
+    for (int i = 0; i < m_job.backupActions.size(); ++i) {
+        m_tasks.append({ Backup, i });
+    }
+
+    m_port->setDeviceProfile(m_job.profile);
+    if (!m_port->open(m_job.port, m_job.baudRate)) {
+        fail(m_port->errorString());
+        return;
+    }
+
+    m_timeoutTimer->start(m_job.timeoutMs);
+    QTimer::singleShot(0, this, &DeviceProvisioner::runNextTask);
+}
+
+ProvisionResult DeviceProvisioner::result() const
+{
+    return m_result;
+}
+
+void DeviceProvisioner::readData()
+{
+    QStringList logLines, commandLines;
+    while (m_port->hasData()) {
+        m_rxPipeline.feed(m_port->read(RX_BATCH_SIZE), logLines, commandLines);
+    }
+    m_queue->handleReceived(commandLines, m_rxPipeline.parser().promptCount());
+
+    // Device log output is of no interest here; command output drives the job
+    if (!commandLines.isEmpty()) {
+        handleCommandOutput(commandLines.join('\n'));
+    }
+    handleBackupReply(commandLines);
+
+    if (m_rxPipeline.hasPartialLine()) {
+        m_flushTimer->start(LINE_RECONSTRUCTION_TIMEOUT);
+    } else {
+        m_flushTimer->stop();
+    }
+}
+
+void DeviceProvisioner::handleCommandOutput(const QString &output)
+{
+    // Only the login reply; the error words it looks for turn up in the
+    // echoed base64 of uploads, whose errors KeymgmtUploader reports
+    if (m_done || m_currentTask >= m_tasks.size() || m_tasks[m_currentTask].step != Login) {
+        return;
+    }
+
+    m_login->handleResponse(output);
+}
+
+void DeviceProvisioner::handleBackupReply(const QStringList &commandLines)
+{
+    if (!m_waitingForBackupReply || m_done) {
+        return;
+    }
+
+    // Output from before the command (late upload replies) is skipped up
+    // to the shell's echo of it; everything after that is the reply
+    for (const QString &line : commandLines) {
+        if (!m_backupEchoSeen) {
+            m_backupEchoSeen = line.contains(m_backupCommand);
+            continue;
+        }
+        if (line.contains("ERROR", Qt::CaseInsensitive) || line.contains("FAIL", Qt::CaseInsensitive)
+            || line.contains("Invalid", Qt::CaseInsensitive) || line.contains("usage", Qt::CaseInsensitive)) {
+            fail(line.trimmed());
+            return;
+        }
+    }
+
+    // Done once the shell is back at a prompt after the echo
+    if (m_backupEchoSeen && m_rxPipeline.parser().atPrompt()) {
+        completeTask();
+    }
+}
+
+void DeviceProvisioner::runNextTask()
+{
+    if (m_done) {
+        return;
+    }
+    if (m_currentTask >= m_tasks.size()) {
+        m_result.success = true;
+        finish();
+        return;
+    }
+
+    const Task &task = m_tasks[m_currentTask];
+    m_taskClock.start();
+    emit progress(m_job.port, taskName(task));
+
+    switch (task.step) {
+    case Login:
+        m_loginAttempts = 1;
+        m_login->login(m_job.password);
+        break;
+    case Upload:
+        m_queue->start();
+        break;
+    case Backup: {
+        const bool save = m_job.backupActions[task.index] == "save";
+        m_backupCommand = save ? "backup copyinto 0 1" : "backup copyinto 1 0";
+        m_backupEchoSeen = false;
+        m_waitingForBackupReply = true;
+        m_port->enqueue((m_backupCommand + "\n").toUtf8());
+        const int taskIndex = m_currentTask;
+        QTimer::singleShot(BACKUP_TIMEOUT_MS, this, [this, taskIndex]() {
+            if (m_currentTask == taskIndex && m_waitingForBackupReply) {
+                fail("No reply from the device");
+            }
+        });
+        break;
+    }
+    }
+}
+
+void DeviceProvisioner::completeTask()
+{
+    if (m_done || m_currentTask >= m_tasks.size()) {
+        return;
+    }
+    // Uploads are timed per item as they finish
+    if (m_tasks[m_currentTask].step != Upload) {
+        m_result.stepTimesMs.append({ taskName(m_tasks[m_currentTask]), m_taskClock.elapsed() });
+    }
+    m_waitingForBackupReply = false;
+    ++m_currentTask;
+
+    // Not from inside the signal that completed the task
+    QTimer::singleShot(0, this, &DeviceProvisioner::runNextTask);
+}
+
+void DeviceProvisioner::fail(const QString &error)
+{
+    if (m_done) {
+        return;
+    }
+    m_result.success = false;
+    m_result.error = m_currentTask < m_tasks.size()
+        ? QString("%1: %2").arg(taskName(m_tasks[m_currentTask]), error)
+        : error;
+    finish();
+}
+
+void DeviceProvisioner::finish()
+{
+    m_done = true;
+    m_timeoutTimer->stop();
+    m_flushTimer->stop();
+    m_queue->abort();
+    m_login->reset();
+    m_port->close();
+
+    m_result.elapsedMs = m_clock.elapsed();
+    emit finished(m_result);
+}
+
+QString DeviceProvisioner::taskName(const Task &task) const
+{
+    switch (task.step) {
+    case Login:
+        return "login";
+    case Upload:
+        return QString("upload %1 certificates").arg(m_job.certificates.size());
+    case Backup:
+        return QString("backup %1").arg(m_job.backupActions[task.index]);
+    }
+    return QString();
+}
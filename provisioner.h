@@ -0,0 +1,120 @@
+#ifndef PROVISIONER_H
+#define PROVISIONER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+#include "provisioningqueue.h"
+#include "rxpipeline.h"
+#include "serialport.h"
+
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
+class IoThreadPool;
+class LoginSession;
+
+// Everything to do to one device, in order: log in once, stream every
+// certificate over that login, then run the backup actions ("save" copies slot 0 into
+// slot 1, "restore" copies it back).
+struct ProvisionJob
+{
+    QString port;
+    int baudRate = 115200;
+    DeviceProfile profile;     // Framing, flow control and write pacing
+    QString password;
+    QList<CertificateUpload> certificates;
+    QStringList backupActions;
+    int window = 2;            // keymgmt lines outstanding at once
+    int ackTimeoutMs = 500;    // Per line when the device doesn't acknowledge
+    bool bulk = false;         // Base64 + CRC32 transfer (KeymgmtUploader::Bulk)
+    int timeoutMs = 300000;
+};
+
+struct ProvisionResult
+{
+    QString port;
+    bool success = false;
+    QString error;
+    qint64 elapsedMs = 0;
+    QList<QPair<QString, qint64>> stepTimesMs; // Step name, duration
+};
+
+// Reads a JSON manifest:
+// { "defaults": { "password": "...", "baudRate": 115200, ... },
+//   "devices": [ { "port": "/dev/ttyACM0",
+//                  "certificates": [ { "file": "ca.pem", "secTag": 42, "type": "ca" } ],
+//                  "backup": [ "save" ] } ] }
+// Device entries override the defaults; relative PEM paths are resolved
+// against the manifest's directory. Line settings are optional:
+// "framing": "8N1", "flowControl": "none" | "rtscts" | "xonxoff",
+// "rxBufferSize"/"txBufferSize" (Windows), and "chunkSize", "chunkDelayMs",
+// "writeDelayMs" for write pacing (none by default with flow control).
+bool loadProvisionManifest(const QString &fileName, QList<ProvisionJob> *jobs, QString *error);
+
+// Runs one ProvisionJob against its own SerialPort, so any number of
+// provisioners can share one event loop. The port's I/O runs on a thread
+// from ioPool if given, on a thread of its own otherwise.
+class DeviceProvisioner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DeviceProvisioner(const ProvisionJob &job, QObject *parent = nullptr);
+    DeviceProvisioner(const ProvisionJob &job, IoThreadPool *ioPool, QObject *parent = nullptr);
+    ~DeviceProvisioner();
+
+    void start();
+    ProvisionResult result() const;
+
+    static const int BACKUP_TIMEOUT_MS = 10000;
+
+signals:
+    // Progress for the console, e.g. "Uploading ca.pem (42/ca)"
+    void progress(const QString &port, const QString &message);
+    void finished(const ProvisionResult &result);
+
+private:
+    enum Step {
+        Login,
+        Upload,
+        Backup
+    };
+
+    struct Task
+    {
+        Step step;
+        int index; // Backup action
+    };
+
+    void readData();
+    void handleCommandOutput(const QString &output);
+    void handleBackupReply(const QStringList &commandLines);
+    void runNextTask();
+    void completeTask();
+    void fail(const QString &error);
+    void finish();
+    QString taskName(const Task &task) const;
+
+    ProvisionJob m_job;
+    ProvisionResult m_result;
+    SerialPort *m_port;
+    LoginSession *m_login;
+    ProvisioningQueue *m_queue;
+    RxPipeline m_rxPipeline;
+    QTimer *m_timeoutTimer;
+    QTimer *m_flushTimer;
+    QList<Task> m_tasks;
+    int m_currentTask;
+    int m_loginAttempts;
+    bool m_waitingForBackupReply;
+    QString m_backupCommand;       // As echoed by the shell
+    bool m_backupEchoSeen;
+    bool m_done;
+    QElapsedTimer m_clock;
+    QElapsedTimer m_taskClock;
+};
+
+#endif // PROVISIONER_H
@@ -0,0 +1,326 @@
+#include "provisioningqueue.h"
+#include "keymgmtuploader.h"
+#include "serialdevice.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThreadPool>
+#include <QTimer>
+
+namespace {
+
+// Reads and validates the file. Runs on a pool thread, so it only
+// touches its own item.
+void readItem(ProvisioningQueue::Item *item, const QDateTime &now)
+{
+    item->warnings.clear();
+    QFile file(item->upload.file);
+    if (!file.open(QIODevice::ReadOnly)) {
+        item->state = ProvisioningQueue::Invalid;
+        item->message = QString("Could not open file: %1").arg(file.errorString());
+        return;
+    }
+
+    // Cached by content, so a bundle shared by many devices parses once
+    item->info = CredentialValidator::inspect(file.readAll());
+    const QStringList errors = CredentialValidator::check(item->info, item->upload.type, now, &item->warnings);
+    if (!errors.isEmpty()) {
+        item->state = ProvisioningQueue::Invalid;
+        item->message = errors.join("; ");
+        return;
+    }
+
+    item->data = item->info.pem;
+    item->state = ProvisioningQueue::Ready;
+    item->message.clear();
+}
+
+bool isCertificateType(const QString &type)
+{
+    return type == "cert" || type == "certificate";
+}
+
+} // namespace
+
+bool parseCertificateList(const QJsonArray &entries, const QDir &baseDir, QList<CertificateUpload> *uploads,
+                          QString *error)
+{
+    for (const QJsonValue &value : entries) {
+        const QJsonObject certificate = value.toObject();
+        CertificateUpload upload;
+        upload.file = certificate.value("file").toString();
+        upload.secTag = certificate.value("secTag").toInt(upload.secTag);
+        upload.type = certificate.value("type").toString(upload.type).toLower();
+        if (upload.file.isEmpty()) {
+            *error = "Certificate entry without \"file\"";
+            return false;
+        }
+        if (upload.type != "ca" && upload.type != "cert" && upload.type != "certificate" && upload.type != "key") {
+            *error = QString("Unknown certificate type \"%1\"").arg(upload.type);
+            return false;
+        }
+        if (upload.secTag < 0) {
+            *error = QString("Invalid sec tag %1 for %2").arg(upload.secTag).arg(upload.file);
+            return false;
+        }
+        upload.file = baseDir.absoluteFilePath(upload.file);
+        uploads->append(upload);
+    }
+    return true;
+}
+
+bool loadCertificateBundle(const QString &fileName, QList<CertificateUpload> *uploads, QString *error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = QString("Failed to open %1: %2").arg(fileName, file.errorString());
+        return false;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (document.isNull()) {
+        *error = QString("%1: %2 at offset %3").arg(fileName, parseError.errorString()).arg(parseError.offset);
+        return false;
+    }
+
+    const QJsonArray entries = document.isArray() ? document.array()
+                                                  : document.object().value("certificates").toArray();
+    uploads->clear();
+    if (!parseCertificateList(entries, QFileInfo(fileName).absoluteDir(), uploads, error)) {
+        *error = QString("%1: %2").arg(fileName, *error);
+        return false;
+    }
+    if (uploads->isEmpty()) {
+        *error = QString("%1 lists no certificates").arg(fileName);
+        return false;
+    }
+    return true;
+}
+
+ProvisioningQueue::ProvisioningQueue(QObject *parent)
+    : QObject(parent)
+    , m_uploader(new KeymgmtUploader(this))
+    , m_device(nullptr)
+    , m_current(-1)
+    , m_currentSent(0)
+    , m_currentTotal(0)
+    , m_running(false)
+{
+    connect(m_uploader, &KeymgmtUploader::lineSent, this, [this](int current, int total, const QString &) {
+        m_currentSent = current;
+        m_currentTotal = total;
+        emit itemProgress(m_current, current, total);
+    });
+    connect(m_uploader, &KeymgmtUploader::finished, this, [this]() {
+        finishItem(true, QString());
+    });
+    connect(m_uploader, &KeymgmtUploader::failed, this, [this](const QString &reason) {
+        finishItem(false, reason);
+    });
+}
+
+void ProvisioningQueue::setDevice(SerialDevice *device)
+{
+    m_device = device;
+    m_uploader->setDevice(device);
+}
+
+KeymgmtUploader *ProvisioningQueue::uploader() const
+{
+    return m_uploader;
+}
+
+void ProvisioningQueue::setUploads(const QList<CertificateUpload> &uploads)
+{
+    if (m_running) {
+        return;
+    }
+    m_items.clear();
+    for (const CertificateUpload &upload : uploads) {
+        Item item;
+        item.upload = upload;
+        m_items.append(item);
+    }
+    m_current = -1;
+}
+
+int ProvisioningQueue::size() const
+{
+    return m_items.size();
+}
+
+ProvisioningQueue::Item ProvisioningQueue::item(int index) const
+{
+    return m_items.value(index);
+}
+
+bool ProvisioningQueue::prepare()
+{
+    if (m_running) {
+        return false;
+    }
+
+    // Each task writes only its own item; data() detaches once, up front
+    Item *items = m_items.data();
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    QThreadPool pool;
+    for (int i = 0; i < m_items.size(); ++i) {
+        pool.start([items, i, now]() { readItem(&items[i], now); });
+    }
+    pool.waitForDone();
+
+    // A key must belong to the client certificate stored next to it
+    for (Item &key : m_items) {
+        if (key.state != Ready || key.upload.type != "key") {
+            continue;
+        }
+        for (const Item &certificate : m_items) {
+            if (certificate.state != Ready || certificate.upload.secTag != key.upload.secTag
+                || !isCertificateType(certificate.upload.type)) {
+                continue;
+            }
+            const QString error = CredentialValidator::checkPair(certificate.info, key.info, &key.warnings);
+            if (!error.isEmpty()) {
+                key.state = Invalid;
+                key.message = QString("%1 (%2)").arg(error, QFileInfo(certificate.upload.file).fileName());
+            }
+        }
+    }
+
+    bool valid = true;
+    for (const Item &item : m_items) {
+        valid = valid && item.state == Ready;
+    }
+    return valid;
+}
+
+bool ProvisioningQueue::start()
+{
+    if (m_running || !m_device || m_items.isEmpty()) {
+        return false;
+    }
+    for (const Item &item : m_items) {
+        if (item.state != Ready) {
+            return false;
+        }
+    }
+
+    m_running = true;
+    m_current = -1;
+    startNext();
+    return true;
+}
+
+void ProvisioningQueue::abort()
+{
+    if (!m_running) {
+        return;
+    }
+    if (m_uploader->abort()) {
+        finishItem(false, "Aborted");
+    } else {
+        m_running = false; // Between two items
+        stop();
+    }
+}
+
+bool ProvisioningQueue::isRunning() const
+{
+    return m_running;
+}
+
+int ProvisioningQueue::currentIndex() const
+{
+    return m_current;
+}
+
+double ProvisioningQueue::overallProgress() const
+{
+    if (m_items.isEmpty() || m_current < 0) {
+        return 0.0;
+    }
+    int finished = 0;
+    for (const Item &item : m_items) {
+        finished += (item.state == Done || item.state == Failed || item.state == Skipped) ? 1 : 0;
+    }
+    const double current = (m_running && m_currentTotal > 0) ? double(m_currentSent) / m_currentTotal : 0.0;
+    return (finished + current) / m_items.size();
+}
+
+QString ProvisioningQueue::itemName(const CertificateUpload &upload)
+{
+    return QString("%1 (%2/%3)").arg(QFileInfo(upload.file).fileName()).arg(upload.secTag).arg(upload.type);
+}
+
+void ProvisioningQueue::handleReceived(const QStringList &commandLines, quint64 promptCount)
+{
+    m_uploader->handleReceived(commandLines, promptCount);
+}
+
+void ProvisioningQueue::startNext()
+{
+    ++m_current;
+    if (m_current >= m_items.size()) {
+        m_running = false;
+        emit finished(m_items.size(), 0);
+        return;
+    }
+
+    Item &item = m_items[m_current];
+    item.state = Uploading;
+    m_currentSent = 0;
+    m_currentTotal = 0;
+    m_itemClock.start();
+    emit itemStarted(m_current);
+
+    QString error;
+    if (!m_uploader->setPemData(item.data, &error)) {
+        finishItem(false, error);
+        return;
+    }
+    m_uploader->start(item.upload.secTag, item.upload.type);
+}
+
+void ProvisioningQueue::finishItem(bool success, const QString &message)
+{
+    if (!m_running || m_current < 0 || m_current >= m_items.size()) {
+        return;
+    }
+
+    Item &item = m_items[m_current];
+    item.state = success ? Done : Failed;
+    item.message = message;
+    item.elapsedMs = m_itemClock.elapsed();
+
+    if (success) {
+        emit itemFinished(m_current, true, message);
+        // Not from inside the uploader's finished() signal
+        QTimer::singleShot(0, this, [this]() {
+            if (m_running) {
+                startNext();
+            }
+        });
+        return;
+    }
+
+    // Stopped before the signal, so a handler calling abort() is harmless
+    m_running = false;
+    emit itemFinished(m_current, false, message);
+    stop();
+}
+
+void ProvisioningQueue::stop()
+{
+    int succeeded = 0;
+    for (Item &other : m_items) {
+        if (other.state == Ready) {
+            other.state = Skipped;
+        }
+        succeeded += other.state == Done ? 1 : 0;
+    }
+    emit finished(succeeded, m_items.size() - succeeded);
+}
@@ -0,0 +1,117 @@
+#ifndef PROVISIONINGQUEUE_H
+#define PROVISIONINGQUEUE_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include "credentialvalidator.h"
+
+QT_BEGIN_NAMESPACE
+class QDir;
+class QJsonArray;
+QT_END_NAMESPACE
+
+class KeymgmtUploader;
+class SerialDevice;
+
+struct CertificateUpload
+{
+    QString file;
+    int secTag = 42;
+    QString type = "cert"; // ca, cert or key
+};
+
+// Reads [ { "file": "ca.pem", "secTag": 42, "type": "ca" }, ... ];
+// relative paths are resolved against baseDir
+bool parseCertificateList(const QJsonArray &entries, const QDir &baseDir, QList<CertificateUpload> *uploads,
+                          QString *error);
+
+// A bundle file is { "certificates": [ ... ] } in the format above, or
+// just the array
+bool loadCertificateBundle(const QString &fileName, QList<CertificateUpload> *uploads, QString *error);
+
+// Uploads a list of credentials back to back over the current login.
+// prepare() reads and validates every file up front, in parallel (see
+// CredentialValidator; a key and certificate sharing a sec tag must also
+// pair up), so a bad file is reported before anything is sent; start() then streams the
+// items one after another through one KeymgmtUploader. The caller logs in
+// first and keeps the login alive on itemProgress(). The first failure
+// stops the queue and skips the remaining items.
+class ProvisioningQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum ItemState {
+        Pending,
+        Ready,
+        Invalid,
+        Uploading,
+        Done,
+        Failed,
+        Skipped
+    };
+
+    struct Item
+    {
+        CertificateUpload upload;
+        QByteArray data;       // PEM as uploaded
+        CredentialInfo info;
+        ItemState state = Pending;
+        QString message;       // Why it is Invalid or Failed
+        QStringList warnings;  // From validation, not fatal
+        qint64 elapsedMs = 0;
+    };
+
+    explicit ProvisioningQueue(QObject *parent = nullptr);
+
+    void setDevice(SerialDevice *device);
+    // For the transfer settings (mode, window, ack timeout)
+    KeymgmtUploader *uploader() const;
+
+    void setUploads(const QList<CertificateUpload> &uploads);
+    int size() const;
+    Item item(int index) const;
+
+    // Returns false if any item is Invalid
+    bool prepare();
+    // Returns false if the queue isn't prepared or a device is missing
+    bool start();
+    void abort();
+    bool isRunning() const;
+    int currentIndex() const;
+
+    // Items done plus the fraction of the current one, 0 to 1
+    double overallProgress() const;
+    static QString itemName(const CertificateUpload &upload);
+
+    // Feed with each batch of command output, see KeymgmtUploader::handleReceived()
+    void handleReceived(const QStringList &commandLines, quint64 promptCount);
+
+signals:
+    void itemStarted(int index);
+    // Commands of the current item sent so far
+    void itemProgress(int index, int current, int total);
+    void itemFinished(int index, bool success, const QString &message);
+    void finished(int succeeded, int failed);
+
+private:
+    void startNext();
+    void finishItem(bool success, const QString &message);
+    // Skips what is left and reports the totals, once m_running is cleared
+    void stop();
+
+    KeymgmtUploader *m_uploader;
+    SerialDevice *m_device;
+    QList<Item> m_items;
+    int m_current;
+    int m_currentSent;
+    int m_currentTotal;
+    bool m_running;
+    QElapsedTimer m_itemClock;
+};
+
+#endif // PROVISIONINGQUEUE_H
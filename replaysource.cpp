@@ -0,0 +1,290 @@
+#include "replaysource.h"
+#include <QTimer>
+#include <cmath>
+
+namespace {
+
+const qint64 MAX_PENDING = 1024 * 1024;  // Stop reading ahead beyond this
+const qint64 MAX_BATCH = 256 * 1024;     // Bytes per pump() call
+const double NS_PER_BYTE_AT_1_BAUD = 10e9; // 8N1: 10 bits per byte
+
+} // namespace
+
+ReplaySource::ReplaySource(QObject *parent)
+    : SerialDevice(parent)
+    , m_isCapture(false)
+    , m_textData(nullptr)
+    , m_textSize(0)
+    , m_textOffset(0)
+    , m_firstTimeNs(0)
+    , m_readOffset(0)
+    , m_timer(new QTimer(this))
+    , m_speed(1.0)
+    , m_isOpen(false)
+    , m_atEnd(false)
+    , m_finished(false)
+    , m_delivered(0)
+    , m_nextWriteId(0)
+    , m_finishMs(-1)
+{
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &ReplaySource::pump);
+}
+
+ReplaySource::~ReplaySource()
+{
+    close();
+}
+
+bool ReplaySource::open(const QString &fileName)
+{
+    close();
+
+    if (fileName.endsWith(".cap", Qt::CaseInsensitive)) {
+        QString error;
+        if (!m_capture.open(fileName, &error)) {
+            m_errorString = error;
+            return false;
+        }
+        m_isCapture = true;
+        m_record = m_capture.first();
+        m_firstTimeNs = m_record.offset >= 0 ? m_record.timeNs : 0;
+    } else {
+        m_textFile.setFileName(fileName);
+        if (!m_textFile.open(QIODevice::ReadOnly)) {
+            m_errorString = QString("Failed to open %1: %2").arg(fileName, m_textFile.errorString());
+            return false;
+        }
+        m_textSize = m_textFile.size();
+        m_textData = m_textSize > 0 ? m_textFile.map(0, m_textSize) : nullptr;
+        if (m_textSize > 0 && !m_textData) {
+            m_errorString = QString("Failed to map %1: %2").arg(fileName, m_textFile.errorString());
+            m_textFile.close();
+            return false;
+        }
+        m_isCapture = false;
+        m_textOffset = 0;
+    }
+
+    m_isOpen = true;
+    m_errorString.clear();
+    return true;
+}
+
+void ReplaySource::start()
+{
+    if (!m_isOpen) {
+        return;
+    }
+    m_clock.start();
+    m_timer->start(0);
+}
+
+void ReplaySource::setSpeed(double multiplier)
+{
+    m_speed = qMax(0.0, multiplier);
+}
+
+double ReplaySource::speed() const
+{
+    return m_speed;
+}
+
+bool ReplaySource::isOpen() const
+{
+    return m_isOpen;
+}
+
+void ReplaySource::close()
+{
+    m_timer->stop();
+    m_capture.close();
+    m_record = CaptureReader::Record();
+    if (m_textData) {
+        m_textFile.unmap(const_cast<uchar *>(m_textData));
+        m_textData = nullptr;
+    }
+    m_textFile.close();
+    m_textSize = 0;
+    m_textOffset = 0;
+    m_pending.clear();
+    m_readOffset = 0;
+    m_isOpen = false;
+    m_atEnd = false;
+    m_finished = false;
+    m_delivered = 0;
+    m_finishMs = -1;
+}
+
+QString ReplaySource::errorString() const
+{
+    return m_errorString;
+}
+
+quint64 ReplaySource::enqueue(const QByteArray &data)
+{
+    Q_UNUSED(data);
+    if (!m_isOpen) {
+        return 0;
+    }
+
+    // Nothing is listening; report the write as done
+    const quint64 id = ++m_nextWriteId;
+    QMetaObject::invokeMethod(this, [this, id]() {
+        emit bytesWritten(id);
+    }, Qt::QueuedConnection);
+    return id;
+}
+
+QByteArray ReplaySource::read(qint64 maxSize)
+{
+    const qint64 size = qMin(maxSize, pendingSize());
+    const QByteArray data = m_pending.mid(m_readOffset, size);
+    m_readOffset += size;
+
+    // Compact once the consumed prefix dominates
+    if (m_readOffset == m_pending.size()) {
+        m_pending.truncate(0);
+        m_readOffset = 0;
+    } else if (m_readOffset > m_pending.size() / 2) {
+        m_pending.remove(0, m_readOffset);
+        m_readOffset = 0;
+    }
+
+    if (m_atEnd) {
+        checkFinished();
+    } else if (m_isOpen && !m_timer->isActive() && pendingSize() < MAX_PENDING) {
+        m_timer->start(0); // Was waiting for the reader to catch up
+    }
+    return data;
+}
+
+bool ReplaySource::hasData() const
+{
+    return pendingSize() > 0;
+}
+
+quint64 ReplaySource::droppedBytes() const
+{
+    return 0; // Replay waits for the reader instead of dropping
+}
+
+bool ReplaySource::isFinished() const
+{
+    return m_finished;
+}
+
+quint64 ReplaySource::bytesDelivered() const
+{
+    return m_delivered;
+}
+
+qint64 ReplaySource::elapsedMs() const
+{
+    if (m_finishMs >= 0) {
+        return m_finishMs;
+    }
+    return m_clock.isValid() ? m_clock.elapsed() : 0;
+}
+
+double ReplaySource::throughputMBps() const
+{
+    const qint64 ms = qMax<qint64>(elapsedMs(), 1);
+    return double(m_delivered) / 1e6 / (double(ms) / 1000.0);
+}
+
+void ReplaySource::pump()
+{
+    if (!m_isOpen || m_atEnd) {
+        return;
+    }
+
+    // Position on the recording's clock that may be delivered by now
+    const bool fast = m_speed <= 0.0;
+    const double replayNs = fast ? 0.0 : double(m_clock.nsecsElapsed()) * m_speed;
+
+    qint64 budget = MAX_BATCH;
+    double nextDueNs = -1.0;
+    const qint64 pendingBefore = pendingSize();
+
+    while (budget > 0 && pendingSize() < MAX_PENDING) {
+        if (m_isCapture) {
+            if (m_record.offset < 0) {
+                m_atEnd = true;
+                break;
+            }
+            if (m_record.direction == Capture::Tx) {
+                m_record = m_capture.next(m_record);
+                continue; // Our own writes; only the device's output is replayed
+            }
+            const double dueNs = double(m_record.timeNs - m_firstTimeNs);
+            if (!fast && dueNs > replayNs) {
+                nextDueNs = dueNs;
+                break;
+            }
+            appendPending(m_record.data, m_record.size);
+            budget -= m_record.size;
+            m_record = m_capture.next(m_record);
+        } else {
+            const qint64 remaining = m_textSize - m_textOffset;
+            if (remaining <= 0) {
+                m_atEnd = true;
+                break;
+            }
+            qint64 chunk = qMin(remaining, budget);
+            if (!fast) {
+                const qint64 dueBytes = qint64(replayNs * TEXT_BAUD_RATE / NS_PER_BYTE_AT_1_BAUD)
+                    - m_textOffset;
+                if (dueBytes <= 0) {
+                    nextDueNs = double(m_textOffset + 1) * NS_PER_BYTE_AT_1_BAUD / TEXT_BAUD_RATE;
+                    break;
+                }
+                chunk = qMin(chunk, dueBytes);
+            }
+            appendPending(reinterpret_cast<const char *>(m_textData) + m_textOffset, chunk);
+            budget -= chunk;
+            m_textOffset += chunk;
+        }
+    }
+
+    if (pendingSize() > pendingBefore) {
+        emit dataReceived();
+    }
+
+    if (m_atEnd) {
+        checkFinished();
+    } else if (nextDueNs >= 0.0) {
+        // Sleep until the next record is due on the scaled clock
+        const double waitNs = (nextDueNs - replayNs) / m_speed;
+        m_timer->start(int(qBound(1.0, std::ceil(waitNs / 1e6), 1000.0)));
+    } else if (pendingSize() < MAX_PENDING) {
+        m_timer->start(0);
+    }
+    // Otherwise read() restarts the timer once the reader catches up
+}
+
+void ReplaySource::appendPending(const char *data, qint64 size)
+{
+    m_pending.append(data, size);
+    m_delivered += quint64(size);
+}
+
+qint64 ReplaySource::pendingSize() const
+{
+    return m_pending.size() - m_readOffset;
+}
+
+void ReplaySource::checkFinished()
+{
+    if (m_finished || pendingSize() > 0) {
+        return;
+    }
+    m_finished = true;
+    m_finishMs = m_clock.elapsed();
+
+    // Not from inside read(); the reader may still be in its handler
+    QMetaObject::invokeMethod(this, [this]() {
+        emit finished();
+    }, Qt::QueuedConnection);
+}
@@ -0,0 +1,83 @@
+#ifndef REPLAYSOURCE_H
+#define REPLAYSOURCE_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include "capturefile.h"
+#include "serialdevice.h"
+
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
+// Plays a recorded session back through the SerialDevice interface so the
+// normal receive path (parser, classifier, views) runs without a device.
+// .cap captures replay their RX records with the recorded timing; any
+// other file is treated as raw terminal text paced like a TEXT_BAUD_RATE
+// 8N1 link. speed() scales the timing; 0 delivers as fast as the reader
+// keeps up. Writes are accepted and discarded.
+class ReplaySource : public SerialDevice
+{
+    Q_OBJECT
+
+public:
+    explicit ReplaySource(QObject *parent = nullptr);
+    ~ReplaySource();
+
+    bool open(const QString &fileName);
+    void start();
+
+    void setSpeed(double multiplier);
+    double speed() const;
+
+    bool isOpen() const override;
+    void close() override;
+    QString errorString() const override;
+    quint64 enqueue(const QByteArray &data) override;
+    QByteArray read(qint64 maxSize) override;
+    bool hasData() const override;
+    quint64 droppedBytes() const override;
+
+    // Replay statistics; elapsed time stops once everything was read
+    bool isFinished() const;
+    quint64 bytesDelivered() const;
+    qint64 elapsedMs() const;
+    double throughputMBps() const;
+
+    static const int TEXT_BAUD_RATE = 115200;
+
+signals:
+    // All bytes were delivered and read
+    void finished();
+
+private:
+    void pump();
+    void appendPending(const char *data, qint64 size);
+    qint64 pendingSize() const;
+    void checkFinished();
+
+    CaptureReader m_capture;
+    CaptureReader::Record m_record;
+    bool m_isCapture;
+    QFile m_textFile;
+    const uchar *m_textData;
+    qint64 m_textSize;
+    qint64 m_textOffset;
+    quint64 m_firstTimeNs;
+
+    QByteArray m_pending;
+    qint64 m_readOffset;     // Consumed prefix of m_pending
+    QTimer *m_timer;
+    QElapsedTimer m_clock;
+    double m_speed;
+    bool m_isOpen;
+    bool m_atEnd;
+    bool m_finished;
+    QString m_errorString;
+    quint64 m_delivered;
+    quint64 m_nextWriteId;
+    qint64 m_finishMs;
+};
+
+#endif // REPLAYSOURCE_H
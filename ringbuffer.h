@@ -0,0 +1,96 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <QByteArray>
+#include <QtGlobal>
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+// Fixed-capacity, lock-free byte ring for exactly one producer thread and
+// one consumer thread. The producer only advances m_head and the consumer
+// only advances m_tail, so no locks are needed; each index lives on its own
+// cache line to avoid false sharing between the two threads.
+class SpscByteRing
+{
+public:
+    explicit SpscByteRing(qsizetype capacityPow2)
+        : m_capacity(capacityPow2)
+        , m_mask(capacityPow2 - 1)
+        , m_buffer(new char[capacityPow2])
+        , m_head(0)
+        , m_tail(0)
+    {
+        Q_ASSERT(capacityPow2 > 0 && (capacityPow2 & (capacityPow2 - 1)) == 0);
+    }
+
+    SpscByteRing(const SpscByteRing &) = delete;
+    SpscByteRing &operator=(const SpscByteRing &) = delete;
+
+    qsizetype capacity() const { return m_capacity; }
+
+    qsizetype size() const
+    {
+        return static_cast<qsizetype>(m_head.load(std::memory_order_acquire)
+                                      - m_tail.load(std::memory_order_acquire));
+    }
+
+    bool isEmpty() const { return size() == 0; }
+
+    // Producer side. Copies as much of data as fits and returns the number
+    // of bytes accepted; the caller accounts for anything left over.
+    qsizetype write(const char *data, qsizetype size)
+    {
+        const quint64 head = m_head.load(std::memory_order_relaxed);
+        const quint64 tail = m_tail.load(std::memory_order_acquire);
+        const qsizetype freeSpace = m_capacity - static_cast<qsizetype>(head - tail);
+        const qsizetype n = qMin(size, freeSpace);
+        if (n <= 0) {
+            return 0;
+        }
+
+        const qsizetype offset = static_cast<qsizetype>(head & m_mask);
+        const qsizetype first = qMin(n, m_capacity - offset);
+        memcpy(m_buffer.get() + offset, data, first);
+        memcpy(m_buffer.get(), data + first, n - first);
+
+        m_head.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer side. Moves up to maxSize bytes out of the ring.
+    QByteArray read(qsizetype maxSize)
+    {
+        const quint64 tail = m_tail.load(std::memory_order_relaxed);
+        const quint64 head = m_head.load(std::memory_order_acquire);
+        const qsizetype n = qMin(maxSize, static_cast<qsizetype>(head - tail));
+        if (n <= 0) {
+            return QByteArray();
+        }
+
+        QByteArray out(n, Qt::Uninitialized);
+        const qsizetype offset = static_cast<qsizetype>(tail & m_mask);
+        const qsizetype first = qMin(n, m_capacity - offset);
+        memcpy(out.data(), m_buffer.get() + offset, first);
+        memcpy(out.data() + first, m_buffer.get(), n - first);
+
+        m_tail.store(tail + n, std::memory_order_release);
+        return out;
+    }
+
+    // Only valid while neither side is running (e.g. between open() calls).
+    void reset()
+    {
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    const qsizetype m_capacity;
+    const quint64 m_mask;
+    std::unique_ptr<char[]> m_buffer;
+    alignas(64) std::atomic<quint64> m_head; // Written by producer
+    alignas(64) std::atomic<quint64> m_tail; // Written by consumer
+};
+
+#endif // RINGBUFFER_H
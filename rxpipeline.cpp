@@ -0,0 +1,73 @@
+#include "rxpipeline.h"
+
+RxPipeline::RxPipeline(qsizetype maxAccumulatedSize, int maxLineLength)
+    : m_parser(maxAccumulatedSize)
+    , m_maxLineLength(maxLineLength)
+{
+}
+
+void RxPipeline::feed(const char *data, qsizetype size, QStringList &logLines, QStringList &commandLines)
+{
+    m_lines.clear();
+    m_parser.feed(data, size, m_lines);
+    dispatch(m_lines, logLines, commandLines);
+}
+
+void RxPipeline::feed(const QByteArray &data, QStringList &logLines, QStringList &commandLines)
+{
+    feed(data.constData(), data.size(), logLines, commandLines);
+}
+
+void RxPipeline::flush(QStringList &logLines, QStringList &commandLines)
+{
+    m_lines.clear();
+    m_parser.flush(m_lines);
+    dispatch(m_lines, logLines, commandLines);
+}
+
+bool RxPipeline::hasPartialLine() const
+{
+    return m_parser.hasPartialLine();
+}
+
+void RxPipeline::reset()
+{
+    m_parser.reset();
+}
+
+const StreamLineParser &RxPipeline::parser() const
+{
+    return m_parser;
+}
+
+const LogClassifier &RxPipeline::classifier() const
+{
+    return m_classifier;
+}
+
+void RxPipeline::dispatch(const QStringList &lines, QStringList &logLines, QStringList &commandLines)
+{
+    for (const QString &line : lines) {
+        // Check if this line is too long (likely fragmented)
+        if (line.length() > m_maxLineLength) {
+            // Split long lines that might be concatenated fragments
+            const QStringList fragments = m_classifier.splitLongLine(line, m_maxLineLength);
+            for (const QString &fragment : fragments) {
+                if (fragment.isEmpty()) continue;
+
+                if (m_classifier.isLogMessage(fragment)) {
+                    logLines.append(fragment);
+                } else {
+                    commandLines.append(fragment);
+                }
+            }
+        } else if (m_classifier.isLogMessage(line)) {
+            logLines.append(line);
+        } else if (m_classifier.isLikelyCorruptedLogLine(line)) {
+            // Corrupted log lines without tags
+            logLines.append(line);
+        } else {
+            commandLines.append(line);
+        }
+    }
+}
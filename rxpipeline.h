@@ -0,0 +1,38 @@
+#ifndef RXPIPELINE_H
+#define RXPIPELINE_H
+
+#include <QByteArray>
+#include <QStringList>
+#include "logclassifier.h"
+#include "streamlineparser.h"
+
+// Turns received bytes into classified lines: StreamLineParser cuts the
+// stream into clean lines, overlong lines are split into fragments and
+// LogClassifier sorts each line into device log output or command output.
+class RxPipeline
+{
+public:
+    explicit RxPipeline(qsizetype maxAccumulatedSize = 65536, int maxLineLength = 8192);
+
+    // Appends the lines completed by these bytes to logLines/commandLines
+    void feed(const char *data, qsizetype size, QStringList &logLines, QStringList &commandLines);
+    void feed(const QByteArray &data, QStringList &logLines, QStringList &commandLines);
+
+    // Dispatches the buffered partial line, e.g. when no newline arrived in time
+    void flush(QStringList &logLines, QStringList &commandLines);
+    bool hasPartialLine() const;
+    void reset();
+
+    const StreamLineParser &parser() const;
+    const LogClassifier &classifier() const;
+
+private:
+    void dispatch(const QStringList &lines, QStringList &logLines, QStringList &commandLines);
+
+    StreamLineParser m_parser;
+    LogClassifier m_classifier;
+    int m_maxLineLength;
+    QStringList m_lines; // Scratch list reused between calls
+};
+
+#endif // RXPIPELINE_H
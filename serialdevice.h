@@ -0,0 +1,41 @@
+#ifndef SERIALDEVICE_H
+#define SERIALDEVICE_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+
+// Byte source/sink the GUI talks to: a real port (SerialPort) or a
+// recorded session played back (ReplaySource). Received bytes are pulled
+// with read() after dataReceived(); writes are queued with enqueue().
+class SerialDevice : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SerialDevice(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+    virtual bool isOpen() const = 0;
+    virtual void close() = 0;
+    virtual QString errorString() const = 0;
+
+    // Queues data for transmission and returns its id (0 on failure).
+    // bytesWritten(id) or writeFailed(id) follows.
+    virtual quint64 enqueue(const QByteArray &data) = 0;
+    virtual QByteArray read(qint64 maxSize) = 0;
+    virtual bool hasData() const = 0;
+
+    // Received bytes lost because the reader fell behind
+    virtual quint64 droppedBytes() const = 0;
+
+signals:
+    void dataReceived();
+    void bytesWritten(quint64 id);
+    void writeFailed(quint64 id, const QString &error);
+    void errorOccurred(const QString &error);
+};
+
+#endif // SERIALDEVICE_H
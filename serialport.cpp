@@ -1,380 +1,346 @@
 #include "serialport.h"
+#include <QThread>
 #include <QTimer>
+#include "iothreadpool.h"
 
-SerialPort::SerialPort(QObject *parent)
-    : QObject(parent)
-    , m_handle(INVALID_HANDLE_VALUE)
-    , m_writeHandle(INVALID_HANDLE_VALUE)
-    , m_isOpen(false)
-    , m_isDualMode(false)
-{
-}
+// Platform-neutral parts of SerialPort. The port handling itself lives in
+// serialport_win.cpp (Win32 comm API) and serialport_unix.cpp (termios).
 
-SerialPort::~SerialPort()
+QString SerialSettings::framing() const
 {
-    close();
+    const char parityChar = parity == EvenParity ? 'E' : parity == OddParity ? 'O' : 'N';
+    return QString("%1%2%3").arg(dataBits).arg(QChar(parityChar)).arg(stopBits);
 }
 
-bool SerialPort::open(const QString &portName, int baudRate)
+bool SerialSettings::setFraming(const QString &framing)
 {
-    if (m_isOpen) {
-        close();
-    }
-
-    // Convert port name to Windows format
-    QString winPortName = portName;
-    if (!winPortName.startsWith("\\\\.\\")) {
-        winPortName = "\\\\.\\" + portName;
-    }
-
-    // Open the serial port
-    m_handle = CreateFileW(
-        reinterpret_cast<LPCWSTR>(winPortName.utf16()),
-        GENERIC_READ | GENERIC_WRITE,
-        0,
-        nullptr,
-        OPEN_EXISTING,
-        FILE_ATTRIBUTE_NORMAL,
-        nullptr
-    );
-
-    if (m_handle == INVALID_HANDLE_VALUE) {
-        setErrorString("Failed to open serial port");
+    const QString text = framing.trimmed().toUpper();
+    if (text.size() != 3 || text[0] < '5' || text[0] > '8' || (text[2] != '1' && text[2] != '2')) {
         return false;
     }
 
-    // Configure the serial port
-    DCB dcb = {0};
-    dcb.DCBlength = sizeof(DCB);
-    
-    if (!GetCommState(m_handle, &dcb)) {
-        setErrorString("Failed to get serial port state");
-        CloseHandle(m_handle);
-        m_handle = INVALID_HANDLE_VALUE;
-        return false;
+    Parity newParity;
+    switch (text[1].toLatin1()) {
+    case 'N': newParity = NoParity; break;
+    case 'E': newParity = EvenParity; break;
+    case 'O': newParity = OddParity; break;
+    default: return false;
     }
 
-    // Set baud rate
-    dcb.BaudRate = baudRate;
-    dcb.ByteSize = 8;
-    dcb.Parity = NOPARITY;
-    dcb.StopBits = ONESTOPBIT;
+    dataBits = text[0].digitValue();
+    parity = newParity;
+    stopBits = text[2].digitValue();
+    return true;
+}
 
-    if (!SetCommState(m_handle, &dcb)) {
-        setErrorString("Failed to set serial port state");
-        CloseHandle(m_handle);
-        m_handle = INVALID_HANDLE_VALUE;
-        return false;
+QString SerialSettings::flowControlName(FlowControl flowControl)
+{
+    switch (flowControl) {
+    case HardwareFlowControl:
+        return "rtscts";
+    case SoftwareFlowControl:
+        return "xonxoff";
+    case NoFlowControl:
+        break;
     }
+    return "none";
+}
 
-    // Set timeouts - Optimized for robust line reconstruction
-    COMMTIMEOUTS timeouts = {0};
-    timeouts.ReadIntervalTimeout = 5;            // Shorter for faster response
-    timeouts.ReadTotalTimeoutConstant = 5;       // Shorter for faster response
-    timeouts.ReadTotalTimeoutMultiplier = 1;
-    timeouts.WriteTotalTimeoutConstant = 2000;   // Longer write timeout for Nordic
-    timeouts.WriteTotalTimeoutMultiplier = 0;
-
-    if (!SetCommTimeouts(m_handle, &timeouts)) {
-        setErrorString("Failed to set serial port timeouts");
-        CloseHandle(m_handle);
-        m_handle = INVALID_HANDLE_VALUE;
+bool SerialSettings::parseFlowControl(const QString &name, FlowControl *flowControl)
+{
+    const QString key = name.trimmed().toLower().remove('/');
+    if (key == "none" || key.isEmpty()) {
+        *flowControl = NoFlowControl;
+    } else if (key == "rtscts" || key == "hardware") {
+        *flowControl = HardwareFlowControl;
+    } else if (key == "xonxoff" || key == "software") {
+        *flowControl = SoftwareFlowControl;
+    } else {
         return false;
     }
+    return true;
+}
 
-    // Purge any existing data
-    PurgeComm(m_handle, PURGE_TXCLEAR | PURGE_RXCLEAR);
+DeviceProfile DeviceProfile::lineRate(const SerialSettings &serial)
+{
+    DeviceProfile profile;
+    profile.chunkSize = 0;
+    profile.interChunkDelayMs = 0;
+    profile.postWriteDelayMs = 0;
+    profile.serial = serial;
+    return profile;
+}
 
-    m_isOpen = true;
-    m_isDualMode = false;
-    m_errorString.clear();
-    return true;
+SerialPort::SerialPort(QObject *parent)
+    : SerialPort(nullptr, parent)
+{
 }
 
-bool SerialPort::openDual(const QString &readPort, const QString &writePort, int baudRate)
+SerialPort::~SerialPort()
 {
-    if (m_isOpen) {
-        close();
-    }
+    close();
+    stopCapture();
+    stopIoThread();
+}
 
-    // Convert port names to Windows format
-    QString readWinPort = readPort;
-    QString writeWinPort = writePort;
-    if (!readWinPort.startsWith("\\\\.\\")) {
-        readWinPort = "\\\\.\\" + readPort;
-    }
-    if (!writeWinPort.startsWith("\\\\.\\")) {
-        writeWinPort = "\\\\.\\" + writePort;
-    }
+QString SerialPort::errorString() const
+{
+    return m_errorString;
+}
 
-    // Open read port (COM9)
-    m_handle = CreateFileW(
-        reinterpret_cast<LPCWSTR>(readWinPort.utf16()),
-        GENERIC_READ,
-        0,
-        nullptr,
-        OPEN_EXISTING,
-        FILE_ATTRIBUTE_NORMAL,
-        nullptr
-    );
-
-    if (m_handle == INVALID_HANDLE_VALUE) {
-        setErrorString(QString("Failed to open read port %1").arg(readPort));
-        return false;
+quint64 SerialPort::enqueue(const QByteArray &data)
+{
+    if (!isOpen()) {
+        setErrorString("Serial port is not open");
+        return 0;
     }
 
-    // Open write port (COM8)
-    m_writeHandle = CreateFileW(
-        reinterpret_cast<LPCWSTR>(writeWinPort.utf16()),
-        GENERIC_WRITE,
-        0,
-        nullptr,
-        OPEN_EXISTING,
-        FILE_ATTRIBUTE_NORMAL,
-        nullptr
-    );
-
-    if (m_writeHandle == INVALID_HANDLE_VALUE) {
-        setErrorString(QString("Failed to open write port %1").arg(writePort));
-        CloseHandle(m_handle);
-        m_handle = INVALID_HANDLE_VALUE;
-        return false;
-    }
+    // Chunking and pacing happen on the I/O thread; completion comes back
+    // through bytesWritten()/writeFailed()
+    const quint64 id = ++m_nextWriteId;
+    runOnIoThread([this, id, data]() {
+        m_writeQueue.enqueue({id, data, 0});
+        pumpWrites();
+    }, false);
+    return id;
+}
 
-    // Configure read port - optimized for fast reading
-    DCB readDcb = {0};
-    readDcb.DCBlength = sizeof(DCB);
-    
-    if (!GetCommState(m_handle, &readDcb)) {
-        setErrorString("Failed to get read port state");
-        CloseHandle(m_handle);
-        CloseHandle(m_writeHandle);
-        m_handle = INVALID_HANDLE_VALUE;
-        m_writeHandle = INVALID_HANDLE_VALUE;
-        return false;
-    }
+qint64 SerialPort::write(const QByteArray &data)
+{
+    return enqueue(data) ? data.size() : -1;
+}
 
-    readDcb.BaudRate = baudRate;
-    readDcb.ByteSize = 8;
-    readDcb.Parity = NOPARITY;
-    readDcb.StopBits = ONESTOPBIT;
-
-    if (!SetCommState(m_handle, &readDcb)) {
-        setErrorString("Failed to set read port state");
-        CloseHandle(m_handle);
-        CloseHandle(m_writeHandle);
-        m_handle = INVALID_HANDLE_VALUE;
-        m_writeHandle = INVALID_HANDLE_VALUE;
-        return false;
-    }
+QByteArray SerialPort::read(qint64 maxSize)
+{
+    return m_rxRing.read(maxSize);
+}
 
-    // Configure write port
-    DCB writeDcb = {0};
-    writeDcb.DCBlength = sizeof(DCB);
-    
-    if (!GetCommState(m_writeHandle, &writeDcb)) {
-        setErrorString("Failed to get write port state");
-        CloseHandle(m_handle);
-        CloseHandle(m_writeHandle);
-        m_handle = INVALID_HANDLE_VALUE;
-        m_writeHandle = INVALID_HANDLE_VALUE;
-        return false;
-    }
+QByteArray SerialPort::readAll()
+{
+    return m_rxRing.read(m_rxRing.size());
+}
 
-    writeDcb.BaudRate = baudRate;
-    writeDcb.ByteSize = 8;
-    writeDcb.Parity = NOPARITY;
-    writeDcb.StopBits = ONESTOPBIT;
-
-    if (!SetCommState(m_writeHandle, &writeDcb)) {
-        setErrorString("Failed to set write port state");
-        CloseHandle(m_handle);
-        CloseHandle(m_writeHandle);
-        m_handle = INVALID_HANDLE_VALUE;
-        m_writeHandle = INVALID_HANDLE_VALUE;
-        return false;
-    }
+bool SerialPort::hasData() const
+{
+    return !m_rxRing.isEmpty();
+}
 
-    // Set timeouts for read port - very aggressive for responsiveness
-    COMMTIMEOUTS readTimeouts = {0};
-    readTimeouts.ReadIntervalTimeout = 1;        // Very short for fast response
-    readTimeouts.ReadTotalTimeoutConstant = 1;   // Very short for fast response
-    readTimeouts.ReadTotalTimeoutMultiplier = 1;
-    readTimeouts.WriteTotalTimeoutConstant = 1000;
-    readTimeouts.WriteTotalTimeoutMultiplier = 0;
-
-    if (!SetCommTimeouts(m_handle, &readTimeouts)) {
-        setErrorString("Failed to set read port timeouts");
-        CloseHandle(m_handle);
-        CloseHandle(m_writeHandle);
-        m_handle = INVALID_HANDLE_VALUE;
-        m_writeHandle = INVALID_HANDLE_VALUE;
-        return false;
-    }
+void SerialPort::setDeviceProfile(const DeviceProfile &profile)
+{
+    m_deviceProfile = profile;
+    runOnIoThread([this, profile]() { m_ioProfile = profile; }, false);
+}
 
-    // Set timeouts for write port
-    COMMTIMEOUTS writeTimeouts = {0};
-    writeTimeouts.ReadIntervalTimeout = 1000;
-    writeTimeouts.ReadTotalTimeoutConstant = 1000;
-    writeTimeouts.ReadTotalTimeoutMultiplier = 1;
-    writeTimeouts.WriteTotalTimeoutConstant = 2000;
-    writeTimeouts.WriteTotalTimeoutMultiplier = 0;
-
-    if (!SetCommTimeouts(m_writeHandle, &writeTimeouts)) {
-        setErrorString("Failed to set write port timeouts");
-        CloseHandle(m_handle);
-        CloseHandle(m_writeHandle);
-        m_handle = INVALID_HANDLE_VALUE;
-        m_writeHandle = INVALID_HANDLE_VALUE;
-        return false;
-    }
+DeviceProfile SerialPort::deviceProfile() const
+{
+    return m_deviceProfile;
+}
 
-    // Purge any existing data
-    PurgeComm(m_handle, PURGE_RXCLEAR);
-    PurgeComm(m_writeHandle, PURGE_TXCLEAR);
+quint64 SerialPort::droppedBytes() const
+{
+    return m_droppedBytes.load(std::memory_order_relaxed);
+}
 
-    m_isOpen = true;
-    m_isDualMode = true;
-    m_errorString.clear();
+bool SerialPort::startCapture(const QString &fileName)
+{
+    stopCapture();
+
+    bool ok = false;
+    QString error;
+    runOnIoThread([this, fileName, &ok, &error]() {
+        ok = m_capture.open(fileName, &error);
+        if (ok) {
+            m_captureTimer->start();
+        }
+    }, true);
+
+    if (!ok) {
+        setErrorString(error);
+        return false;
+    }
+    m_captureFileName = fileName;
     return true;
 }
 
-void SerialPort::close()
+void SerialPort::stopCapture()
 {
-    if (m_isOpen) {
-        if (m_handle != INVALID_HANDLE_VALUE) {
-            CloseHandle(m_handle);
-            m_handle = INVALID_HANDLE_VALUE;
-        }
-        if (m_writeHandle != INVALID_HANDLE_VALUE) {
-            CloseHandle(m_writeHandle);
-            m_writeHandle = INVALID_HANDLE_VALUE;
-        }
-        m_isOpen = false;
-        m_isDualMode = false;
+    if (m_captureFileName.isEmpty()) {
+        return;
     }
+    runOnIoThread([this]() {
+        m_captureTimer->stop();
+        m_capture.close();
+    }, true);
+    m_captureFileName.clear();
 }
 
-bool SerialPort::isOpen() const
+bool SerialPort::isCapturing() const
 {
-    return m_isOpen && m_handle != INVALID_HANDLE_VALUE;
+    return !m_captureFileName.isEmpty();
 }
 
-QString SerialPort::errorString() const
+QString SerialPort::captureFileName() const
 {
-    return m_errorString;
+    return m_captureFileName;
 }
 
-qint64 SerialPort::write(const QByteArray &data)
+void SerialPort::setErrorString(const QString &error)
 {
-    if (!m_isOpen || m_handle == INVALID_HANDLE_VALUE) {
-        setErrorString("Serial port is not open");
-        return -1;
+    m_errorString = error;
+    emit errorOccurred(error);
+}
+
+void SerialPort::startIoThread()
+{
+    if (m_ioPool) {
+        m_ioThread = m_ioPool->acquire();
+    } else {
+        m_ioThread = new QThread(this);
+        m_ioThread->setObjectName("SerialPortIO");
+        m_ioThread->start();
     }
+    m_ioContext = new QObject;
+    m_ioContext->moveToThread(m_ioThread);
+
+    runOnIoThread([this]() {
+        m_pacingTimer = new QTimer(m_ioContext);
+        m_pacingTimer->setSingleShot(true);
+        connect(m_pacingTimer, &QTimer::timeout, m_ioContext, [this]() { pumpWrites(); });
+
+        // append() only flushes when a record arrives
+        m_captureTimer = new QTimer(m_ioContext);
+        m_captureTimer->setInterval(CaptureWriter::FLUSH_INTERVAL_MS);
+        connect(m_captureTimer, &QTimer::timeout, m_ioContext, [this]() { m_capture.flushIfDue(); });
+    }, true);
+}
 
-    DWORD bytesWritten = 0;
-    DWORD totalBytesWritten = 0;
-    const char* buffer = data.constData();
-    DWORD bytesToWrite = static_cast<DWORD>(data.size());
-    
-    // For Nordic terminal, write in smaller chunks
-    const DWORD chunkSize = 32; // Smaller chunks for Nordic
-    
-    while (totalBytesWritten < bytesToWrite) {
-        DWORD currentChunk = (bytesToWrite - totalBytesWritten > chunkSize) ? 
-                             chunkSize : (bytesToWrite - totalBytesWritten);
-        
-        if (!WriteFile(m_handle, buffer + totalBytesWritten, currentChunk, &bytesWritten, nullptr)) {
-            setErrorString("Failed to write to serial port");
-            return -1;
-        }
-        
-        totalBytesWritten += bytesWritten;
-        
-        // Small delay between chunks for Nordic
-        if (totalBytesWritten < bytesToWrite) {
-            Sleep(1);
+void SerialPort::stopIoThread()
+{
+    if (m_ioThread) {
+        runOnIoThread([this]() {
+            delete m_pacingTimer;
+            m_pacingTimer = nullptr;
+            delete m_captureTimer;
+            m_captureTimer = nullptr;
+        }, true);
+        if (m_ioPool) {
+            // The thread keeps running for other ports. Nothing is queued
+            // for the context any more (the call above drained it), so the
+            // thread can delete it in its own time
+            m_ioContext->deleteLater();
+            m_ioPool->release(m_ioThread);
+        } else {
+            m_ioThread->quit();
+            m_ioThread->wait();
+            delete m_ioContext;
         }
+        m_ioContext = nullptr;
+        m_ioThread = nullptr; // Deleted with this as parent, or the pool's
     }
+}
 
-    // Flush the serial port to ensure data is sent immediately
-    FlushFileBuffers(m_handle);
-
-    // For Nordic terminal, shorter delay
-    if (totalBytesWritten > 0) {
-        Sleep(50); // 50ms delay for Nordic terminal
+void SerialPort::runOnIoThread(const std::function<void()> &work, bool wait)
+{
+    if (QThread::currentThread() == m_ioThread) {
+        work();
+        return;
     }
-
-    return static_cast<qint64>(totalBytesWritten);
+    QMetaObject::invokeMethod(m_ioContext, work,
+                              wait ? Qt::BlockingQueuedConnection : Qt::QueuedConnection);
 }
 
-QByteArray SerialPort::readAll()
+void SerialPort::deliverReceived(const char *data, qint64 size)
 {
-    QByteArray data;
-    if (!m_isOpen || m_handle == INVALID_HANDLE_VALUE) {
-        return data;
-    }
+    // Called on the I/O thread. The capture sees every byte, even ones the
+    // ring has no room for
+    m_capture.append(Capture::Rx, data, size);
 
-    // Check if there's data available
-    DWORD errors;
-    COMSTAT stat;
-    if (!ClearCommError(m_handle, &errors, &stat)) {
-        return data;
+    const qint64 accepted = m_rxRing.write(data, size);
+    if (accepted < size) {
+        m_droppedBytes.fetch_add(static_cast<quint64>(size - accepted), std::memory_order_relaxed);
     }
 
-    if (stat.cbInQue == 0) {
-        return data;
+    // Post at most one wakeup until the owner has picked it up
+    if (accepted > 0 && !m_notifyPending.exchange(true)) {
+        QMetaObject::invokeMethod(this, [this]() {
+            m_notifyPending.store(false);
+            emit dataReceived();
+        }, Qt::QueuedConnection);
     }
+}
 
-    // Read available data in optimal chunks for robust line reconstruction
-    const int maxChunkSize = 8192; // 8KB chunks for better line integrity
-    char buffer[maxChunkSize];
-    
-    while (true) {
-        // Check how much data is available
-        if (!ClearCommError(m_handle, &errors, &stat)) {
-            break;
-        }
-        
-        if (stat.cbInQue == 0) {
-            break;
+void SerialPort::postError(const QString &error)
+{
+    QMetaObject::invokeMethod(this, [this, error]() {
+        setErrorString(error);
+    }, Qt::QueuedConnection);
+}
+
+void SerialPort::pumpWrites()
+{
+    // I/O thread: keep starting chunks until one is pending, the pacing
+    // timer is running or the queue is empty
+    while (!m_writeInFlight && !m_pacingTimer->isActive() && !m_writeQueue.isEmpty()) {
+        const PendingWrite &front = m_writeQueue.head();
+        const qint64 remaining = front.data.size() - front.offset;
+        if (remaining == 0) {
+            completeChunk(0);
+            continue;
         }
-        
-        // Read in smaller chunks
-        DWORD bytesToRead = (stat.cbInQue > maxChunkSize) ? maxChunkSize : stat.cbInQue;
-        DWORD bytesRead = 0;
-        
-        if (ReadFile(m_handle, buffer, bytesToRead, &bytesRead, nullptr) && bytesRead > 0) {
-            data.append(buffer, static_cast<int>(bytesRead));
-        } else {
-            break;
+
+        const qint64 chunk = m_ioProfile.chunkSize > 0
+            ? qMin<qint64>(m_ioProfile.chunkSize, remaining) : remaining;
+
+        QString error;
+        const qint64 written = startWrite(front.data.constData() + front.offset, chunk, &error);
+        if (written < 0) {
+            failWrites(error, true);
+            return;
         }
-        
-        // Minimal delay to prevent blocking while maintaining line integrity
-        if (bytesRead < bytesToRead) {
-            Sleep(1);
+        if (written == 0) {
+            m_writeInFlight = true;
+            return;
         }
+        completeChunk(written);
     }
-
-    return data;
 }
 
-bool SerialPort::hasData() const
+void SerialPort::completeChunk(qint64 written)
 {
-    if (!m_isOpen || m_handle == INVALID_HANDLE_VALUE) {
-        return false;
+    m_writeInFlight = false;
+
+    PendingWrite &front = m_writeQueue.head();
+    m_capture.append(Capture::Tx, front.data.constData() + front.offset, written);
+    front.offset += written;
+
+    int delayMs = m_ioProfile.interChunkDelayMs;
+    if (front.offset >= front.data.size()) {
+        const quint64 id = front.id;
+        m_writeQueue.dequeue();
+        QMetaObject::invokeMethod(this, [this, id]() {
+            emit bytesWritten(id);
+        }, Qt::QueuedConnection);
+        delayMs = m_ioProfile.postWriteDelayMs;
     }
 
-    DWORD errors;
-    COMSTAT stat;
-    if (ClearCommError(m_handle, &errors, &stat)) {
-        return stat.cbInQue > 0;
+    if (delayMs > 0) {
+        m_pacingTimer->start(delayMs);
     }
-    return false;
 }
 
-void SerialPort::setErrorString(const QString &error)
+void SerialPort::failWrites(const QString &error, bool reportError)
 {
-    m_errorString = error;
-    emit errorOccurred(error);
-} 
\ No newline at end of file
+    m_writeInFlight = false;
+    m_pacingTimer->stop();
+
+    while (!m_writeQueue.isEmpty()) {
+        const quint64 id = m_writeQueue.dequeue().id;
+        QMetaObject::invokeMethod(this, [this, id, error]() {
+            emit writeFailed(id, error);
+        }, Qt::QueuedConnection);
+    }
+
+    if (reportError) {
+        postError(error);
+    }
+}
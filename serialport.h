@@ -1,40 +1,186 @@
 #ifndef SERIALPORT_H
 #define SERIALPORT_H
 
-#include <QObject>
+#include <QQueue>
 #include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <functional>
+#include "capturefile.h"
+#include "ringbuffer.h"
+#include "serialdevice.h"
+
+#ifdef Q_OS_WIN
 #include <windows.h>
+#endif
+
+QT_BEGIN_NAMESPACE
+class QSocketNotifier;
+class QThread;
+class QTimer;
+class QWinEventNotifier;
+QT_END_NAMESPACE
+
+class IoThreadPool;
+
+// Line settings, applied when a port is opened. The defaults are 8N1
+// without flow control, what the Nordic shell UART uses out of the box.
+struct SerialSettings
+{
+    enum Parity {
+        NoParity,
+        EvenParity,
+        OddParity
+    };
+
+    enum FlowControl {
+        NoFlowControl,
+        HardwareFlowControl,  // RTS/CTS
+        SoftwareFlowControl   // XON/XOFF
+    };
+
+    int dataBits = 8;         // 5-8
+    Parity parity = NoParity;
+    int stopBits = 1;         // 1 or 2
+    FlowControl flowControl = NoFlowControl;
+    int rxBufferSize = 0;     // Driver queue sizes, 0 = driver default. Win32
+    int txBufferSize = 0;     // only (SetupComm); tty queues are fixed
+
+    // "8N1", "7E2", ...
+    QString framing() const;
+    bool setFraming(const QString &framing);
+    // "none", "rtscts", "xonxoff"
+    static QString flowControlName(FlowControl flowControl);
+    static bool parseFlowControl(const QString &name, FlowControl *flowControl);
+};
+
+// How a port is set up and queued writes are paced on the wire. The
+// default pacing is what the Nordic shell UART needs without flow control.
+struct DeviceProfile
+{
+    int chunkSize = 32;         // Bytes per write call, 0 = write in one go
+    int interChunkDelayMs = 1;  // Gap between chunks of one write
+    int postWriteDelayMs = 50;  // Settle time before the next queued write
+    SerialSettings serial;      // Takes effect at the next open()
 
-class SerialPort : public QObject
+    // No pacing at all: with flow control the device holds writes back
+    // itself, so data goes out at line rate
+    static DeviceProfile lineRate(const SerialSettings &serial);
+};
+
+// All port I/O runs on a dedicated thread owned by the SerialPort. Received
+// bytes are pushed into a lock-free ring and dataReceived() is emitted on
+// the owner's thread; the owner drains the ring with read()/readAll().
+// Writes are queued with enqueue() and complete asynchronously. With an
+// IoThreadPool the I/O thread is borrowed from the pool instead, so many
+// ports can share a few threads. The thread is taken in the constructor and
+// only given back by the destructor, so the port must be deleted (not just
+// closed) before the pool.
+class SerialPort : public SerialDevice
 {
     Q_OBJECT
 
 public:
     explicit SerialPort(QObject *parent = nullptr);
+    explicit SerialPort(IoThreadPool *ioPool, QObject *parent = nullptr);
     ~SerialPort();
 
     bool open(const QString &portName, int baudRate);
     bool openDual(const QString &readPort, const QString &writePort, int baudRate);
-    void close();
-    bool isOpen() const;
-    QString errorString() const;
-    
+    void close() override;
+    bool isOpen() const override;
+    QString errorString() const override;
+
+    // Returns 0 if the port is closed
+    quint64 enqueue(const QByteArray &data) override;
     qint64 write(const QByteArray &data);
+    QByteArray read(qint64 maxSize) override;
     QByteArray readAll();
-    bool hasData() const;
+    bool hasData() const override;
+
+    void setDeviceProfile(const DeviceProfile &profile);
+    DeviceProfile deviceProfile() const;
+
+    // Bytes lost because the GUI fell behind and the RX ring was full
+    quint64 droppedBytes() const override;
+
+    // Records raw RX/TX bytes with timestamps (see capturefile.h) until
+    // stopCapture(); keeps running across close()/open()
+    bool startCapture(const QString &fileName);
+    void stopCapture();
+    bool isCapturing() const;
+    QString captureFileName() const;
 
-signals:
-    void dataReceived();
-    void errorOccurred(const QString &error);
+    static const int RX_RING_SIZE = 1 << 20; // 1MB between I/O thread and GUI
 
 private:
+    struct PendingWrite
+    {
+        quint64 id;
+        QByteArray data;
+        qint64 offset;
+    };
+
+#ifdef Q_OS_WIN
     HANDLE m_handle;
     HANDLE m_writeHandle;  // Separate handle for writing
+    OVERLAPPED m_readOverlapped;   // WaitCommEvent
+    OVERLAPPED m_writeOverlapped;
+    OVERLAPPED m_drainOverlapped;  // Synchronous reads of queued input
+    DWORD m_commEvents;
+    QWinEventNotifier *m_readNotifier;
+    QWinEventNotifier *m_writeNotifier;
+#else
+    int m_fd;
+    int m_writeFd;         // Separate fd for writing
+    QSocketNotifier *m_readNotifier;
+    QSocketNotifier *m_writeNotifier;
+#endif
     bool m_isOpen;
     bool m_isDualMode;
     QString m_errorString;
-    
+    DeviceProfile m_deviceProfile;
+
+    // I/O thread state
+    IoThreadPool *m_ioPool;  // Owns m_ioThread if set
+    QThread *m_ioThread;
+    QObject *m_ioContext;  // Lives on m_ioThread; target for queued I/O work
+    SpscByteRing m_rxRing;
+    std::atomic<quint64> m_droppedBytes;
+    std::atomic<bool> m_notifyPending;
+    std::atomic<quint64> m_nextWriteId;
+    QQueue<PendingWrite> m_writeQueue;  // I/O thread only
+    DeviceProfile m_ioProfile;          // I/O thread copy of m_deviceProfile
+    QTimer *m_pacingTimer;
+    bool m_writeInFlight;
+    CaptureWriter m_capture;            // I/O thread only
+    QTimer *m_captureTimer;             // Flushes the capture on an idle link
+    QString m_captureFileName;          // Owner thread view of the capture
+
     void setErrorString(const QString &error);
+
+    // Common helpers (serialport.cpp)
+    void startIoThread();
+    void stopIoThread();
+    void runOnIoThread(const std::function<void()> &work, bool wait);
+    void deliverReceived(const char *data, qint64 size);
+    void postError(const QString &error);
+    void pumpWrites();
+    void completeChunk(qint64 written);
+    void failWrites(const QString &error, bool reportError);
+
+    // Platform hooks, always called on the I/O thread
+    void startReading();
+    void stopReading();
+    void readPending();
+    // Starts writing a chunk: returns bytes written now, 0 if the write is
+    // pending (completion re-enters completeChunk() or pumpWrites()), or -1
+    qint64 startWrite(const char *data, qint64 size, QString *error);
+#ifdef Q_OS_WIN
+    HANDLE writeHandle() const;
+    bool armCommEvent();
+    bool drainInput();
+#endif
 };
 
-#endif // SERIALPORT_H 
\ No newline at end of file
+#endif // SERIALPORT_H
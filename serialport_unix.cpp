@@ -0,0 +1,382 @@
+#include "serialport.h"
+#include <QSocketNotifier>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#ifdef Q_OS_MACOS
+#include <IOKit/serial/ioss.h>
+#endif
+
+namespace {
+
+#ifdef Q_OS_LINUX
+// The kernel's struct termios2 (<asm/termbits.h>, which can't be included
+// next to <termios.h>). Its BOTHER speed flag takes any rate in c_ospeed.
+struct Termios2
+{
+    tcflag_t c_iflag;
+    tcflag_t c_oflag;
+    tcflag_t c_cflag;
+    tcflag_t c_lflag;
+    cc_t c_line;
+    cc_t c_cc[19];
+    speed_t c_ispeed;
+    speed_t c_ospeed;
+};
+
+const unsigned long TCGETS2_REQUEST = _IOR('T', 0x2A, Termios2);
+const unsigned long TCSETS2_REQUEST = _IOW('T', 0x2B, Termios2);
+const tcflag_t BOTHER_SPEED = 0010000;
+const int CIBAUD_SHIFT = 16;
+#endif
+
+speed_t toSpeed(int baudRate)
+{
+    switch (baudRate) {
+    case 9600:   return B9600;
+    case 19200:  return B19200;
+    case 38400:  return B38400;
+    case 57600:  return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+#ifdef B460800
+    case 460800: return B460800;
+#endif
+#ifdef B921600
+    case 921600: return B921600;
+#endif
+#ifdef B1000000
+    case 1000000: return B1000000;
+#endif
+    default:     return B0;
+    }
+}
+
+QString devicePath(const QString &portName)
+{
+    // QSerialPortInfo reports bare names like "ttyACM0"
+    if (portName.startsWith('/')) {
+        return portName;
+    }
+    return "/dev/" + portName;
+}
+
+QString systemError(const QString &what)
+{
+    return QString("%1: %2").arg(what, QString::fromLocal8Bit(strerror(errno)));
+}
+
+// Rates without a Bxxx constant go straight to the driver
+bool setCustomBaudRate(int fd, int baudRate, QString *error)
+{
+#if defined(Q_OS_LINUX)
+    Termios2 tio;
+    if (::ioctl(fd, TCGETS2_REQUEST, &tio) != 0) {
+        *error = systemError("Failed to get serial port state");
+        return false;
+    }
+    // CIBAUD cleared: input runs at the output rate
+    tio.c_cflag &= ~(CBAUD | (CBAUD << CIBAUD_SHIFT));
+    tio.c_cflag |= BOTHER_SPEED;
+    tio.c_ispeed = speed_t(baudRate);
+    tio.c_ospeed = speed_t(baudRate);
+    if (::ioctl(fd, TCSETS2_REQUEST, &tio) != 0) {
+        *error = systemError(QString("Baud rate %1 not supported").arg(baudRate));
+        return false;
+    }
+    return true;
+#elif defined(Q_OS_MACOS)
+    speed_t speed = speed_t(baudRate);
+    if (::ioctl(fd, IOSSIOSPEED, &speed) != 0) {
+        *error = systemError(QString("Baud rate %1 not supported").arg(baudRate));
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED(fd);
+    *error = QString("Unsupported baud rate %1").arg(baudRate);
+    return false;
+#endif
+}
+
+tcflag_t characterSize(int dataBits)
+{
+    switch (dataBits) {
+    case 5: return CS5;
+    case 6: return CS6;
+    case 7: return CS7;
+    default: return CS8;
+    }
+}
+
+// Opens a tty in raw mode with the given framing and flow control. The fd
+// stays non-blocking so reads can be driven by QSocketNotifier instead of
+// polling; with RTS/CTS or XON/XOFF a full driver queue shows up as EAGAIN
+// and the write notifier resumes once the device lets data through.
+int openTty(const QString &portName, int flags, int baudRate, const SerialSettings &settings, QString *error)
+{
+    if (baudRate <= 0) {
+        *error = QString("Invalid baud rate %1").arg(baudRate);
+        return -1;
+    }
+    if (settings.dataBits < 5 || settings.dataBits > 8 || (settings.stopBits != 1 && settings.stopBits != 2)) {
+        *error = QString("Unsupported framing %1").arg(settings.framing());
+        return -1;
+    }
+#ifndef CRTSCTS
+    if (settings.flowControl == SerialSettings::HardwareFlowControl) {
+        *error = "RTS/CTS flow control is not supported on this platform";
+        return -1;
+    }
+#endif
+    const speed_t speed = toSpeed(baudRate);
+
+    const QByteArray path = devicePath(portName).toLocal8Bit();
+    int fd = ::open(path.constData(), flags | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        *error = systemError(QString("Failed to open %1").arg(portName));
+        return -1;
+    }
+
+    termios tio;
+    if (tcgetattr(fd, &tio) != 0) {
+        *error = systemError("Failed to get serial port state");
+        ::close(fd);
+        return -1;
+    }
+
+    cfmakeraw(&tio);
+    tio.c_cflag &= ~(CSIZE | PARENB | PARODD | CSTOPB);
+    tio.c_cflag |= characterSize(settings.dataBits) | CLOCAL | CREAD;
+    if (settings.parity != SerialSettings::NoParity) {
+        tio.c_cflag |= PARENB;
+        tio.c_iflag |= INPCK; // Drop bytes that fail the check
+        if (settings.parity == SerialSettings::OddParity) {
+            tio.c_cflag |= PARODD;
+        }
+    }
+    if (settings.stopBits == 2) {
+        tio.c_cflag |= CSTOPB;
+    }
+
+    tio.c_iflag &= ~(IXON | IXOFF | IXANY);
+#ifdef CRTSCTS
+    tio.c_cflag &= ~CRTSCTS;
+    if (settings.flowControl == SerialSettings::HardwareFlowControl) {
+        tio.c_cflag |= CRTSCTS;
+    }
+#endif
+    if (settings.flowControl == SerialSettings::SoftwareFlowControl) {
+        tio.c_iflag |= IXON | IXOFF;
+        tio.c_cc[VSTART] = 0x11;
+        tio.c_cc[VSTOP] = 0x13;
+    }
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    // A custom rate is set afterwards; until then the port idles at 9600
+    cfsetispeed(&tio, speed != B0 ? speed : B9600);
+    cfsetospeed(&tio, speed != B0 ? speed : B9600);
+
+    if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+        *error = systemError("Failed to set serial port state");
+        ::close(fd);
+        return -1;
+    }
+    if (speed == B0 && !setCustomBaudRate(fd, baudRate, error)) {
+        ::close(fd);
+        return -1;
+    }
+
+    // Purge any existing data
+    tcflush(fd, TCIOFLUSH);
+    return fd;
+}
+
+} // namespace
+
+SerialPort::SerialPort(IoThreadPool *ioPool, QObject *parent)
+    : SerialDevice(parent)
+    , m_fd(-1)
+    , m_writeFd(-1)
+    , m_readNotifier(nullptr)
+    , m_writeNotifier(nullptr)
+    , m_isOpen(false)
+    , m_isDualMode(false)
+    , m_ioPool(ioPool)
+    , m_ioThread(nullptr)
+    , m_ioContext(nullptr)
+    , m_rxRing(RX_RING_SIZE)
+    , m_droppedBytes(0)
+    , m_notifyPending(false)
+    , m_nextWriteId(0)
+    , m_pacingTimer(nullptr)
+    , m_writeInFlight(false)
+    , m_captureTimer(nullptr)
+{
+    startIoThread();
+}
+
+bool SerialPort::open(const QString &portName, int baudRate)
+{
+    if (m_isOpen) {
+        close();
+    }
+
+    QString error;
+    m_fd = openTty(portName, O_RDWR, baudRate, m_deviceProfile.serial, &error);
+    if (m_fd < 0) {
+        setErrorString(error);
+        return false;
+    }
+
+    m_rxRing.reset();
+    m_droppedBytes = 0;
+    runOnIoThread([this]() { startReading(); }, true);
+
+    m_isOpen = true;
+    m_isDualMode = false;
+    m_errorString.clear();
+    return true;
+}
+
+bool SerialPort::openDual(const QString &readPort, const QString &writePort, int baudRate)
+{
+    if (m_isOpen) {
+        close();
+    }
+
+    QString error;
+    m_fd = openTty(readPort, O_RDONLY, baudRate, m_deviceProfile.serial, &error);
+    if (m_fd < 0) {
+        setErrorString(QString("Failed to open read port %1: %2").arg(readPort, error));
+        return false;
+    }
+
+    m_writeFd = openTty(writePort, O_WRONLY, baudRate, m_deviceProfile.serial, &error);
+    if (m_writeFd < 0) {
+        ::close(m_fd);
+        m_fd = -1;
+        setErrorString(QString("Failed to open write port %1: %2").arg(writePort, error));
+        return false;
+    }
+
+    m_rxRing.reset();
+    m_droppedBytes = 0;
+    runOnIoThread([this]() { startReading(); }, true);
+
+    m_isOpen = true;
+    m_isDualMode = true;
+    m_errorString.clear();
+    return true;
+}
+
+void SerialPort::close()
+{
+    if (m_isOpen) {
+        // Anything still queued is reported through writeFailed()
+        runOnIoThread([this]() {
+            stopReading();
+            failWrites("Serial port closed", false);
+        }, true);
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+        if (m_writeFd >= 0) {
+            ::close(m_writeFd);
+            m_writeFd = -1;
+        }
+        m_isOpen = false;
+        m_isDualMode = false;
+    }
+}
+
+bool SerialPort::isOpen() const
+{
+    return m_isOpen && m_fd >= 0;
+}
+
+void SerialPort::startReading()
+{
+    m_readNotifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, m_ioContext);
+    connect(m_readNotifier, &QSocketNotifier::activated, m_ioContext, [this]() { readPending(); });
+
+    // Only enabled while the driver's TX queue is full
+    const int writeFd = m_writeFd >= 0 ? m_writeFd : m_fd;
+    m_writeNotifier = new QSocketNotifier(writeFd, QSocketNotifier::Write, m_ioContext);
+    m_writeNotifier->setEnabled(false);
+    connect(m_writeNotifier, &QSocketNotifier::activated, m_ioContext, [this]() {
+        m_writeNotifier->setEnabled(false);
+        m_writeInFlight = false;
+        pumpWrites();
+    });
+}
+
+void SerialPort::stopReading()
+{
+    delete m_readNotifier;
+    m_readNotifier = nullptr;
+    delete m_writeNotifier;
+    m_writeNotifier = nullptr;
+}
+
+void SerialPort::readPending()
+{
+    const int maxChunkSize = 8192;
+    char buffer[maxChunkSize];
+
+    while (true) {
+        ssize_t n = ::read(m_fd, buffer, maxChunkSize);
+        if (n > 0) {
+            deliverReceived(buffer, n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && errno == EAGAIN) {
+            return;
+        }
+        if (n == 0) {
+            // With VMIN=VTIME=0 an empty tty reads 0, so that alone isn't
+            // EOF; only a hang-up on the fd means the device went away
+            struct pollfd pfd = { m_fd, POLLIN, 0 };
+            if (::poll(&pfd, 1, 0) <= 0 || !(pfd.revents & (POLLHUP | POLLERR | POLLNVAL))) {
+                return;
+            }
+        }
+        // A hang-up or EIO on a tty means the device went away (e.g. USB
+        // unplug). Stop the notifier from spinning on the dead fd before
+        // reporting.
+        m_readNotifier->setEnabled(false);
+        postError(n == 0 ? QString("Serial device disconnected")
+                         : systemError("Failed to read from serial port"));
+        return;
+    }
+}
+
+qint64 SerialPort::startWrite(const char *data, qint64 size, QString *error)
+{
+    const int fd = m_writeFd >= 0 ? m_writeFd : m_fd;
+    while (true) {
+        ssize_t n = ::write(fd, data, size);
+        if (n > 0) {
+            return n;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && errno == EAGAIN) {
+            // Retry the same chunk once the fd is writable again
+            m_writeNotifier->setEnabled(true);
+            return 0;
+        }
+        *error = systemError("Failed to write to serial port");
+        return -1;
+    }
+}
@@ -0,0 +1,441 @@
+#include "serialport.h"
+#include <QWinEventNotifier>
+
+namespace {
+
+const DWORD DEFAULT_QUEUE_SIZE = 4096;
+
+// Sets rate, framing, flow control and driver queue sizes on one handle.
+// Every DCB flow-control field is set, so nothing is left over from
+// whatever used the port last.
+bool configureComm(HANDLE handle, const QString &what, int baudRate, const SerialSettings &settings,
+                   QString *error)
+{
+    DCB dcb = {0};
+    dcb.DCBlength = sizeof(DCB);
+
+    if (!GetCommState(handle, &dcb)) {
+        *error = QString("Failed to get %1 state").arg(what);
+        return false;
+    }
+
+    // Any rate the driver accepts; USB CDC and FTDI adapters take
+    // 1000000 and other non-standard values
+    dcb.BaudRate = baudRate;
+    dcb.fBinary = TRUE;
+    dcb.ByteSize = BYTE(settings.dataBits);
+    dcb.Parity = settings.parity == SerialSettings::EvenParity ? EVENPARITY
+        : settings.parity == SerialSettings::OddParity ? ODDPARITY : NOPARITY;
+    dcb.fParity = settings.parity != SerialSettings::NoParity;
+    dcb.StopBits = settings.stopBits == 2 ? TWOSTOPBITS : ONESTOPBIT;
+
+    const bool hardware = settings.flowControl == SerialSettings::HardwareFlowControl;
+    const bool software = settings.flowControl == SerialSettings::SoftwareFlowControl;
+    dcb.fOutxCtsFlow = hardware;
+    dcb.fRtsControl = hardware ? RTS_CONTROL_HANDSHAKE : RTS_CONTROL_ENABLE;
+    dcb.fOutxDsrFlow = FALSE;
+    dcb.fDtrControl = DTR_CONTROL_ENABLE;
+    dcb.fDsrSensitivity = FALSE;
+    dcb.fOutX = software;
+    dcb.fInX = software;
+    dcb.XonChar = 0x11;
+    dcb.XoffChar = 0x13;
+
+    if (!SetCommState(handle, &dcb)) {
+        *error = QString("Failed to set %1 state (%2 baud, %3, flow control %4)")
+            .arg(what).arg(baudRate).arg(settings.framing(), SerialSettings::flowControlName(settings.flowControl));
+        return false;
+    }
+
+    if (settings.rxBufferSize > 0 || settings.txBufferSize > 0) {
+        const DWORD rxSize = settings.rxBufferSize > 0 ? DWORD(settings.rxBufferSize) : DEFAULT_QUEUE_SIZE;
+        const DWORD txSize = settings.txBufferSize > 0 ? DWORD(settings.txBufferSize) : DEFAULT_QUEUE_SIZE;
+        if (!SetupComm(handle, rxSize, txSize)) {
+            *error = QString("Failed to set %1 buffer sizes").arg(what);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+SerialPort::SerialPort(IoThreadPool *ioPool, QObject *parent)
+    : SerialDevice(parent)
+    , m_handle(INVALID_HANDLE_VALUE)
+    , m_writeHandle(INVALID_HANDLE_VALUE)
+    , m_readOverlapped()
+    , m_writeOverlapped()
+    , m_drainOverlapped()
+    , m_commEvents(0)
+    , m_readNotifier(nullptr)
+    , m_writeNotifier(nullptr)
+    , m_isOpen(false)
+    , m_isDualMode(false)
+    , m_ioPool(ioPool)
+    , m_ioThread(nullptr)
+    , m_ioContext(nullptr)
+    , m_rxRing(RX_RING_SIZE)
+    , m_droppedBytes(0)
+    , m_notifyPending(false)
+    , m_nextWriteId(0)
+    , m_pacingTimer(nullptr)
+    , m_writeInFlight(false)
+    , m_captureTimer(nullptr)
+{
+    startIoThread();
+}
+
+bool SerialPort::open(const QString &portName, int baudRate)
+{
+    if (m_isOpen) {
+        close();
+    }
+
+    // Convert port name to Windows format
+    QString winPortName = portName;
+    if (!winPortName.startsWith("\\\\.\\")) {
+        winPortName = "\\\\.\\" + portName;
+    }
+
+    // Open the serial port
+    m_handle = CreateFileW(
+        reinterpret_cast<LPCWSTR>(winPortName.utf16()),
+        GENERIC_READ | GENERIC_WRITE,
+        0,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_FLAG_OVERLAPPED,  // Reads and writes complete on the I/O thread's event loop
+        nullptr
+    );
+
+    if (m_handle == INVALID_HANDLE_VALUE) {
+        setErrorString("Failed to open serial port");
+        return false;
+    }
+
+    // Configure the serial port
+    QString error;
+    if (!configureComm(m_handle, "serial port", baudRate, m_deviceProfile.serial, &error)) {
+        setErrorString(error);
+        CloseHandle(m_handle);
+        m_handle = INVALID_HANDLE_VALUE;
+        return false;
+    }
+
+    // Set timeouts - reads return immediately with whatever is queued,
+    // arrival is signalled by WaitCommEvent
+    COMMTIMEOUTS timeouts = {0};
+    timeouts.ReadIntervalTimeout = MAXDWORD;
+    timeouts.ReadTotalTimeoutConstant = 0;
+    timeouts.ReadTotalTimeoutMultiplier = 0;
+    timeouts.WriteTotalTimeoutConstant = 2000;   // Longer write timeout for Nordic
+    timeouts.WriteTotalTimeoutMultiplier = 0;
+
+    if (!SetCommTimeouts(m_handle, &timeouts)) {
+        setErrorString("Failed to set serial port timeouts");
+        CloseHandle(m_handle);
+        m_handle = INVALID_HANDLE_VALUE;
+        return false;
+    }
+
+    // Purge any existing data
+    PurgeComm(m_handle, PURGE_TXCLEAR | PURGE_RXCLEAR);
+
+    m_rxRing.reset();
+    m_droppedBytes = 0;
+    runOnIoThread([this]() { startReading(); }, true);
+
+    m_isOpen = true;
+    m_isDualMode = false;
+    m_errorString.clear();
+    return true;
+}
+
+bool SerialPort::openDual(const QString &readPort, const QString &writePort, int baudRate)
+{
+    if (m_isOpen) {
+        close();
+    }
+
+    // Convert port names to Windows format
+    QString readWinPort = readPort;
+    QString writeWinPort = writePort;
+    if (!readWinPort.startsWith("\\\\.\\")) {
+        readWinPort = "\\\\.\\" + readPort;
+    }
+    if (!writeWinPort.startsWith("\\\\.\\")) {
+        writeWinPort = "\\\\.\\" + writePort;
+    }
+
+    // Open read port (COM9)
+    m_handle = CreateFileW(
+        reinterpret_cast<LPCWSTR>(readWinPort.utf16()),
+        GENERIC_READ,
+        0,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_FLAG_OVERLAPPED,  // Reads and writes complete on the I/O thread's event loop
+        nullptr
+    );
+
+    if (m_handle == INVALID_HANDLE_VALUE) {
+        setErrorString(QString("Failed to open read port %1").arg(readPort));
+        return false;
+    }
+
+    // Open write port (COM8)
+    m_writeHandle = CreateFileW(
+        reinterpret_cast<LPCWSTR>(writeWinPort.utf16()),
+        GENERIC_WRITE,
+        0,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_FLAG_OVERLAPPED,  // Reads and writes complete on the I/O thread's event loop
+        nullptr
+    );
+
+    if (m_writeHandle == INVALID_HANDLE_VALUE) {
+        setErrorString(QString("Failed to open write port %1").arg(writePort));
+        CloseHandle(m_handle);
+        m_handle = INVALID_HANDLE_VALUE;
+        return false;
+    }
+
+    // Configure both ports the same way
+    QString error;
+    if (!configureComm(m_handle, "read port", baudRate, m_deviceProfile.serial, &error)
+        || !configureComm(m_writeHandle, "write port", baudRate, m_deviceProfile.serial, &error)) {
+        setErrorString(error);
+        CloseHandle(m_handle);
+        CloseHandle(m_writeHandle);
+        m_handle = INVALID_HANDLE_VALUE;
+        m_writeHandle = INVALID_HANDLE_VALUE;
+        return false;
+    }
+
+    // Set timeouts for read port - return immediately, WaitCommEvent
+    // signals arrival
+    COMMTIMEOUTS readTimeouts = {0};
+    readTimeouts.ReadIntervalTimeout = MAXDWORD;
+    readTimeouts.ReadTotalTimeoutConstant = 0;
+    readTimeouts.ReadTotalTimeoutMultiplier = 0;
+    readTimeouts.WriteTotalTimeoutConstant = 1000;
+    readTimeouts.WriteTotalTimeoutMultiplier = 0;
+
+    if (!SetCommTimeouts(m_handle, &readTimeouts)) {
+        setErrorString("Failed to set read port timeouts");
+        CloseHandle(m_handle);
+        CloseHandle(m_writeHandle);
+        m_handle = INVALID_HANDLE_VALUE;
+        m_writeHandle = INVALID_HANDLE_VALUE;
+        return false;
+    }
+
+    // Set timeouts for write port
+    COMMTIMEOUTS writeTimeouts = {0};
+    writeTimeouts.ReadIntervalTimeout = 1000;
+    writeTimeouts.ReadTotalTimeoutConstant = 1000;
+    writeTimeouts.ReadTotalTimeoutMultiplier = 1;
+    writeTimeouts.WriteTotalTimeoutConstant = 2000;
+    writeTimeouts.WriteTotalTimeoutMultiplier = 0;
+
+    if (!SetCommTimeouts(m_writeHandle, &writeTimeouts)) {
+        setErrorString("Failed to set write port timeouts");
+        CloseHandle(m_handle);
+        CloseHandle(m_writeHandle);
+        m_handle = INVALID_HANDLE_VALUE;
+        m_writeHandle = INVALID_HANDLE_VALUE;
+        return false;
+    }
+
+    // Purge any existing data
+    PurgeComm(m_handle, PURGE_RXCLEAR);
+    PurgeComm(m_writeHandle, PURGE_TXCLEAR);
+
+    m_rxRing.reset();
+    m_droppedBytes = 0;
+    runOnIoThread([this]() { startReading(); }, true);
+
+    m_isOpen = true;
+    m_isDualMode = true;
+    m_errorString.clear();
+    return true;
+}
+
+void SerialPort::close()
+{
+    if (m_isOpen) {
+        // Anything still queued is reported through writeFailed()
+        runOnIoThread([this]() {
+            stopReading();
+            failWrites("Serial port closed", false);
+        }, true);
+        if (m_handle != INVALID_HANDLE_VALUE) {
+            CloseHandle(m_handle);
+            m_handle = INVALID_HANDLE_VALUE;
+        }
+        if (m_writeHandle != INVALID_HANDLE_VALUE) {
+            CloseHandle(m_writeHandle);
+            m_writeHandle = INVALID_HANDLE_VALUE;
+        }
+        m_isOpen = false;
+        m_isDualMode = false;
+    }
+}
+
+bool SerialPort::isOpen() const
+{
+    return m_isOpen && m_handle != INVALID_HANDLE_VALUE;
+}
+
+HANDLE SerialPort::writeHandle() const
+{
+    return m_writeHandle != INVALID_HANDLE_VALUE ? m_writeHandle : m_handle;
+}
+
+void SerialPort::startReading()
+{
+    m_readOverlapped = OVERLAPPED();
+    m_writeOverlapped = OVERLAPPED();
+    m_drainOverlapped = OVERLAPPED();
+    m_readOverlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    m_writeOverlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    m_drainOverlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+    m_readNotifier = new QWinEventNotifier(m_readOverlapped.hEvent, m_ioContext);
+    connect(m_readNotifier, &QWinEventNotifier::activated, m_ioContext, [this]() { readPending(); });
+
+    // Only enabled while an overlapped write is pending
+    m_writeNotifier = new QWinEventNotifier(m_writeOverlapped.hEvent, m_ioContext);
+    m_writeNotifier->setEnabled(false);
+    connect(m_writeNotifier, &QWinEventNotifier::activated, m_ioContext, [this]() {
+        m_writeNotifier->setEnabled(false);
+        DWORD written = 0;
+        if (!GetOverlappedResult(writeHandle(), &m_writeOverlapped, &written, FALSE) || written == 0) {
+            failWrites("Failed to write to serial port", true);
+            return;
+        }
+        completeChunk(written);
+        pumpWrites();
+    });
+
+    SetCommMask(m_handle, EV_RXCHAR);
+    while (armCommEvent() && drainInput()) {
+        // Data was already queued; keep draining until the wait goes pending
+    }
+}
+
+void SerialPort::stopReading()
+{
+    // Complete the pending WaitCommEvent and cancel outstanding writes, then
+    // wait so the kernel is done with the OVERLAPPED structures
+    SetCommMask(m_handle, 0);
+    CancelIo(m_handle);
+    if (m_writeHandle != INVALID_HANDLE_VALUE) {
+        CancelIo(m_writeHandle);
+    }
+    DWORD unused = 0;
+    GetOverlappedResult(m_handle, &m_readOverlapped, &unused, TRUE);
+    GetOverlappedResult(writeHandle(), &m_writeOverlapped, &unused, TRUE);
+
+    delete m_readNotifier;
+    m_readNotifier = nullptr;
+    delete m_writeNotifier;
+    m_writeNotifier = nullptr;
+
+    CloseHandle(m_readOverlapped.hEvent);
+    CloseHandle(m_writeOverlapped.hEvent);
+    CloseHandle(m_drainOverlapped.hEvent);
+    m_readOverlapped = OVERLAPPED();
+    m_writeOverlapped = OVERLAPPED();
+    m_drainOverlapped = OVERLAPPED();
+}
+
+void SerialPort::readPending()
+{
+    // WaitCommEvent completed: drain the driver queue and re-arm
+    DWORD unused = 0;
+    if (!GetOverlappedResult(m_handle, &m_readOverlapped, &unused, FALSE)) {
+        m_readNotifier->setEnabled(false);
+        postError("Failed to wait for serial port events");
+        return;
+    }
+
+    if (drainInput()) {
+        while (armCommEvent() && drainInput()) {
+        }
+    }
+}
+
+bool SerialPort::armCommEvent()
+{
+    // Returns true if the wait completed immediately and input needs draining
+    ResetEvent(m_readOverlapped.hEvent);
+    if (WaitCommEvent(m_handle, &m_commEvents, &m_readOverlapped)) {
+        return true;
+    }
+    if (GetLastError() != ERROR_IO_PENDING) {
+        m_readNotifier->setEnabled(false);
+        postError("Failed to wait for serial port events");
+    }
+    return false;
+}
+
+bool SerialPort::drainInput()
+{
+    const DWORD maxChunkSize = 8192; // 8KB chunks for better line integrity
+    char buffer[maxChunkSize];
+
+    while (true) {
+        // Check how much data is available
+        DWORD errors;
+        COMSTAT stat;
+        if (!ClearCommError(m_handle, &errors, &stat)) {
+            m_readNotifier->setEnabled(false);
+            postError("Failed to query serial port status");
+            return false;
+        }
+
+        if (stat.cbInQue == 0) {
+            return true;
+        }
+
+        // With the zero read timeouts this completes at once
+        DWORD bytesToRead = (stat.cbInQue > maxChunkSize) ? maxChunkSize : stat.cbInQue;
+        DWORD bytesRead = 0;
+        if ((!ReadFile(m_handle, buffer, bytesToRead, nullptr, &m_drainOverlapped)
+             && GetLastError() != ERROR_IO_PENDING)
+            || !GetOverlappedResult(m_handle, &m_drainOverlapped, &bytesRead, TRUE)) {
+            m_readNotifier->setEnabled(false);
+            postError("Failed to read from serial port");
+            return false;
+        }
+
+        if (bytesRead == 0) {
+            return true;
+        }
+        deliverReceived(buffer, static_cast<qint64>(bytesRead));
+    }
+}
+
+qint64 SerialPort::startWrite(const char *data, qint64 size, QString *error)
+{
+    HANDLE handle = writeHandle();
+    if (!WriteFile(handle, data, static_cast<DWORD>(size), nullptr, &m_writeOverlapped)) {
+        if (GetLastError() == ERROR_IO_PENDING) {
+            m_writeNotifier->setEnabled(true);
+            return 0;
+        }
+        *error = "Failed to write to serial port";
+        return -1;
+    }
+
+    // Completed synchronously
+    DWORD written = 0;
+    if (!GetOverlappedResult(handle, &m_writeOverlapped, &written, FALSE) || written == 0) {
+        *error = "Write to serial port timed out";
+        return -1;
+    }
+    return static_cast<qint64>(written);
+}
@@ -0,0 +1,67 @@
+#include "sessionmanager.h"
+#include "devicesession.h"
+#include "iothreadpool.h"
+
+SessionManager::SessionManager(int ioThreads, QObject *parent)
+    : QObject(parent)
+    , m_ioPool(new IoThreadPool(ioThreads))
+{
+}
+
+SessionManager::~SessionManager()
+{
+    // Sessions hand their threads back before the pool stops them. That
+    // includes removed ones whose deleteLater() hasn't run yet, which are
+    // still children here
+    qDeleteAll(findChildren<DeviceSession *>(QString(), Qt::FindDirectChildrenOnly));
+    m_sessions.clear();
+    delete m_ioPool;
+}
+
+DeviceSession *SessionManager::session(const QString &portName)
+{
+    DeviceSession *session = m_sessions.value(portName);
+    if (!session) {
+        session = new DeviceSession(portName, m_ioPool, this);
+        m_sessions.insert(portName, session);
+        emit sessionAdded(session);
+    }
+    return session;
+}
+
+DeviceSession *SessionManager::findSession(const QString &portName) const
+{
+    return m_sessions.value(portName);
+}
+
+void SessionManager::removeSession(const QString &portName)
+{
+    DeviceSession *session = m_sessions.take(portName);
+    if (!session) {
+        return;
+    }
+    session->close();
+    emit sessionRemoved(portName);
+    session->deleteLater(); // May be called from one of its own signals
+}
+
+QList<DeviceSession *> SessionManager::sessions() const
+{
+    return m_sessions.values();
+}
+
+int SessionManager::openCount() const
+{
+    int count = 0;
+    for (DeviceSession *session : m_sessions) {
+        if (session->isOpen()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+IoThreadPool *SessionManager::ioPool() const
+{
+    return m_ioPool;
+}
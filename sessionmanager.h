@@ -0,0 +1,46 @@
+#ifndef SESSIONMANAGER_H
+#define SESSIONMANAGER_H
+
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QString>
+
+class DeviceSession;
+class IoThreadPool;
+
+// The boards one process is working with, one DeviceSession per port. All
+// their ports share one IoThreadPool, so N boards cost a few threads and
+// one event loop rather than N processes, each with its own.
+class SessionManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    // ioThreads 0 = IoThreadPool::defaultMaxThreads()
+    explicit SessionManager(int ioThreads = 0, QObject *parent = nullptr);
+    ~SessionManager();
+
+    // The session for portName, created (closed) if there is none yet
+    DeviceSession *session(const QString &portName);
+    DeviceSession *findSession(const QString &portName) const;
+    // Closes the port and deletes the session
+    void removeSession(const QString &portName);
+
+    QList<DeviceSession *> sessions() const; // By port name
+    int openCount() const;
+
+    // For ports outside any session (e.g. the main window's) that should
+    // share the same threads
+    IoThreadPool *ioPool() const;
+
+signals:
+    void sessionAdded(DeviceSession *session);
+    void sessionRemoved(const QString &portName);
+
+private:
+    IoThreadPool *m_ioPool;
+    QMap<QString, DeviceSession *> m_sessions;
+};
+
+#endif // SESSIONMANAGER_H
@@ -0,0 +1,187 @@
+#include "sessionview.h"
+#include <QAction>
+#include <QApplication>
+#include <QClipboard>
+#include <QDateTime>
+#include <QHBoxLayout>
+#include <QInputDialog>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListView>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QSplitter>
+#include <QVBoxLayout>
+#include <algorithm>
+#include "devicesession.h"
+#include "loginsession.h"
+#include "loglistmodel.h"
+
+SessionView::SessionView(DeviceSession *session, UpdateBatcher *batcher, QWidget *parent)
+    : QWidget(parent)
+    , m_session(session)
+    , m_logStore(MAX_LOG_LINES)
+    , m_commandStore(MAX_COMMAND_LINES)
+    , m_logModel(new LogListModel(&m_logStore, "hh:mm:ss.zzz", batcher, this))
+    , m_commandModel(new LogListModel(&m_commandStore, "[hh:mm:ss]", batcher, this))
+    , m_following(true)
+{
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    QHBoxLayout *controlLayout = new QHBoxLayout;
+    m_statusLabel = new QLabel;
+    controlLayout->addWidget(m_statusLabel, 1);
+    m_loginButton = new QPushButton("Login");
+    controlLayout->addWidget(m_loginButton);
+    m_closeButton = new QPushButton("Close");
+    m_closeButton->setToolTip("Disconnect and close this device's tab");
+    controlLayout->addWidget(m_closeButton);
+    layout->addLayout(controlLayout);
+
+    QSplitter *splitter = new QSplitter(Qt::Vertical);
+    m_logView = createLogView(m_logModel);
+    splitter->addWidget(m_logView);
+
+    QWidget *commandPane = new QWidget;
+    QVBoxLayout *commandLayout = new QVBoxLayout(commandPane);
+    commandLayout->setContentsMargins(0, 0, 0, 0);
+    QHBoxLayout *inputLayout = new QHBoxLayout;
+    m_commandInput = new QLineEdit;
+    m_commandInput->setPlaceholderText("Enter shell command...");
+    inputLayout->addWidget(m_commandInput);
+    m_sendButton = new QPushButton("Send");
+    m_sendButton->setFixedWidth(60);
+    inputLayout->addWidget(m_sendButton);
+    commandLayout->addLayout(inputLayout);
+    m_commandView = createLogView(m_commandModel);
+    m_commandView->setMinimumHeight(120);
+    m_commandView->setStyleSheet("QListView { background-color: #f8f8f8; }");
+    commandLayout->addWidget(m_commandView);
+    splitter->addWidget(commandPane);
+    splitter->setStretchFactor(0, 3);
+    splitter->setStretchFactor(1, 1);
+    layout->addWidget(splitter);
+
+    connect(m_commandInput, &QLineEdit::returnPressed, this, &SessionView::sendCommand);
+    connect(m_sendButton, &QPushButton::clicked, this, &SessionView::sendCommand);
+    connect(m_loginButton, &QPushButton::clicked, this, &SessionView::login);
+    connect(m_closeButton, &QPushButton::clicked, this, &SessionView::closeRequested);
+
+    // Follow new output unless the user scrolled up
+    connect(m_logView->verticalScrollBar(), &QScrollBar::valueChanged, this, [this](int value) {
+        m_following = value >= m_logView->verticalScrollBar()->maximum();
+    });
+    connect(m_logModel, &LogListModel::rowsFlushed, this, [this]() {
+        if (m_following) {
+            m_logView->scrollToBottom();
+        }
+    });
+    connect(m_commandModel, &LogListModel::rowsFlushed, m_commandView, &QListView::scrollToBottom);
+
+    connect(m_session, &DeviceSession::linesReceived, this, &SessionView::appendLines);
+    connect(m_session, &DeviceSession::message, this, &SessionView::appendMessage);
+    connect(m_session, &DeviceSession::opened, this, &SessionView::updateStatus);
+    connect(m_session, &DeviceSession::closed, this, &SessionView::updateStatus);
+    connect(m_session->login(), &LoginSession::loggedIn, this, &SessionView::updateStatus);
+    connect(m_session->login(), &LoginSession::loginTimedOut, this, &SessionView::updateStatus);
+    updateStatus();
+}
+
+DeviceSession *SessionView::session() const
+{
+    return m_session;
+}
+
+QListView *SessionView::createLogView(LogListModel *model)
+{
+    // Same setup as the main window's panes
+    QListView *view = new QListView;
+    view->setModel(model);
+    view->setFont(QFont("Consolas", 9));
+    view->setUniformItemSizes(true);
+    view->setWordWrap(false);
+    view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    view->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    view->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+
+    QAction *copyAction = new QAction("Copy", view);
+    copyAction->setShortcut(QKeySequence::Copy);
+    copyAction->setShortcutContext(Qt::WidgetShortcut);
+    view->addAction(copyAction);
+    view->setContextMenuPolicy(Qt::ActionsContextMenu);
+    connect(copyAction, &QAction::triggered, view, [view, model]() {
+        QModelIndexList selected = view->selectionModel()->selectedRows();
+        std::sort(selected.begin(), selected.end());
+        QStringList lines;
+        for (const QModelIndex &index : selected) {
+            lines.append(model->rowText(index.row()));
+        }
+        QApplication::clipboard()->setText(lines.join('\n'));
+    });
+
+    return view;
+}
+
+void SessionView::appendLines(const QStringList &logLines, const QStringList &commandLines)
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (!logLines.isEmpty()) {
+        m_logModel->append(logLines.join('\n'), now);
+    }
+    if (!commandLines.isEmpty()) {
+        m_commandModel->append(commandLines.join('\n').trimmed(), now);
+    }
+}
+
+void SessionView::appendMessage(const QString &text, const QString &prefix)
+{
+    m_logModel->append(QString(prefix + text), QDateTime::currentMSecsSinceEpoch());
+}
+
+void SessionView::sendCommand()
+{
+    const QString command = m_commandInput->text().trimmed();
+    if (command.isEmpty() || !m_session->isOpen()) {
+        return;
+    }
+
+    if (LoginSession::isLoginRequired(command) && !m_session->login()->isLoggedIn()) {
+        appendMessage(QString("'%1' needs a login first").arg(command), "[WARNING] ");
+        return;
+    }
+
+    if (m_session->sendCommand(command)) {
+        m_commandModel->append(QString("> %1").arg(command), QDateTime::currentMSecsSinceEpoch());
+        m_commandInput->clear();
+    } else {
+        appendMessage(QString("Failed to send command: %1").arg(m_session->errorString()), "[ERROR] ");
+    }
+}
+
+void SessionView::login()
+{
+    bool ok = false;
+    const QString password = QInputDialog::getText(this, "Login",
+        QString("Password for %1:").arg(m_session->portName()), QLineEdit::Password, QString(), &ok);
+    if (ok && !password.isEmpty()) {
+        m_session->login()->login(password);
+    }
+}
+
+void SessionView::updateStatus()
+{
+    const bool open = m_session->isOpen();
+    const bool loggedIn = m_session->login()->isLoggedIn();
+    if (!open) {
+        m_statusLabel->setText(QString("%1: disconnected").arg(m_session->portName()));
+        m_statusLabel->setStyleSheet("color: red;");
+    } else {
+        m_statusLabel->setText(QString("%1 @ %2 baud%3").arg(m_session->portName())
+                                   .arg(m_session->baudRate())
+                                   .arg(loggedIn ? QString(" - logged in") : QString()));
+        m_statusLabel->setStyleSheet("color: green;");
+    }
+    m_loginButton->setEnabled(open && !loggedIn);
+    m_sendButton->setEnabled(open);
+    m_commandInput->setEnabled(open);
+}
@@ -0,0 +1,60 @@
+#ifndef SESSIONVIEW_H
+#define SESSIONVIEW_H
+
+#include <QWidget>
+#include "logstore.h"
+
+QT_BEGIN_NAMESPACE
+class QLabel;
+class QLineEdit;
+class QListView;
+class QPushButton;
+QT_END_NAMESPACE
+
+class DeviceSession;
+class LogListModel;
+class UpdateBatcher;
+
+// One tab per additional board: its log, a command line with the output
+// below it, and login/connect controls. Repaints ride on the main window's
+// UpdateBatcher, so more tabs don't mean more refresh timers.
+class SessionView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    SessionView(DeviceSession *session, UpdateBatcher *batcher, QWidget *parent = nullptr);
+
+    DeviceSession *session() const;
+
+    static const int MAX_LOG_LINES = 100000;
+    static const int MAX_COMMAND_LINES = 10000;
+
+signals:
+    // The tab's close button; the owner removes the session and the tab
+    void closeRequested();
+
+private:
+    QListView *createLogView(LogListModel *model);
+    void appendLines(const QStringList &logLines, const QStringList &commandLines);
+    void appendMessage(const QString &text, const QString &prefix);
+    void sendCommand();
+    void login();
+    void updateStatus();
+
+    DeviceSession *m_session;
+    LogStore m_logStore;
+    LogStore m_commandStore;
+    LogListModel *m_logModel;
+    LogListModel *m_commandModel;
+    QListView *m_logView;
+    QListView *m_commandView;
+    QLabel *m_statusLabel;
+    QLineEdit *m_commandInput;
+    QPushButton *m_sendButton;
+    QPushButton *m_loginButton;
+    QPushButton *m_closeButton;
+    bool m_following; // Log view scrolled to the bottom
+};
+
+#endif // SESSIONVIEW_H
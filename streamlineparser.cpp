@@ -0,0 +1,280 @@
+#include "streamlineparser.h"
+#include <cstring>
+
+namespace {
+
+const char ESC = 0x1B;
+const char BEL = 0x07;
+
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+bool isUpper(char c)
+{
+    return c >= 'A' && c <= 'Z';
+}
+
+bool isIdentChar(char c)
+{
+    return isDigit(c) || (c >= 'a' && c <= 'z') || isUpper(c) || c == '_' || c == '-';
+}
+
+bool isSpace(char c)
+{
+    return c == ' ';
+}
+
+bool endsWith(const QByteArray &line, const char *suffix, qsizetype length)
+{
+    return line.size() >= length && memcmp(line.constData() + line.size() - length, suffix, length) == 0;
+}
+
+bool endsWithPrompt(const QByteArray &line)
+{
+    return endsWith(line, "uart:~$", 7) || endsWith(line, "dev>", 4) || endsWith(line, "login>", 6);
+}
+
+// Length of an ESC-less colour/cursor remnant starting at '[' (e.g. "[1;33m"
+// or "[8D[J" when the ESC byte got lost), or 0 if there is none
+qsizetype bareCsiLength(const char *p, qsizetype n)
+{
+    qsizetype i = 1;
+    while (i < n && (isDigit(p[i]) || p[i] == ';')) {
+        ++i;
+    }
+    if (i >= n) {
+        return 0;
+    }
+    if (p[i] == 'm') {
+        return i + 1;
+    }
+    if (!isUpper(p[i]) || i + 1 >= n || p[i + 1] != '[') {
+        return 0;
+    }
+    // Cursor moves come in pairs like [8D[J
+    qsizetype j = i + 2;
+    while (j < n && isDigit(p[j])) {
+        ++j;
+    }
+    if (j < n && isUpper(p[j])) {
+        return j + 1;
+    }
+    return 0;
+}
+
+// Length of a shell prompt starting at p[0] (without trailing spaces), or 0
+qsizetype literalPromptLength(const char *p, qsizetype n)
+{
+    static const struct { const char *text; qsizetype length; } prompts[] = {
+        { "uart:~$", 7 },
+        { "uart:~", 6 },
+        { "login>", 6 },
+        { "dev>", 4 },
+    };
+    for (const auto &prompt : prompts) {
+        if (n >= prompt.length && memcmp(p, prompt.text, prompt.length) == 0) {
+            return prompt.length;
+        }
+    }
+    return 0;
+}
+
+// Removes stray colour remnants and shell prompts from a completed line.
+// Runs once per line, so it stays linear in the line length.
+QByteArray cleanLine(const QByteArray &line)
+{
+    QByteArray out;
+    out.reserve(line.size());
+
+    const char *p = line.constData();
+    const qsizetype n = line.size();
+    qsizetype i = 0;
+    while (i < n) {
+        if (p[i] == '[') {
+            const qsizetype skip = bareCsiLength(p + i, n - i);
+            if (skip > 0) {
+                i += skip;
+                continue;
+            }
+        }
+
+        qsizetype prompt = literalPromptLength(p + i, n - i);
+        if (prompt == 0 && p[i] == ':' && !out.isEmpty() && isIdentChar(out.back())) {
+            // Generic "name:~$" / "name:$" prompts
+            if (i + 1 < n && p[i + 1] == '$') {
+                prompt = 2;
+            } else if (i + 2 < n && p[i + 1] == '~' && p[i + 2] == '$') {
+                prompt = 3;
+            }
+            if (prompt > 0) {
+                while (!out.isEmpty() && isIdentChar(out.back())) {
+                    out.chop(1);
+                }
+            }
+        }
+        if (prompt > 0) {
+            i += prompt;
+            while (i < n && isSpace(p[i])) {
+                ++i;
+            }
+            continue;
+        }
+
+        out.append(p[i]);
+        ++i;
+    }
+
+    out = out.trimmed();
+
+    // Shell line-start marker: a lone 'x' or 'x' before a space/timestamp
+    if (!out.isEmpty() && out.at(0) == 'x'
+        && (out.size() == 1 || out.at(1) == ' ' || out.at(1) == '[')) {
+        out = out.mid(1).trimmed();
+    }
+
+    return out;
+}
+
+} // namespace
+
+StreamLineParser::StreamLineParser(qsizetype maxLineLength)
+    : m_state(Text)
+    , m_lastWasCr(false)
+    , m_maxLineLength(maxLineLength)
+    , m_promptCount(0)
+{
+}
+
+void StreamLineParser::feed(const QByteArray &data, QStringList &lines)
+{
+    feed(data.constData(), data.size(), lines);
+}
+
+void StreamLineParser::feed(const char *data, qsizetype size, QStringList &lines)
+{
+    for (qsizetype i = 0; i < size; ++i) {
+        const char c = data[i];
+
+        switch (m_state) {
+        case Escape:
+            if (c == '[') {
+                m_state = Csi;
+            } else if (c == ']') {
+                m_state = Osc;
+            } else if (c == '(' || c == ')') {
+                m_state = EscCharset;
+            } else {
+                m_state = Text; // Two-byte escape like ESC 7 / ESC M
+            }
+            continue;
+
+        case EscCharset:
+            m_state = Text;
+            continue;
+
+        case Csi:
+            if (c >= 0x20 && c <= 0x3F) {
+                continue; // Parameter and intermediate bytes
+            }
+            m_state = Text;
+            if (c >= 0x40 && c <= 0x7E) {
+                continue; // Final byte
+            }
+            break; // Malformed sequence: treat the byte as text
+
+        case Osc:
+            if (c == BEL) {
+                m_state = Text;
+            } else if (c == ESC) {
+                m_state = OscEscape;
+            }
+            continue;
+
+        case OscEscape:
+            m_state = c == '\\' ? Text : Osc;
+            continue;
+
+        case Text:
+            break;
+        }
+
+        // Text state
+        if (c == '\n') {
+            if (!m_lastWasCr) {
+                endLine(lines);
+            }
+            m_lastWasCr = false;
+            continue;
+        }
+        m_lastWasCr = false;
+
+        if (c == '\r') {
+            endLine(lines);
+            m_lastWasCr = true;
+        } else if (c == ESC) {
+            m_state = Escape;
+        } else if (c >= 32 && c < 127) {
+            m_line.append(c);
+            if (c == '$' || c == '>') {
+                checkPrompt();
+            }
+            if (m_line.size() >= m_maxLineLength) {
+                endLine(lines);
+            }
+        }
+        // Other control characters and non-ASCII bytes are dropped
+    }
+}
+
+void StreamLineParser::flush(QStringList &lines)
+{
+    endLine(lines);
+}
+
+bool StreamLineParser::hasPartialLine() const
+{
+    return !m_line.isEmpty();
+}
+
+quint64 StreamLineParser::promptCount() const
+{
+    return m_promptCount;
+}
+
+bool StreamLineParser::atPrompt() const
+{
+    qsizetype end = m_line.size();
+    while (end > 0 && m_line.at(end - 1) == ' ') {
+        --end;
+    }
+    return end > 0 && endsWithPrompt(m_line.left(end)) && cleanLine(m_line).isEmpty();
+}
+
+void StreamLineParser::reset()
+{
+    m_state = Text;
+    m_line.clear();
+    m_lastWasCr = false;
+}
+
+void StreamLineParser::endLine(QStringList &lines)
+{
+    if (m_line.isEmpty()) {
+        return;
+    }
+
+    const QByteArray cleaned = cleanLine(m_line);
+    if (!cleaned.isEmpty()) {
+        lines.append(QString::fromLatin1(cleaned));
+    }
+    m_line.truncate(0); // Keep the allocation for the next line
+}
+
+void StreamLineParser::checkPrompt()
+{
+    if (endsWithPrompt(m_line)) {
+        ++m_promptCount;
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef STREAMLINEPARSER_H
+#define STREAMLINEPARSER_H
+
+#include <QByteArray>
+#include <QStringList>
+
+// Resumable byte-level parser for the device's terminal stream. Each byte
+// is looked at once: ANSI CSI/OSC sequences are dropped (even when split
+// across reads), CR, LF and CRLF all end a line, control and non-ASCII
+// bytes are discarded and shell prompts are stripped when a line completes.
+// Cost is O(bytes fed) no matter how slowly a long line dribbles in.
+class StreamLineParser
+{
+public:
+    explicit StreamLineParser(qsizetype maxLineLength = 65536);
+
+    // Consumes new bytes and appends any completed, non-empty lines
+    void feed(const char *data, qsizetype size, QStringList &lines);
+    void feed(const QByteArray &data, QStringList &lines);
+
+    // Emits the buffered partial line, e.g. when no newline arrived in time
+    void flush(QStringList &lines);
+    bool hasPartialLine() const;
+
+    // Number of shell prompts (uart:~$, dev>, login>) seen so far; a new
+    // prompt means the device finished the previous command
+    quint64 promptCount() const;
+    // The partial line is nothing but a prompt: the device is idle, waiting
+    // for the next command
+    bool atPrompt() const;
+
+    void reset();
+
+private:
+    enum State {
+        Text,
+        Escape,      // After ESC
+        EscCharset,  // ESC ( or ESC ) - one designator byte follows
+        Csi,         // ESC [ params... final
+        Osc,         // ESC ] ... terminated by BEL or ST
+        OscEscape    // ESC inside OSC, expecting '\'
+    };
+
+    void endLine(QStringList &lines);
+    void checkPrompt();
+
+    State m_state;
+    QByteArray m_line;
+    bool m_lastWasCr;
+    qsizetype m_maxLineLength;
+    quint64 m_promptCount;
+};
+
+#endif // STREAMLINEPARSER_H
@@ -0,0 +1,72 @@
+#include "updatebatcher.h"
+#include <QTimer>
+
+UpdateBatcher::UpdateBatcher(int intervalMs, QObject *parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+    , m_pendingLines(0)
+    , m_repaints(0)
+    , m_lines(0)
+    , m_maxLines(0)
+{
+    // Single shot and only started by the first pending line, so an idle
+    // UI costs no wakeups
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(intervalMs);
+    connect(m_timer, &QTimer::timeout, this, &UpdateBatcher::flush);
+}
+
+void UpdateBatcher::addPending(int lines)
+{
+    m_pendingLines += lines;
+    if (!m_timer->isActive()) {
+        m_timer->start();
+    }
+}
+
+void UpdateBatcher::setInterval(int intervalMs)
+{
+    m_timer->setInterval(qMax(1, intervalMs));
+}
+
+int UpdateBatcher::interval() const
+{
+    return m_timer->interval();
+}
+
+quint64 UpdateBatcher::repaintCount() const
+{
+    return m_repaints;
+}
+
+quint64 UpdateBatcher::lineCount() const
+{
+    return m_lines;
+}
+
+double UpdateBatcher::linesPerRepaint() const
+{
+    return m_repaints > 0 ? double(m_lines) / m_repaints : 0.0;
+}
+
+int UpdateBatcher::maxLinesPerRepaint() const
+{
+    return m_maxLines;
+}
+
+void UpdateBatcher::resetStats()
+{
+    m_repaints = 0;
+    m_lines = 0;
+    m_maxLines = 0;
+}
+
+void UpdateBatcher::flush()
+{
+    ++m_repaints;
+    m_lines += m_pendingLines;
+    m_maxLines = qMax(m_maxLines, m_pendingLines);
+    m_pendingLines = 0;
+
+    emit flushRequested();
+}
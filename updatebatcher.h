@@ -0,0 +1,47 @@
+#ifndef UPDATEBATCHER_H
+#define UPDATEBATCHER_H
+
+#include <QObject>
+
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
+// Coalesces view updates: producers report pending lines with addPending()
+// and flushRequested() fires at most once per interval, however many lines
+// arrived in between. Keeps a "lines per repaint" tally to show how well
+// bursts are being absorbed.
+class UpdateBatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UpdateBatcher(int intervalMs = DEFAULT_INTERVAL_MS, QObject *parent = nullptr);
+
+    void addPending(int lines);
+
+    void setInterval(int intervalMs);
+    int interval() const;
+
+    quint64 repaintCount() const;
+    quint64 lineCount() const;
+    double linesPerRepaint() const;
+    int maxLinesPerRepaint() const;
+    void resetStats();
+
+    static const int DEFAULT_INTERVAL_MS = 16; // ~60 Hz
+
+signals:
+    void flushRequested();
+
+private:
+    void flush();
+
+    QTimer *m_timer;
+    int m_pendingLines;
+    quint64 m_repaints;
+    quint64 m_lines;
+    int m_maxLines;
+};
+
+#endif // UPDATEBATCHER_H